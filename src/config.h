@@ -33,9 +33,30 @@
 #define GLIMMER_MONOSPACE_FONTFAMILY "monospace-family"
 #endif
 
-// Maximum instances of each type of widgets that can be created in a frame
-#ifndef GLIMMER_TOTAL_ID_SIZE
-#define GLIMMER_TOTAL_ID_SIZE (1 << 16)
+// Bytes in each page of the arena which stores string ids of widgets
+#ifndef GLIMMER_ID_STRING_PAGE_SZ
+#define GLIMMER_ID_STRING_PAGE_SZ 4096
+#endif
+
+// String and pointer ids (and their widget state) unused for these many frames are reclaimed, 0 keeps ids forever
+#ifndef GLIMMER_ID_RECLAIM_FRAMES
+#define GLIMMER_ID_RECLAIM_FRAMES 3600
+#endif
+
+// Widget states of each type allocated at a time by nested contexts (popups, drop-downs, item grids)
+#ifndef GLIMMER_NESTED_CONTEXT_WIDGETS
+#define GLIMMER_NESTED_CONTEXT_WIDGETS 4
+#endif
+
+// Nested contexts not pushed for these many frames are reset and pooled for reuse, losing their
+// widget state, 0 never pools them
+#ifndef GLIMMER_NESTED_CONTEXT_RECLAIM_FRAMES
+#define GLIMMER_NESTED_CONTEXT_RECLAIM_FRAMES 600
+#endif
+
+// Points in each bucket of the finest min/max level kept by chart series
+#ifndef GLIMMER_CHART_PYRAMID_BUCKET
+#define GLIMMER_CHART_PYRAMID_BUCKET 8
 #endif
 
 // Maximum number of regions in a splitter
@@ -68,6 +89,94 @@
 #define GLIMMER_MAX_REGION_NESTING 8
 #endif
 
+// Initial size of linear arena used for per-frame layout data (grows as needed)
+#ifndef GLIMMER_FRAME_ARENA_BLOCKSZ
+#define GLIMMER_FRAME_ARENA_BLOCKSZ (1 << 16)
+#endif
+
+// Maximum number of worker threads used for data-parallel work (sorting, aggregates, etc.)
+#ifndef GLIMMER_MAX_WORKER_THREADS
+#define GLIMMER_MAX_WORKER_THREADS 4
+#endif
+
+// Minimum number of rows in an ItemGrid before the built-in sort engine sorts on worker threads
+#ifndef GLIMMER_PARALLEL_SORT_THRESHOLD
+#define GLIMMER_PARALLEL_SORT_THRESHOLD (1 << 15)
+#endif
+
+// Minimum number of rows in an ItemGrid before epilogue aggregates are rebuilt on worker threads
+#ifndef GLIMMER_PARALLEL_AGGREGATE_THRESHOLD
+#define GLIMMER_PARALLEL_AGGREGATE_THRESHOLD (1 << 15)
+#endif
+
+// Minimum number of rows to filter before the ItemGrid filter engine runs in background
+#ifndef GLIMMER_BACKGROUND_FILTER_THRESHOLD
+#define GLIMMER_BACKGROUND_FILTER_THRESHOLD (1 << 14)
+#endif
+
+// Number of rows for which formatted cells of ItemGrid's columnar data source are cached,
+// and maximum length of a formatted number/timestamp
+#ifndef GLIMMER_ITEMGRID_FORMAT_CACHE_ROWS
+#define GLIMMER_ITEMGRID_FORMAT_CACHE_ROWS 256
+#endif
+
+#ifndef GLIMMER_ITEMGRID_FORMATTED_CELL_SZ
+#define GLIMMER_ITEMGRID_FORMATTED_CELL_SZ 40
+#endif
+
+// Number of data rows for which text extents of ItemGrid cells are cached, when row versions are provided
+#ifndef GLIMMER_ITEMGRID_MEASURE_CACHE_ROWS
+#define GLIMMER_ITEMGRID_MEASURE_CACHE_ROWS 512
+#endif
+
+// Rows written per background task when exporting an ItemGrid, and size of buffered output.
+// Values of a data source are copied a batch per frame, while the grid is populated.
+#ifndef GLIMMER_ITEMGRID_EXPORT_BATCH_ROWS
+#define GLIMMER_ITEMGRID_EXPORT_BATCH_ROWS 4096
+#endif
+
+#ifndef GLIMMER_ITEMGRID_EXPORT_BUFFER_SZ
+#define GLIMMER_ITEMGRID_EXPORT_BUFFER_SZ (1 << 16)
+#endif
+
+// Maximum columns and total text length of a row of streaming ItemGrid, longer text is truncated
+#ifndef GLIMMER_ITEMGRID_STREAM_MAX_COLUMNS
+#define GLIMMER_ITEMGRID_STREAM_MAX_COLUMNS 16
+#endif
+
+#ifndef GLIMMER_ITEMGRID_STREAM_ROW_SZ
+#define GLIMMER_ITEMGRID_STREAM_ROW_SZ 256
+#endif
+
+// Memory (in bytes) of undo/redo history of each text input, oldest history is discarded beyond it
+#ifndef GLIMMER_TEXT_UNDO_MEMORY_LIMIT
+#define GLIMMER_TEXT_UNDO_MEMORY_LIMIT (1 << 18)
+#endif
+
+// Visible rows of a multi-line text input when no height is specified in style
+#ifndef GLIMMER_MULTILINE_INPUT_ROWS
+#define GLIMMER_MULTILINE_INPUT_ROWS 8
+#endif
+
+// Lines of a multi-line text input re-wrapped/re-measured per frame after a width change
+#ifndef GLIMMER_MULTILINE_REINDEX_BATCH
+#define GLIMMER_MULTILINE_REINDEX_BATCH 2048
+#endif
+
+// Options laid out at once in a drop-down popup, the rest are reached by scrolling or type-ahead
+#ifndef GLIMMER_DROPDOWN_MAX_VISIBLE_OPTIONS
+#define GLIMMER_DROPDOWN_MAX_VISIBLE_OPTIONS 12
+#endif
+
+// Type-ahead query length of drop-down, and idle seconds after which a (non-filtering) query resets
+#ifndef GLIMMER_DROPDOWN_TYPEAHEAD_SZ
+#define GLIMMER_DROPDOWN_TYPEAHEAD_SZ 32
+#endif
+
+#ifndef GLIMMER_DROPDOWN_TYPEAHEAD_TIMEOUT
+#define GLIMMER_DROPDOWN_TYPEAHEAD_TIMEOUT 1.f
+#endif
+
 #ifndef GLIMMER_MAX_OVERLAYS
 #define GLIMMER_MAX_OVERLAYS 32
 #endif
@@ -5,6 +5,10 @@
 #include "widgets.h"
 #include "libs/inc/implot/implot.h"
 #include <list>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
 
 #include "draw.h"
 #include "layout.h"
@@ -12,6 +16,7 @@
 namespace glimmer
 {
     static std::list<WidgetContextData> WidgetContexts;
+    static std::vector<WidgetContextData*> PooledContexts; // Reset nested contexts available for reuse
     static WidgetContextData* CurrentContext = nullptr;
     static ImPlotContext* ChartsContext = nullptr;
     static bool StartedRendering = false;
@@ -19,6 +24,9 @@ namespace glimmer
     static bool RemovePopupAtFrameExit = false;
     static int32_t IgnoreStyleStackBits = -1;
 
+    static void PoolUnusedContexts();
+    static void PoolNestedContext(WidgetContextData& context);
+
     void CopyStyle(const StyleDescriptor& src, StyleDescriptor& dest);
     void HandleRegionEvent(WidgetContextData& context, int32_t id, const ImRect& margin, const ImRect& border, const ImRect& padding,
         const ImRect& content, IRenderer& renderer, const IODescriptor& io, WidgetDrawResult& result);
@@ -58,6 +66,10 @@ namespace glimmer
         type = Layout::Invalid;
         id = specified = 0;
         fill = FD_None;
+        profileIdx = -1;
+        virtualGrid.totalRows = -1;
+        virtualGrid.firstRow = 0;
+        virtualGrid.rowHeight = 0.f;
         alignment = TextAlignLeading;
         from = -1, to = -1, itemidx = -1;
         currow = -1, currcol = -1;
@@ -82,11 +94,11 @@ namespace glimmer
             styleStartIdx[idx] = -1;
         }
 
-        itemIndexes.clear(true);
-        griditems.clear(true);
+        itemIndexes.release();
+        griditems.release();
         containerStack.clear(true);
-        rows.clear(true);
-        cols.clear(true);
+        rows.release();
+        cols.release();
     }
 
     void TabBarBuilder::reset()
@@ -118,6 +130,11 @@ namespace glimmer
         perDepthRowCount.clear(true);
         cellvals.clear(true);
         rowYs.clear(true);
+        rowOffset = 0.f;
+        virtualRows = false;
+        rowOrder = nullptr;
+        shownRows = 0;
+        treeRows = nullptr;
         clickedItem.row = clickedItem.col = clickedItem.depth = -1;
         resizecol = parentId = -1;
 		rowcount = 0;
@@ -272,6 +289,8 @@ namespace glimmer
             }
             
             context.ResetLayoutData();
+            context.layoutItems.release();
+            context.replayContent.release();
             context.maxids[WT_SplitterRegion] = 0;
             context.maxids[WT_Layout] = 0;
             context.maxids[WT_Charts] = 0;
@@ -284,7 +303,13 @@ namespace glimmer
             assert(context.layoutStack.empty());
         }
 
+        // All frame allocated containers are released by now
+        FrameMemory.reset();
+
         CurrentContext = &(*(WidgetContexts.begin()));
+        ++WidgetContextData::CurrentFrame;
+        ReclaimWidgetIds();
+        PoolUnusedContexts();
         auto rtpos = WidgetContextData::RightClickContext.pos;
         WidgetContextData::RightClickContext = UIElementDescriptor{};
         WidgetContextData::RightClickContext.pos = rtpos;
@@ -303,6 +328,7 @@ namespace glimmer
             WidgetContextData::PopupContext = nullptr;
         }
 
+        ResetLayoutProfile();
         if (Config.logger) Config.logger->ExitFrame();
     }
 
@@ -313,11 +339,13 @@ namespace glimmer
 
     int32_t WidgetContextData::GetNextCount(WidgetType type)
     {
-        auto count = maxids[type];
+        auto count = RecyclesIds(type) ? slots[type].acquire(CurrentFrame) : maxids[type];
 
         if (count == states[type].size())
         {
-            auto sz = Config.GetTotalWidgetCount ? Config.GetTotalWidgetCount(type) :
+            // Nested contexts usually host a few widgets, hence they grow geometrically from a small size
+            auto sz = parentContext != nullptr ? std::max<int>(GLIMMER_NESTED_CONTEXT_WIDGETS, (int)states[type].size()) :
+                Config.GetTotalWidgetCount ? Config.GetTotalWidgetCount(type) :
                 WidgetContextData::GetExpectedWidgetCount(type);
             states[type].reserve(states[type].size() + sz);
 
@@ -347,12 +375,7 @@ namespace glimmer
                     radioStates.emplace_back();
                 break;
             }
-            case WT_TextInput: {
-                inputTextStates.reserve(inputTextStates.size() + sz);
-                for (auto idx = 0; idx < sz; ++idx)
-                    inputTextStates.emplace_back();
-                break;
-            }
+            case WT_TextInput: inputTextStates.resize(inputTextStates.size() + sz); break;
             case WT_ToggleButton: {
                 toggleStates.reserve(toggleStates.size() + sz);
                 for (auto idx = 0; idx < sz; ++idx)
@@ -383,26 +406,255 @@ namespace glimmer
                     tabBarStates.emplace_back();
                 break;
             }
-            case WT_ItemGrid: {
-                gridStates.reserve(gridStates.size() + sz);
-                for (auto idx = 0; idx < sz; ++idx)
-                    gridStates.emplace_back();
-                break;
-            }
+            case WT_ItemGrid: gridStates.resize(gridStates.size() + sz); break;
+            case WT_DropDown: dropdownStates.resize(dropdownStates.size() + sz); break;
             case WT_Splitter: {
                 splitterStates.reserve(splitterStates.size() + sz);
                 for (auto idx = 0; idx < sz; ++idx)
                     splitterStates.emplace_back();
+                splitterScrollPaneParentIds.resize(splitterStates.size() * GLIMMER_MAX_SPLITTER_REGIONS, -1);
                 break;
             }
             default: break;
             }
         }
 
-        maxids[type]++;
+        maxids[type] = std::max(maxids[type], count + 1);
         return count;
     }
 
+    // Per-frame ids (layouts, splitter regions, charts) and ids of nested contexts are
+    // recounted every frame, hence only persistent widgets of the root context are recycled
+    bool WidgetContextData::RecyclesIds(WidgetType type) const
+    {
+        return parentContext == nullptr && type != WT_Layout && type != WT_SplitterRegion &&
+            type != WT_Charts;
+    }
+
+    template <typename T>
+    static void ResetPersistentState(std::vector<T>& states, int32_t index)
+    {
+        if (index < (int32_t)states.size())
+        {
+            states[index].~T();
+            ::new (&states[index]) T{};
+        }
+    }
+
+    // Reset all state of the widget and make its index available to GetNextCount again,
+    // any handle to the widget turns invalid. The id must not be used after this.
+    bool WidgetContextData::ReleaseId(int32_t id)
+    {
+        auto index = id & WidgetIndexMask;
+        auto type = (WidgetType)(id >> WidgetTypeBits);
+        if (type >= WT_TotalTypes || !RecyclesIds(type) || !slots[type].release(index)) return false;
+
+        auto& config = states[type][index];
+        config = WidgetConfigData{ type };
+        config.data = CommonWidgetData{};
+
+        if (index < WidgetStyles[type].size())
+            for (auto ws = 0; ws < WSI_Total; ++ws)
+                WidgetStyles[type][index][ws] = StyleDescriptor{};
+
+        switch (type)
+        {
+        case WT_ItemGrid: gridStates.reset(index); break;
+        case WT_TabBar: ResetPersistentState(tabBarStates, index); break;
+        case WT_NavDrawer: ResetPersistentState(navDrawerStates, index); break;
+        case WT_ToggleButton: ResetPersistentState(toggleStates, index); break;
+        case WT_RadioButton: ResetPersistentState(radioStates, index); break;
+        case WT_Checkbox: ResetPersistentState(checkboxStates, index); break;
+        case WT_TextInput: inputTextStates.reset(index); break;
+        case WT_Spinner: ResetPersistentState(spinnerStates, index); break;
+        case WT_DropDown: ResetPersistentState(dropdownStates, index); break;
+        case WT_Accordion: ResetPersistentState(accordionStates, index); break;
+        case WT_Splitter: {
+            ResetPersistentState(splitterStates, index);
+            auto from = index * GLIMMER_MAX_SPLITTER_REGIONS;
+            for (auto idx = from; idx < from + GLIMMER_MAX_SPLITTER_REGIONS &&
+                idx < (int32_t)splitterScrollPaneParentIds.size(); ++idx)
+                splitterScrollPaneParentIds[idx] = -1;
+            break;
+        }
+        default: break;
+        }
+
+        // Popup of a drop-down and the context of a grid are pooled with the widget
+        if (type < WT_TotalNestedContexts && index < (int32_t)nestedContexts[type].size() &&
+            nestedContexts[type][index] != nullptr)
+            PoolNestedContext(*nestedContexts[type][index]);
+
+        return true;
+    }
+
+    template <typename T>
+    static void ResetPersistentStates(std::vector<T>& states)
+    {
+        for (auto idx = 0; idx < (int32_t)states.size(); ++idx)
+            ResetPersistentState(states, idx);
+    }
+
+    // Reset a nested context to its initial state so that it can be reused for another popup,
+    // drop-down or grid. Containers are reset in place and keep their memory.
+    void WidgetContextData::Recycle()
+    {
+        for (auto type = 0; type < WT_TotalTypes; ++type)
+        {
+            for (auto& config : states[type])
+            {
+                config = WidgetConfigData{ (WidgetType)type };
+                config.data = CommonWidgetData{};
+            }
+
+            for (auto& styles : WidgetStyles[type])
+                for (auto ws = 0; ws < WSI_Total; ++ws)
+                    styles[ws] = StyleDescriptor{};
+
+            itemGeometries[type].reset(ImRect{});
+            maxids[type] = tempids[type] = 0;
+        }
+
+        // Destroying grid states abandons their running filter jobs and drops loaded tree children
+        gridStates.clear();
+        inputTextStates.clear();
+        ResetPersistentStates(toggleStates);
+        ResetPersistentStates(radioStates);
+        ResetPersistentStates(checkboxStates);
+        ResetPersistentStates(splitterStates);
+        ResetPersistentStates(spinnerStates);
+        ResetPersistentStates(dropdownStates);
+        ResetPersistentStates(tabBarStates);
+        ResetPersistentStates(navDrawerStates);
+        ResetPersistentStates(accordionStates);
+        std::fill(splitterScrollPaneParentIds.begin(), splitterScrollPaneParentIds.end(), -1);
+
+        for (auto& children : nestedContexts)
+            std::fill(children.begin(), children.end(), nullptr);
+
+        regionBuilders.clear(true);
+        regions.clear(true);
+        itemGrids.clear(true);
+        nestedContextStack.clear(true);
+        containerStack.clear(true);
+        splitterStack.clear(true);
+        accordions.clear(true);
+        adhocLayout.clear(true);
+        deferedEvents.clear(true);
+        lastLayoutIdx = -1;
+        usingDeferred = deferEvents = false;
+
+        popupSource = NestedContextSourceType::None;
+        popupOrigin = popupSize = ImVec2{ -1.f, -1.f };
+        popupRange = RendererEventIndexRange{};
+        for (auto idx = 0; idx < (int)PCB_Total; ++idx)
+        {
+            popupCallbacks[idx] = nullptr;
+            popupCallbackData[idx] = nullptr;
+        }
+        popupBgColor.reset();
+        popupFlags = 0;
+        popupTargetId = -1;
+        popupContext = nullptr;
+
+        parentContext = nullptr;
+        nestedId = -1;
+    }
+
+    // Only ids marked transient are released, i.e. ids looked up by name or pointer, as
+    // their lookup assigns a new id once the state is gone. Ids held by the user are not.
+    void WidgetContextData::ReleaseUnusedIds(int32_t frames)
+    {
+        for (auto type = 0; type < WT_TotalTypes; ++type)
+        {
+            if (!RecyclesIds((WidgetType)type)) continue;
+
+            // Released slots are swapped with the last live one, hence iterate backwards
+            auto& alloc = slots[type];
+            for (auto pos = alloc.size() - 1; pos >= 0; --pos)
+            {
+                auto index = alloc[pos];
+                if (alloc.unused(index, CurrentFrame, frames))
+                    ReleaseId(index | (type << WidgetTypeBits));
+            }
+        }
+    }
+
+    void WidgetContextData::MarkTransient(int32_t id)
+    {
+        auto type = (WidgetType)(id >> WidgetTypeBits);
+        if (type < WT_TotalTypes && RecyclesIds(type)) slots[type].transient(id & WidgetIndexMask);
+    }
+
+    WidgetMemoryUsage WidgetContextData::MemoryUsage(WidgetType type) const
+    {
+        WidgetMemoryUsage usage;
+        usage.widgets = (int32_t)states[type].size();
+        usage.bytes = (int64_t)states[type].capacity() * (int64_t)sizeof(WidgetConfigData) +
+            (int64_t)WidgetStyles[type].capacity() * (int64_t)sizeof(StyleDescriptor[WSI_Total]);
+
+        auto persistent = [&usage](const auto& states) {
+            usage.bytes += (int64_t)states.capacity() * (int64_t)sizeof(states[0]);
+        };
+
+        auto lazy = [&usage](const auto& states) {
+            usage.allocated = states.allocated();
+            usage.bytes += (int64_t)states.size() * (int64_t)sizeof(void*);
+            states.forEach([&usage](const auto& state) { usage.bytes += (int64_t)sizeof(state) + state.memory(); });
+        };
+
+        switch (type)
+        {
+        case WT_ItemGrid: lazy(gridStates); break;
+        case WT_TextInput: lazy(inputTextStates); break;
+        case WT_TabBar: persistent(tabBarStates); break;
+        case WT_NavDrawer: persistent(navDrawerStates); break;
+        case WT_ToggleButton: persistent(toggleStates); break;
+        case WT_RadioButton: persistent(radioStates); break;
+        case WT_Checkbox: persistent(checkboxStates); break;
+        case WT_Spinner: persistent(spinnerStates); break;
+        case WT_DropDown: persistent(dropdownStates); break;
+        case WT_Accordion: persistent(accordionStates); break;
+        case WT_Splitter:
+            persistent(splitterStates);
+            persistent(splitterScrollPaneParentIds);
+            break;
+        default: break;
+        }
+
+        return usage;
+    }
+
+    WidgetMemoryUsage GetWidgetMemoryUsage(WidgetType type)
+    {
+        WidgetMemoryUsage total;
+
+        for (const auto& context : WidgetContexts)
+        {
+            auto usage = context.MemoryUsage(type);
+            total.widgets += usage.widgets;
+            total.allocated += usage.allocated;
+            total.bytes += usage.bytes;
+        }
+
+        return total;
+    }
+
+    WidgetHandle WidgetContextData::Handle(int32_t id) const
+    {
+        auto type = id >> WidgetTypeBits;
+        if (type >= WT_TotalTypes || !RecyclesIds((WidgetType)type)) return WidgetHandle{ id, 0 };
+        return WidgetHandle{ id, slots[type].handle(id & WidgetIndexMask).generation };
+    }
+
+    bool WidgetContextData::IsValid(WidgetHandle handle) const
+    {
+        auto type = handle.id >> WidgetTypeBits;
+        if (handle.id < 0 || type >= WT_TotalTypes) return false;
+        if (!RecyclesIds((WidgetType)type)) return (handle.id & WidgetIndexMask) < maxids[type];
+        return slots[type].valid({ handle.id & WidgetIndexMask, handle.generation });
+    }
+
     StyleDescriptor WidgetContextData::GetStyle(int32_t state)
     {
         auto style = log2((unsigned)state);
@@ -539,7 +791,8 @@ namespace glimmer
         {
             if (index >= itemGeometries[wtype].size())
             {
-                auto sz = std::max((int16_t)128, (int16_t)(index - itemGeometries[wtype].size() + 1));
+                auto step = parentContext != nullptr ? GLIMMER_NESTED_CONTEXT_WIDGETS : 128;
+                auto sz = std::max((int16_t)step, (int16_t)(index - itemGeometries[wtype].size() + 1));
                 itemGeometries[wtype].expand_and_create(sz, true);
             }
 
@@ -1022,7 +1275,8 @@ namespace glimmer
         }
     }
     
-    WidgetContextData::WidgetContextData()
+    WidgetContextData::WidgetContextData(WidgetContextData* parent)
+        : parentContext{ parent }
     {
         for (auto idx = 0; idx < WT_TotalTypes; ++idx)
         {
@@ -1031,7 +1285,8 @@ namespace glimmer
             if (idx != WT_Layout && idx != WT_Sublayout && idx != WT_Scrollable &&
                 idx != WT_SplitterRegion)
             {
-                auto count = Config.GetTotalWidgetCount ? Config.GetTotalWidgetCount((WidgetType)idx) : 
+                auto count = parent != nullptr ? GLIMMER_NESTED_CONTEXT_WIDGETS :
+                    Config.GetTotalWidgetCount ? Config.GetTotalWidgetCount((WidgetType)idx) : 
                     GetExpectedWidgetCount((WidgetType)idx);
                 states[idx].resize(count, WidgetConfigData{ (WidgetType)idx });
                 WidgetStyles[idx].resize(count);
@@ -1178,6 +1433,88 @@ namespace glimmer
         }
     }
 
+    // Reuse a pooled context if available, pooled contexts are already reset
+    static WidgetContextData* CreateNestedContext(int32_t id)
+    {
+        WidgetContextData* ctx = nullptr;
+
+        if (!PooledContexts.empty())
+        {
+            ctx = PooledContexts.back();
+            PooledContexts.pop_back();
+            ctx->pooled = false;
+            ctx->parentContext = CurrentContext;
+        }
+        else ctx = &(WidgetContexts.emplace_back(CurrentContext));
+
+        ctx->nestedId = id;
+        ctx->InsideFrame = CurrentContext->InsideFrame;
+        ctx->adhocLayout.clear(true);
+        auto& layout = ctx->adhocLayout.push();
+        layout.nextpos = CurrentContext->adhocLayout.top().nextpos;
+        return ctx;
+    }
+
+    static void PoolContext(WidgetContextData* ctx)
+    {
+        for (auto& children : ctx->nestedContexts)
+            for (auto child : children)
+                if (child != nullptr) PoolContext(child);
+
+        ctx->Recycle();
+        ctx->pooled = true;
+        PooledContexts.push_back(ctx);
+    }
+
+    static bool IsWithinContext(const WidgetContextData* ctx, const WidgetContextData* nested)
+    {
+        for (; nested != nullptr; nested = nested->parentContext)
+            if (nested == ctx) return true;
+        return false;
+    }
+
+    // Detach a nested context from its parent and pool it along with its own nested contexts,
+    // the context must not be in use i.e. pushed or the open popup
+    static void PoolNestedContext(WidgetContextData& context)
+    {
+        assert(!IsWithinContext(&context, CurrentContext) && !IsWithinContext(&context, WidgetContextData::PopupContext) &&
+            !IsWithinContext(&context, WidgetContextData::CurrentItemGridContext));
+
+        auto parent = context.parentContext;
+        auto& children = parent->nestedContexts[context.nestedId >> WidgetTypeBits];
+        auto index = context.nestedId & WidgetIndexMask;
+        if (index < (int)children.size() && children[index] == &context) children[index] = nullptr;
+        if (parent->popupContext == &context) parent->popupContext = nullptr;
+
+        // Drop-down keeps its popup context to draw options after its events are handled
+        if ((context.nestedId >> WidgetTypeBits) == WT_DropDown && index < (int)parent->dropdownStates.size() &&
+            parent->dropdownStates[index].context == &context)
+            parent->dropdownStates[index].context = nullptr;
+
+        PoolContext(&context);
+    }
+
+    // Nested contexts which were not pushed for a while (closed popups, drop-downs and grids
+    // which are no longer shown) are detached from their parent and pooled along with their
+    // own nested contexts. A context is only pushed by its parent, so the descendants of an
+    // unused context are unused as well. Pooling discards all widget state of the context,
+    // background jobs of its grids are abandoned by Recycle.
+    static void PoolUnusedContexts()
+    {
+        if (GLIMMER_NESTED_CONTEXT_RECLAIM_FRAMES <= 0) return;
+
+        for (auto& context : WidgetContexts)
+        {
+            if (context.parentContext == nullptr || context.pooled ||
+                WidgetContextData::CurrentFrame - context.lastPushed <= GLIMMER_NESTED_CONTEXT_RECLAIM_FRAMES ||
+                IsWithinContext(&context, WidgetContextData::PopupContext) ||
+                IsWithinContext(&context, WidgetContextData::CurrentItemGridContext))
+                continue;
+
+            PoolNestedContext(context);
+        }
+    }
+
     WidgetContextData& PushContext(int32_t id)
     {
         if (id < 0)
@@ -1201,34 +1538,12 @@ namespace glimmer
                 auto count = Config.GetTotalWidgetCount ?
                     Config.GetTotalWidgetCount((WidgetType)wtype) :
                     WidgetContextData::GetExpectedWidgetCount((WidgetType)wtype);
-                auto required = children.size() + count;
-                children.reserve(required);
-
-				for (auto idx = 0; idx < required; ++idx)
-                {
-                    if (idx == index)
-                    {
-                        auto& ctx = WidgetContexts.emplace_back();
-                        ctx.parentContext = CurrentContext;
-                        ctx.InsideFrame = CurrentContext->InsideFrame;
-                        auto& layout = ctx.adhocLayout.push();
-                        layout.nextpos = CurrentContext->adhocLayout.top().nextpos;
-                        children.emplace_back(&ctx);
-                    }
-                    else
-						children.emplace_back(nullptr);
-                }
-            }
-			else if (children[index] == nullptr)
-            {
-                auto& ctx = WidgetContexts.emplace_back();
-                ctx.parentContext = CurrentContext;
-                ctx.InsideFrame = CurrentContext->InsideFrame;
-                auto& layout = ctx.adhocLayout.push();
-                layout.nextpos = CurrentContext->adhocLayout.top().nextpos;
-                children[index] = &ctx;
+                children.resize(std::max<int>(index + 1, (int)children.size() + count), nullptr);
             }
 
+            if (children[index] == nullptr) children[index] = CreateNestedContext(id);
+            children[index]->lastPushed = WidgetContextData::CurrentFrame;
+
             CurrentContext = CurrentContext->nestedContexts[wtype][index];
             ContextPushed(CurrentContext);
             
@@ -1262,8 +1577,183 @@ namespace glimmer
         context->nestedContextStack.pop(1, true);
     }
 
+#pragma region Worker Threads
+
+    // Worker threads are created lazily on first use of ParallelFor, each call
+    // bumps the generation and waits until every worker has seen it.
+    struct WorkerPool
+    {
+        std::vector<std::thread> threads;
+        std::mutex lock;
+        std::condition_variable wakeup, finished;
+        ParallelTaskT task = nullptr;
+        void* data = nullptr;
+        std::atomic_int32_t next = 0;
+        int32_t count = 0, pending = 0;
+        uint64_t generation = 0;
+        bool stop = false;
+    };
+
+    static WorkerPool Workers;
+
+    static void RunParallelTasks(ParallelTaskT task, void* data, int32_t count)
+    {
+        for (auto index = Workers.next.fetch_add(1); index < count; index = Workers.next.fetch_add(1))
+            task(index, data);
+    }
+
+    static void WorkerThreadMain()
+    {
+        uint64_t seen = 0;
+
+        while (true)
+        {
+            ParallelTaskT task = nullptr;
+            void* data = nullptr;
+            int32_t count = 0;
+
+            {
+                std::unique_lock<std::mutex> guard{ Workers.lock };
+                Workers.wakeup.wait(guard, [&seen] { return Workers.stop || Workers.generation != seen; });
+                if (Workers.stop) return;
+
+                seen = Workers.generation;
+                task = Workers.task; data = Workers.data; count = Workers.count;
+            }
+
+            RunParallelTasks(task, data, count);
+
+            std::unique_lock<std::mutex> guard{ Workers.lock };
+            if (--Workers.pending == 0) Workers.finished.notify_one();
+        }
+    }
+
+    struct BackgroundQueue
+    {
+        struct Task
+        {
+            BackgroundTaskT task = nullptr;
+            BackgroundTaskT discard = nullptr;
+            void* data = nullptr;
+        };
+
+        std::thread thread;
+        std::mutex lock;
+        std::condition_variable wakeup;
+        std::vector<Task> tasks;
+        bool stop = false;
+    };
+
+    static BackgroundQueue Background;
+
+    static void BackgroundThreadMain()
+    {
+        while (true)
+        {
+            BackgroundQueue::Task next;
+
+            {
+                std::unique_lock<std::mutex> guard{ Background.lock };
+                Background.wakeup.wait(guard, [] { return Background.stop || !Background.tasks.empty(); });
+                if (Background.stop) return;
+
+                next = Background.tasks.front();
+                Background.tasks.erase(Background.tasks.begin());
+            }
+
+            next.task(next.data);
+        }
+    }
+
+    static void StopWorkerThreads()
+    {
+        {
+            std::unique_lock<std::mutex> guard{ Workers.lock };
+            Workers.stop = true;
+        }
+
+        Workers.wakeup.notify_all();
+        for (auto& thread : Workers.threads) thread.join();
+        Workers.threads.clear();
+
+        std::vector<BackgroundQueue::Task> pending;
+
+        {
+            std::unique_lock<std::mutex> guard{ Background.lock };
+            Background.stop = true;
+            pending.swap(Background.tasks);
+        }
+
+        Background.wakeup.notify_all();
+        if (Background.thread.joinable()) Background.thread.join();
+
+        // Tasks which never ran release their data
+        for (const auto& task : pending)
+            if (task.discard != nullptr) task.discard(task.data);
+    }
+
+    void ParallelFor(int32_t count, ParallelTaskT task, void* data)
+    {
+        auto nthreads = std::min((int32_t)GLIMMER_MAX_WORKER_THREADS, 
+            (int32_t)std::thread::hardware_concurrency() - 1);
+
+        if (count <= 1 || nthreads <= 0 || Workers.stop)
+        {
+            for (auto index = 0; index < count; ++index) task(index, data);
+            return;
+        }
+
+        if (Workers.threads.empty())
+            for (auto idx = 0; idx < nthreads; ++idx)
+                Workers.threads.emplace_back(&WorkerThreadMain);
+
+        {
+            std::unique_lock<std::mutex> guard{ Workers.lock };
+            Workers.task = task;
+            Workers.data = data;
+            Workers.count = count;
+            Workers.next.store(0);
+            Workers.pending = (int32_t)Workers.threads.size();
+            ++Workers.generation;
+        }
+
+        Workers.wakeup.notify_all();
+        RunParallelTasks(task, data, count);
+
+        std::unique_lock<std::mutex> guard{ Workers.lock };
+        Workers.finished.wait(guard, [] { return Workers.pending == 0; });
+    }
+
+    void RunInBackground(BackgroundTaskT task, void* data, BackgroundTaskT discard)
+    {
+        auto stopped = false;
+
+        {
+            // Tasks may be queued from background thread itself, while it is being stopped
+            std::unique_lock<std::mutex> guard{ Background.lock };
+            stopped = Background.stop;
+            if (!stopped)
+            {
+                if (!Background.thread.joinable())
+                    Background.thread = std::thread{ &BackgroundThreadMain };
+                Background.tasks.push_back({ task, discard, data });
+            }
+        }
+
+        if (!stopped) Background.wakeup.notify_one();
+        else if (discard != nullptr) discard(data);
+        else task(data);
+    }
+
+#pragma endregion
+
     void Cleanup()
     {
+        // Grid states abandon their background jobs, which lets a running one finish early
+        for (auto& context : WidgetContexts)
+            context.gridStates.clear();
+
+        StopWorkerThreads();
         ImPlot::DestroyContext(ChartsContext);
         if (Config.logger) Config.logger->Finish();
     }
@@ -1339,6 +1829,7 @@ namespace glimmer
         false, false, false, false, false };
     WidgetContextData* WidgetContextData::CurrentItemGridContext = nullptr;
     int32_t WidgetContextData::CurrentWidgetId = -1;
+    int32_t WidgetContextData::CurrentFrame = 0;
     DynamicStack<ToggleButtonStyleDescriptor, int16_t, GLIMMER_MAX_WIDGET_SPECIFIC_STYLES> WidgetContextData::toggleButtonStyles[WSI_Total];
     DynamicStack<RadioButtonStyleDescriptor, int16_t, GLIMMER_MAX_WIDGET_SPECIFIC_STYLES>  WidgetContextData::radioButtonStyles[WSI_Total];
     DynamicStack<SliderStyleDescriptor, int16_t, GLIMMER_MAX_WIDGET_SPECIFIC_STYLES> WidgetContextData::sliderStyles[WSI_Total];
@@ -38,6 +38,8 @@
 #include "style.h"
 
 #include <bit>
+#include <string>
+#include <unordered_map>
 
 namespace glimmer
 {
@@ -92,7 +94,7 @@ namespace glimmer
     {
         int32_t id = -1;
         int32_t geometry = 0;
-        int16_t longestOption = -1;
+        int32_t longestOption = -1;
         NeighborWidgets neighbors;
         char idstr[255] = { 0 };
     };
@@ -101,8 +103,25 @@ namespace glimmer
     {
         WidgetContextData* context = nullptr; // Nested context created inside BeginPopUp
         ImVec2 maxsz{}, extra{}, indicator{};
-        Vector<OptionDescriptor, int16_t, 16> items;
-        Vector<std::pair<int16_t, int16_t>, int16_t, 16> widgets[WT_TotalTypes];
+        Vector<OptionDescriptor, int32_t, 16> items;
+        Vector<std::pair<int16_t, int32_t>, int16_t, 16> widgets[WT_TotalTypes];
+
+        // Only a window of options starting at `first` (position in `shown`) is laid out
+        Vector<int32_t, int32_t, 16> sorted{ false }; // option indices ordered by case-folded text
+        Vector<int32_t, int32_t, 16> shown{ false };  // option indices after filtering, in display order
+        Vector<int32_t, int32_t, 16> rank{ false };   // option index -> position in shown, -1 if filtered
+        uint64_t signature = 0, indexed = 0;          // hash of option texts this frame, and when last indexed
+        uint64_t measured = 0;                        // signature when longest option was measured
+        ImVec2 longestsz{};                           // text extent of longest option
+        FontStyle measuredFont;                       // font longest option was measured with
+        int32_t measuredHint = -1;                    // option marked as longest when measured
+        int32_t first = 0;
+        int32_t active = -1;                          // option highlighted by mouse/keyboard
+
+        char query[GLIMMER_DROPDOWN_TYPEAHEAD_SZ] = { 0 };
+        int16_t querylen = 0;
+        float queryIdle = 0.f;
+        bool queryChanged = false;
     };
 
     enum class ItemGridCurrentState
@@ -110,6 +129,9 @@ namespace glimmer
         Default, ResizingColumns, ReorderingColumns
     };
 
+    struct ItemGridFilterJob;
+    struct ItemGridExportJob;
+
     struct ItemGridPersistentState
     {
         struct HeaderCellResizeState
@@ -149,6 +171,131 @@ namespace glimmer
         int16_t sortedLevel = -1;
         bool sortedAscending = false;
 
+        // Shape of grid when last populated, required outside of frame
+        int32_t populatedRows = 0;
+        int16_t leafLevel = 0;
+        int16_t populatedCols = 0;
+
+        // Row order maintained by the built-in sort engine, when a sort key provider is set
+        struct SortState
+        {
+            struct Column
+            {
+                int16_t col = -1;
+                bool ascending = true;
+            };
+
+            Vector<Column, int16_t, 4> columns{ false }; // Primary sort column first
+            Vector<int32_t, int32_t> order{ false }; // Visual row index to data row index
+            Vector<int32_t, int32_t> scratch{ false }; // Merge buffer, as large as order
+            Vector<ItemGridSortKey, int32_t> keys{ false }; // keys[row * columns + idx] of sorted rows
+            PagedStringArena<1 << 16> texts; // Copies of text keys returned by sort key provider
+            int32_t sortedRows = 0; // Rows covered by order
+            bool dirty = true;
+        } sorting;
+
+        // Rows matching the filter row, when a filter text provider is set
+        struct FilterState
+        {
+            std::vector<int32_t> rows; // Visible data rows in display order
+            std::vector<uint8_t> matched; // Per data row covered by filter, whether it matches
+            std::vector<std::string> applied; // Lower-cased filter per column, which rows match
+            ItemGridFilterJob* job = nullptr; // Filtering in progress on background thread
+            int32_t totalRows = 0; // Data rows covered by filter
+            bool active = false; // Any non-empty filter applied
+            bool dirty = true;
+            bool reorder = false; // Display order changed, rows are collected again
+
+            FilterState() = default;
+            FilterState(const FilterState&) = delete;
+            FilterState& operator=(const FilterState&) = delete;
+            ~FilterState(); // Abandons job
+        } filtering;
+
+        // Exports of data source values, the next batch of rows is copied while the grid is populated
+        struct ExportState
+        {
+            std::vector<ItemGridExportJob*> jobs;
+
+            ExportState() = default;
+            ExportState(const ExportState&) = delete;
+            ExportState& operator=(const ExportState&) = delete;
+            ~ExportState(); // Abandons jobs
+        } exporting;
+
+        // Formatted number/timestamp cells of columnar data source for a window of
+        // GLIMMER_ITEMGRID_FORMAT_CACHE_ROWS rows
+        FormattedTextCache<GLIMMER_ITEMGRID_FORMATTED_CELL_SZ> formattedCells;
+        std::vector<std::string> formats; // Validated format per data source column, empty for default
+
+        // Text extents of cells for a window of data rows, when a row version provider is set,
+        // indexed by (row % GLIMMER_ITEMGRID_MEASURE_CACHE_ROWS) * columns + col
+        struct MeasuredCell
+        {
+            uint64_t version = 0;
+            void* font = nullptr;
+            float fontsz = 0.f;
+            float wrapWidth = 0.f;
+            int32_t row = -1;
+            uint32_t generation = 0;
+            ImVec2 size;
+        };
+
+        Vector<MeasuredCell, int32_t> measuredCells{ false };
+        uint32_t measureGeneration = 0; // Changed when column widths change, discards measured cells
+
+        // Segment tree per aggregated column over data rows, where rows not displayed hold the identity
+        // of aggregate, so that appended/updated rows are folded in O(log n) and the result is at root
+        struct AggregateState
+        {
+            struct Column
+            {
+                std::vector<double> tree; // Leaves at [leaves, 2 * leaves), empty for Count/None
+                ItemGridAggregate type = ItemGridAggregate::None;
+            };
+
+            std::vector<Column> columns;
+            std::vector<std::string> texts; // Formatted result per column
+            std::string format = "%g"; // Validated format of results
+            std::vector<uint8_t> shown; // Per data row when filtered, else empty
+            std::vector<int32_t> updated; // Rows whose values have changed
+            int32_t leaves = 0;
+            int32_t rows = 0; // Data rows aggregated
+            int32_t count = 0; // Displayed rows
+            int32_t refiltered = -1; // First data row whose filter match may have changed, if any
+            bool dirty = true;
+        } aggregation;
+
+        // Loaded nodes and flattened visible rows of tree, when a tree model is set
+        struct TreeState
+        {
+            struct Node
+            {
+                std::vector<int32_t> children;
+                bool loaded = false;
+                bool loading = false;
+                bool expanded = false;
+            };
+
+            struct VisibleRow
+            {
+                int32_t node = -1; // -1 for placeholder of children being loaded
+                int32_t parent = -1;
+                int16_t depth = 0;
+            };
+
+            std::unordered_map<int32_t, Node> nodes;
+            std::vector<VisibleRow> rows; // Spliced on expand/collapse/load, in display order
+            int32_t toggled = -1; // Visible row whose expander was clicked, applied in next frame
+            int32_t grid = -1; // Id children are loaded for, once initialized
+            bool initialized = false;
+
+            TreeState() = default;
+            TreeState(const TreeState&) = delete;
+            TreeState& operator=(const TreeState&) = delete;
+            ~TreeState(); // Drops children loaded but not consumed
+        } tree;
+
         struct ItemId 
         {
             int32_t row = -1;
@@ -156,7 +303,8 @@ namespace glimmer
             int32_t depth = -1;
         };
 
-        Vector<ItemId, int16_t, 32> selections{ false };
+        ItemGridSelection selection;
+        ItemId anchor; // Last item selected without shift, start of contiguous selection
         float lastSelection = -1.f;
         float currentSelection = -1.f;
         
@@ -168,6 +316,49 @@ namespace glimmer
             int32_t state = WS_Default;
         } cellstate;
 
+        // Measured top-level row heights (including cell padding and grid line), used to
+        // populate only the rows visible in viewport
+        struct
+        {
+            PrefixSumTree<float, int32_t> pitches; // Per row, when row heights vary
+            float uniform = 0.f; // For all rows, when config.uniformRowHeights is set
+            float estimate = 0.f; // Used for rows which are yet to be measured
+            int32_t origin = 0; // Index of first row's pitch, pitches wrap around for streamed rows
+            int32_t capacity = 0; // Number of pitches for streamed rows, else one per row
+        } rowExtents;
+
+        // Auto-scroll state of streaming grid, which follows the last row unless scrolled up
+        struct
+        {
+            uint64_t base = 0; // Sequence number of row id 0, row ids are rebased before they overflow
+            float scroll = -1.f; // Scroll position set when following
+            bool following = true;
+        } streaming;
+
+        // Approximate heap usage of the grid's containers, excluding the object itself
+        int64_t memory() const
+        {
+            int64_t total = 0;
+            for (auto level = 0; level < GLIMMER_MAX_ITEMGRID_COLUMN_CATEGORY_LEVEL; ++level)
+            {
+                total += cols[level].capacity() * (int64_t)sizeof(HeaderCellResizeState);
+                total += headerStates[level].capacity() * (int64_t)sizeof(int32_t);
+                total += (colmap[level].ltov.capacity() + colmap[level].vtol.capacity()) * (int64_t)sizeof(int16_t);
+            }
+
+            total += (sorting.order.capacity() + sorting.scratch.capacity()) * (int64_t)sizeof(int32_t);
+            total += sorting.keys.capacity() * (int64_t)sizeof(ItemGridSortKey) + sorting.texts.memory();
+            total += (int64_t)filtering.rows.capacity() * (int64_t)sizeof(int32_t) + (int64_t)filtering.matched.capacity();
+            total += formattedCells.memory();
+            total += measuredCells.capacity() * (int64_t)sizeof(MeasuredCell);
+            for (const auto& column : aggregation.columns)
+                total += (int64_t)column.tree.capacity() * (int64_t)sizeof(double);
+            total += (int64_t)tree.rows.capacity() * (int64_t)sizeof(TreeState::VisibleRow);
+            total += (int64_t)tree.nodes.size() * (int64_t)sizeof(TreeState::Node);
+            total += rowExtents.pitches.memory();
+            return total;
+        }
+
         template <typename ContainerT>
         void swapColumns(int16_t from, int16_t to, Span<ContainerT> headers, int level)
         {
@@ -281,6 +472,12 @@ namespace glimmer
             int32_t row = 0;
         };
         float currentY = 0.f, startY = 0.f;
+        float rowOffset = 0.f; // Offset of first row from startY
+        bool virtualRows = false; // Only visible rows are populated
+        const int32_t* rowOrder = nullptr; // Visual to data row mapping, when sorted/filtered by the grid
+        int32_t shownRows = 0; // Rows displayed after filtering
+        const ItemGridPersistentState::TreeState::VisibleRow* treeRows = nullptr; // Flattened rows of lazy tree
+        int32_t streamRowId = 0; // Row id of oldest streamed row
         Vector<RowYToIndexMapping, int32_t> rowYs{ false };
         ItemGridPersistentState::ItemId clickedItem;
 
@@ -318,12 +515,37 @@ namespace glimmer
 
     enum class TextOpType { Addition, Deletion, Replacement };
 
+    // Text added/removed is kept as payload of the operation in undo/redo history, for
+    // replacement the payload is the replaced text followed by the new text
     struct TextInputOperation
     {
-        std::pair<int32_t, int32_t> range{ -1, -1 };
-        int32_t caretpos = 0;
-        char opmem[128] = { 0 };
-        TextOpType type;
+        std::pair<int32_t, int32_t> range{ -1, -1 }; // Position and length of affected text
+        int32_t caretpos = 0; // Caret position before the operation
+        TextOpType type = TextOpType::Addition;
+    };
+
+    // Lines of a multi-line text input, a line includes its terminating new line. Both sequences
+    // are gap buffered, hence an edit costs O(log n) irrespective of the number of lines.
+    struct TextLineIndex
+    {
+        GapPrefixSumTree<int32_t, int32_t> lengths; // Characters in each line
+        GapPrefixSumTree<int32_t, int32_t> rows; // Visual rows of each line, more than one if wrapped
+        float widest = 0.f; // Width of longest line, an upper bound until re-index completes
+        float sweepWidest = 0.f; // Width of longest line seen by pending re-index
+        float wrapWidth = 0.f; // Width at which lines are wrapped, 0 if not wrapped
+        float desiredx = -1.f; // Caret position in row kept while moving vertically
+        int32_t sweep = -1; // Next line to re-index, -1 if there is no pending re-index
+        int32_t anchor = -1; // Fixed end of selection, caret is the other end
+
+        // Re-measure lines in batches, restart if the wrap width has changed
+        void reindex(bool restart)
+        {
+            if (restart || sweep == -1)
+            {
+                sweep = 0;
+                sweepWidest = 0.f;
+            }
+        }
     };
 
     struct InputTextPersistentState
@@ -336,9 +558,28 @@ namespace glimmer
         float selectionStart = -1.f;
         float lastClickTime = -1.f;
         ScrollableRegion scroll;
-        Vector<float, int16_t> pixelpos; // Cumulative pixel position of characters
+        GapPrefixSumTree<float, int32_t> advances; // Advance width of characters, gap is at the last edit
         UndoRedoStack<TextInputOperation> ops; // Text operations for redo/undo stack
-        TextInputOperation currops;
+        TextLineIndex lines; // Only populated for multi-line input
+        uint32_t written = 0; // Edit count of the text when it was last copied to the output buffer
+
+        // Approximate heap usage of the text measurements, undo history and line index
+        int64_t memory() const
+        {
+            return advances.memory() + ops.memory() + lines.lengths.memory() + lines.rows.memory();
+        }
+
+        // Pixel position of the end of character at idx, 0 for idx = -1
+        float pixelpos(int32_t idx) const
+        {
+            return advances.prefix(idx + 1);
+        }
+
+        // Index of character under pixel position, -1 if position is past the text
+        int32_t charAt(float pos) const
+        {
+            return advances.empty() || pos > advances.total() ? -1 : advances.find(pos);
+        }
 
         void moveLeft(float amount)
         {
@@ -347,7 +588,7 @@ namespace glimmer
 
         void moveRight(float amount)
         {
-            scroll.state.pos.x = std::min(scroll.state.pos.x + amount, pixelpos.back());
+            scroll.state.pos.x = std::min(scroll.state.pos.x + amount, advances.total());
         }
     };
 
@@ -580,9 +821,9 @@ namespace glimmer
         ImVec2 maxdim{ 0.f, 0.f }; // max dimension of widget in curren row/col
         ImVec2 cumulative{ 0.f, 0.f }, size{}, contentsz{};
         ImRect extent{}; // max coords of widgets inside layout
-        Vector<ImVec2, int16_t> rows{ false };
-        Vector<ImVec2, int16_t> cols{ false };
-        Vector<int16_t, int16_t> griditems{ false };
+        FrameVector<ImVec2, int16_t> rows{ false };
+        FrameVector<ImVec2, int16_t> cols{ false };
+        FrameVector<int16_t, int16_t> griditems{ false };
         std::pair<int, int> gridsz;
         std::pair<int16_t, int16_t> currspan{ 1, 1 };
         ItemGridPopulateMethod gpmethod = ItemGridPopulateMethod::ByRows;
@@ -592,10 +833,19 @@ namespace glimmer
         int32_t regionIdx = -1;
         int32_t parentIdx = -1; // parent index in context.layouts
         int32_t specified = 0;
+        int16_t profileIdx = -1; // Index in per-frame layout profile, if profiling is enabled
+
+        // Virtualized grid, only rows in [firstRow, firstRow + rows) are populated
+        struct 
+        {
+            int32_t totalRows = -1;
+            int32_t firstRow = 0;
+            float rowHeight = 0.f;
+        } virtualGrid;
         void* implData = nullptr;
         bool popSizingOnEnd = false;
 
-        Vector<std::pair<int32_t, LayoutOps>, int16_t> itemIndexes{ false };
+        FrameVector<std::pair<int32_t, LayoutOps>, int16_t> itemIndexes{ false };
         FixedSizeStack<int32_t, 16> containerStack;
         TabBarBuilder tabbar;
 
@@ -755,11 +1005,11 @@ namespace glimmer
     {
         // This is quasi-persistent
         std::vector<WidgetConfigData> states[WT_TotalTypes];
-        std::vector<ItemGridPersistentState> gridStates;
+        LazyArray<ItemGridPersistentState> gridStates; // Allocated when grid is first drawn
         std::vector<ToggleButtonPersistentState> toggleStates;
         std::vector<RadioButtonPersistentState> radioStates;
         std::vector<CheckboxPersistentState> checkboxStates;
-        std::vector<InputTextPersistentState> inputTextStates;
+        LazyArray<InputTextPersistentState> inputTextStates; // Allocated when input is first drawn
         std::vector<SplitterPersistentState> splitterStates;
         std::vector<SpinnerPersistentState> spinnerStates;
         std::vector<DropDownPersistentState> dropdownStates;
@@ -788,6 +1038,9 @@ namespace glimmer
 
         std::vector<WidgetContextData*> nestedContexts[WT_TotalNestedContexts];
         WidgetContextData* parentContext = nullptr;
+        int32_t nestedId = -1; // Id with which the nested context was pushed
+        int32_t lastPushed = 0; // Frame in which the nested context was last pushed
+        bool pooled = false; // Nested context is reset and available for reuse
 
         // Styling data is static as it is persisted across contexts
         static StyleStackT StyleStack[WSI_Total];
@@ -806,29 +1059,30 @@ namespace glimmer
         Vector<StyleDescriptor[WSI_Total], int16_t, 32> WidgetStyles[WT_TotalTypes];
 
         // Layout related members
-        Vector<LayoutItemDescriptor, int16_t> layoutItems{ 128 };
-        Vector<ImRect, int16_t> itemGeometries[WT_TotalTypes]{
-            Vector<ImRect, int16_t>{ true },
-            Vector<ImRect, int16_t>{ true },
-            Vector<ImRect, int16_t>{ true },
-            Vector<ImRect, int16_t>{ true },
-            Vector<ImRect, int16_t>{ true },
-            Vector<ImRect, int16_t>{ true },
-            Vector<ImRect, int16_t>{ false },
-            Vector<ImRect, int16_t>{ true },
-            Vector<ImRect, int16_t>{ true },
-            Vector<ImRect, int16_t>{ false },
-            Vector<ImRect, int16_t>{ true },
-            Vector<ImRect, int16_t>{ true },
-            Vector<ImRect, int16_t>{ true },
-            Vector<ImRect, int16_t>{ true },
-            Vector<ImRect, int16_t>{ true },
-            Vector<ImRect, int16_t>{ true },
-            Vector<ImRect, int16_t>{ true },
-            Vector<ImRect, int16_t>{ true },
-            Vector<ImRect, int16_t>{ true },
-            Vector<ImRect, int16_t>{ true },
-            Vector<ImRect, int16_t>{ true }
+        FrameVector<LayoutItemDescriptor, int16_t> layoutItems{ false };
+        // Allocated as geometries are added, in smaller steps for nested contexts
+        Vector<ImRect, int16_t, 16> itemGeometries[WT_TotalTypes]{
+            Vector<ImRect, int16_t, 16>{ false },
+            Vector<ImRect, int16_t, 16>{ false },
+            Vector<ImRect, int16_t, 16>{ false },
+            Vector<ImRect, int16_t, 16>{ false },
+            Vector<ImRect, int16_t, 16>{ false },
+            Vector<ImRect, int16_t, 16>{ false },
+            Vector<ImRect, int16_t, 16>{ false },
+            Vector<ImRect, int16_t, 16>{ false },
+            Vector<ImRect, int16_t, 16>{ false },
+            Vector<ImRect, int16_t, 16>{ false },
+            Vector<ImRect, int16_t, 16>{ false },
+            Vector<ImRect, int16_t, 16>{ false },
+            Vector<ImRect, int16_t, 16>{ false },
+            Vector<ImRect, int16_t, 16>{ false },
+            Vector<ImRect, int16_t, 16>{ false },
+            Vector<ImRect, int16_t, 16>{ false },
+            Vector<ImRect, int16_t, 16>{ false },
+            Vector<ImRect, int16_t, 16>{ false },
+            Vector<ImRect, int16_t, 16>{ false },
+            Vector<ImRect, int16_t, 16>{ false },
+            Vector<ImRect, int16_t, 16>{ false }
         };
         DynamicStack<int32_t, int16_t> containerStack{ 16 };
         FixedSizeStack<SplitterContainerState, 16> splitterStack;
@@ -837,13 +1091,15 @@ namespace glimmer
 
         FixedSizeStack<AccordionBuilder, 4> accordions;
         DynamicStack<AdHocLayoutState, int16_t, 4> adhocLayout;
-        Vector<std::pair<int64_t, LayoutOps>, int16_t> replayContent;
+        FrameVector<std::pair<int64_t, LayoutOps>, int16_t> replayContent{ false };
         StyleStackT layoutStyles[WSI_Total]{ false, false, false, false,
             false, false, false, false, false };
 
-        // Keep track of widget IDs
+        // Keep track of widget IDs, maxids is the high-water mark of allocated indexes
         int maxids[WT_TotalTypes];
         int tempids[WT_TotalTypes];
+        SlotAllocator<int32_t> slots[WT_TotalTypes]; // Only used for types with recycled ids
+        static int32_t CurrentFrame;
         int32_t lastLayoutIdx = -1;
 
         // Whether we are in a frame being rendered + current renderer
@@ -872,10 +1128,26 @@ namespace glimmer
         static bool CacheItemGeometry;
 
         int32_t GetNextCount(WidgetType type);
+        bool RecyclesIds(WidgetType type) const;
+        bool ReleaseId(int32_t id);
+        void ReleaseUnusedIds(int32_t frames);
+        void MarkTransient(int32_t id);
+        WidgetHandle Handle(int32_t id) const;
+        bool IsValid(WidgetHandle handle) const;
+        WidgetMemoryUsage MemoryUsage(WidgetType type) const;
+
+        // Index of the widget state, also marks the state as used in current frame
+        int32_t UsedIndex(int32_t id)
+        {
+            auto index = id & WidgetIndexMask;
+            auto wtype = id >> WidgetTypeBits;
+            if (wtype < WT_TotalTypes) slots[wtype].touch(index, CurrentFrame);
+            return index;
+        }
 
         WidgetConfigData& GetState(int32_t id)
         {
-            auto index = id & WidgetIndexMask;
+            auto index = UsedIndex(id);
             auto wtype = (WidgetType)(id >> WidgetTypeBits);
             return states[wtype][index];
         }
@@ -889,67 +1161,67 @@ namespace glimmer
 
         ItemGridPersistentState& GridState(int32_t id)
         {
-            auto index = id & WidgetIndexMask;
+            auto index = UsedIndex(id);
             return gridStates[index];
         }
 
         ToggleButtonPersistentState& ToggleState(int32_t id)
         {
-            auto index = id & WidgetIndexMask;
+            auto index = UsedIndex(id);
             return toggleStates[index];
         }
 
         RadioButtonPersistentState& RadioState(int32_t id)
         {
-            auto index = id & WidgetIndexMask;
+            auto index = UsedIndex(id);
             return radioStates[index];
         }
 
         CheckboxPersistentState& CheckboxState(int32_t id)
         {
-            auto index = id & WidgetIndexMask;
+            auto index = UsedIndex(id);
             return checkboxStates[index];
         }
 
         InputTextPersistentState& InputTextState(int32_t id)
         {
-            auto index = id & WidgetIndexMask;
+            auto index = UsedIndex(id);
             return inputTextStates[index];
         }
 
         SplitterPersistentState& SplitterState(int32_t id)
         {
-            auto index = id & WidgetIndexMask;
+            auto index = UsedIndex(id);
             return splitterStates[index];
         }
 
         SpinnerPersistentState& SpinnerState(int32_t id)
         {
-            auto index = id & WidgetIndexMask;
+            auto index = UsedIndex(id);
             return spinnerStates[index];
         }
 
         DropDownPersistentState& DropDownState(int32_t id)
         {
-            auto index = id & WidgetIndexMask;
+            auto index = UsedIndex(id);
             return dropdownStates[index];
         }
 
         TabBarPersistentState& TabBarState(int32_t id)
         {
-            auto index = id & WidgetIndexMask;
+            auto index = UsedIndex(id);
             return tabBarStates[index];
         }
 
         NavDrawerPersistentState& NavDrawerState(int32_t id)
         {
-            auto index = id & WidgetIndexMask;
+            auto index = UsedIndex(id);
             return navDrawerStates[index];
         }
 
         AccordionPersistentState& AccordionState(int32_t id)
         {
-            auto index = id & WidgetIndexMask;
+            auto index = UsedIndex(id);
             return accordionStates[index];
         }
 
@@ -961,7 +1233,7 @@ namespace glimmer
 
         ScrollableRegion& ScrollRegion(int32_t id)
         {
-            auto index = id & WidgetIndexMask;
+            auto index = UsedIndex(id);
             auto type = id >> WidgetTypeBits;
             return states[type][index].state.scroll;
         }
@@ -1004,12 +1276,15 @@ namespace glimmer
         std::optional<NestedContextSource> IsInside(NestedContextSourceType source) const;
         std::optional<NestedContextSource> GetParentWidget() const;
 
-        WidgetContextData();
+        void Recycle();
+
+        explicit WidgetContextData(WidgetContextData* parent = nullptr);
     };
 
     void AddFontPtr(FontStyle& font);
     void InitFrameData();
     void ResetFrameData();
+    void ReclaimWidgetIds();
     WidgetContextData& GetContext();
     WidgetContextData& PushContext(int32_t id);
     WidgetContextData& PushContext(int32_t id, NestedContextSourceType source);
@@ -1019,6 +1294,20 @@ namespace glimmer
 
     StyleDescriptor GetStyle(WidgetContextData& context, int32_t id, StyleStackT const* StyleStack, int32_t state);
 
+    // Invoke task(index, data) for every index in [0, count) on the worker threads and the
+    // calling thread, returns once all indexes are processed. Tasks must not allocate through
+    // Vector (allocator hooks are not thread-safe) or touch the renderer.
+    using ParallelTaskT = void(*)(int32_t index, void* data);
+    void ParallelFor(int32_t count, ParallelTaskT task, void* data);
+
+    // Queue task(data) to run on a single background thread, tasks run in the order they are
+    // queued and the call returns immediately. Same restrictions apply as for ParallelFor tasks.
+    // Tasks still queued when the library is cleaned up are not run, discard(data) is invoked
+    // for them instead (if set) on the thread calling Cleanup(). Tasks queued after that are
+    // discarded in place, or run in place if there is no discard.
+    using BackgroundTaskT = void(*)(void* data);
+    void RunInBackground(BackgroundTaskT task, void* data, BackgroundTaskT discard = nullptr);
+
     extern NestedContextSource InvalidSource;
 
 #pragma endregion
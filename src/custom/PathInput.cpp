@@ -20,6 +20,7 @@ namespace glimmer
             std::string_view path;
             char* out = nullptr;
             int size = 0;
+            int32_t input = -1;
         };
         static std::unordered_map<int32_t, PathInputData> PathInputConfigs;
 
@@ -32,7 +33,7 @@ namespace glimmer
 
             // Input box for paths
             PushStyleFmt("width: %fpx;", width);
-            TextInput(out, size, placeholder, geometry, neighbors);
+            auto input = TextInput(out, size, placeholder, geometry, neighbors).id;
             PopStyle();
 
             // Browse button with icon
@@ -42,7 +43,7 @@ namespace glimmer
             if (PathInputConfigs.find(nid) == PathInputConfigs.end())
             {
                 auto& entry = PathInputConfigs[nid];
-                entry.out = out; entry.size = size;
+                entry.out = out; entry.size = size; entry.input = input;
                 entry.path = path;
                 entry.target = isDirectory ? IPlatform::FileDialogTarget::OneDirectory :
                     IPlatform::FileDialogTarget::OneFile;
@@ -58,6 +59,7 @@ namespace glimmer
                         int32_t res = GetUIConfig().platform->ShowFileDialog(&out, 1,
                             (int32_t)config.target, config.path, nullptr, 0,
                             IPlatform::DialogProperties{ "Select Path", "Select", "Cancel" });
+                        if (res > 0) SetTextInputText(config.input, std::string_view{ config.out, strnlen(config.out, config.size) });
                         /*if (res > 0)
                         {
                             auto copysz = std::min((size_t)config.size - 1, out.size());
@@ -149,7 +151,7 @@ namespace glimmer
                 if (res > 0)
                 {
                     AddPath(widgetData, selectedPath);
-                    widgetData.textInputBuffer[0] = '\0';
+                    SetTextInputText(widgetData.textInputId, {});
                 }
                 return true;
             }
@@ -157,8 +159,8 @@ namespace glimmer
             if (widgetData.textInputId != -1 && ICustomWidget::IsInState(widgetData.textInputId, WS_Focused) &&
                 desc.isKeyPressed(Key::Key_Enter))
             {
-                AddPath(widgetData, widgetData.textInputBuffer);
-                widgetData.textInputBuffer[0] = '\0';
+                AddPath(widgetData, GetTextInputText(widgetData.textInputId));
+                SetTextInputText(widgetData.textInputId, {});
                 return true;
             }
 
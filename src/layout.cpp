@@ -10,6 +10,13 @@
 
 #include <limits>
 #include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+
+#ifdef GLIMMER_ENABLE_LAYOUT_PROFILING
+#include <chrono>
+#endif
 
 #if GLIMMER_FLEXBOX_ENGINE == GLIMMER_CLAY_ENGINE
 #define CLAY_IMPLEMENTATION
@@ -221,6 +228,100 @@ namespace glimmer
     void CopyStyle(const StyleDescriptor& src, StyleDescriptor& dest);
     std::pair<int32_t, bool> GetIdFromString(std::string_view id, WidgetType type);
 
+#pragma region Layout Profiling
+
+#ifdef GLIMMER_ENABLE_LAYOUT_PROFILING
+
+    // Profile of current frame is accumulated in LayoutProfiles[CurrentProfile],
+    // the other one holds the profile of last completed frame
+    static Vector<LayoutProfileData, int16_t, 32> LayoutProfiles[2];
+    static int32_t CurrentProfile = 0;
+
+    struct LayoutProfileScope
+    {
+        float* target = nullptr;
+        std::chrono::steady_clock::time_point start;
+
+        LayoutProfileScope(const LayoutBuilder& layout)
+        {
+            if (layout.profileIdx != -1) start = std::chrono::steady_clock::now();
+        }
+
+        ~LayoutProfileScope()
+        {
+            if (target != nullptr)
+                *target += std::chrono::duration<float, std::micro>(std::chrono::steady_clock::now() - start).count();
+        }
+    };
+
+    static LayoutProfileData* GetLayoutProfile(const LayoutBuilder& layout)
+    {
+        return layout.profileIdx == -1 ? nullptr : &(LayoutProfiles[CurrentProfile][layout.profileIdx]);
+    }
+
+    static void StartLayoutProfile(WidgetContextData& context, LayoutBuilder& layout)
+    {
+        auto& profile = LayoutProfiles[CurrentProfile].emplace_back();
+        profile.id = layout.id;
+        profile.parentId = layout.parentIdx == -1 ? -1 : context.layouts[layout.parentIdx].id;
+        profile.depth = (int16_t)(context.layoutStack.size() - 1);
+        layout.profileIdx = LayoutProfiles[CurrentProfile].size() - 1;
+    }
+
+#define GLIMMER_PROFILE_LAYOUT(LAYOUT, FIELD) LayoutProfileScope profscope{ LAYOUT }; \
+    if (auto profile = GetLayoutProfile(LAYOUT); profile != nullptr) profscope.target = &(profile->FIELD)
+#define GLIMMER_COUNT_LAYOUT_ITEM(LAYOUT) if (auto profile = GetLayoutProfile(LAYOUT); profile != nullptr) profile->items++
+
+#else
+#define GLIMMER_PROFILE_LAYOUT(LAYOUT, FIELD)
+#define GLIMMER_COUNT_LAYOUT_ITEM(LAYOUT)
+#endif
+
+    void ResetLayoutProfile()
+    {
+#ifdef GLIMMER_ENABLE_LAYOUT_PROFILING
+        CurrentProfile = 1 - CurrentProfile;
+        LayoutProfiles[CurrentProfile].clear(true);
+#endif
+    }
+
+    std::span<LayoutProfileData> GetLayoutProfile()
+    {
+#ifdef GLIMMER_ENABLE_LAYOUT_PROFILING
+        return LayoutProfiles[1 - CurrentProfile].span();
+#else
+        return {};
+#endif
+    }
+
+    bool DumpLayoutProfile(std::string_view path)
+    {
+        char fname[512] = { 0 };
+        if (path.empty() || path.size() >= sizeof(fname)) return false;
+        std::memcpy(fname, path.data(), path.size());
+
+        auto fptr = std::fopen(fname, "w");
+        if (fptr == nullptr) return false;
+
+        auto profile = GetLayoutProfile();
+        std::fprintf(fptr, "{\n  \"frame\": %lld,\n  \"layouts\": [", (long long)FramesRendered());
+
+        for (auto idx = 0; idx < (int)profile.size(); ++idx)
+        {
+            const auto& data = profile[idx];
+            std::fprintf(fptr, "%s\n    { \"id\": %d, \"parent\": %d, \"depth\": %d, \"items\": %d, "
+                "\"addItemUs\": %.3f, \"layoutUs\": %.3f, \"alignUs\": %.3f, \"renderUs\": %.3f }",
+                idx == 0 ? "" : ",", data.id & WidgetIndexMask, data.parentId == -1 ? -1 : data.parentId & WidgetIndexMask, 
+                (int)data.depth, (int)data.items, data.addItemUs, data.layoutUs, data.alignUs, data.renderUs);
+        }
+
+        std::fprintf(fptr, "\n  ]\n}\n");
+        std::fclose(fptr);
+        return true;
+    }
+
+#pragma endregion
+
 #pragma region Layout functions
 
     void Move(int32_t direction)
@@ -861,6 +962,8 @@ namespace glimmer
 
     void AddItemToLayout(LayoutBuilder& layout, LayoutItemDescriptor& item, const StyleDescriptor& style)
     {
+        GLIMMER_PROFILE_LAYOUT(layout, addItemUs);
+        GLIMMER_COUNT_LAYOUT_ITEM(layout);
         auto& context = GetContext();
         auto isItemLayout = item.wtype == WT_Layout;
 
@@ -1276,8 +1379,13 @@ namespace glimmer
         auto& el = context.nestedContextStack.push();
         el.source = NestedContextSourceType::Layout;
         layout.id = id;
+        layout.profileIdx = -1;
         context.maxids[WT_Layout]++;
 
+#ifdef GLIMMER_ENABLE_LAYOUT_PROFILING
+        StartLayoutProfile(context, layout);
+#endif
+
         layout.alignment = geometry & ~ExpandAll;
         layout.spacing = spacing;
         layout.size = size;
@@ -1653,6 +1761,51 @@ namespace glimmer
         return BeginGridLayoutRegion(rows, cols, dir, geometry, rowExtents, colExtents, spacing, size, neighbors, -1);
     }
 
+    static std::pair<float, float> GetVisibleVerticalRange(WidgetContextData& context)
+    {
+        auto scrollid = -1;
+
+        if (!context.layoutStack.empty())
+        {
+            const auto& parent = context.layouts[context.layoutStack.top()];
+            if (parent.type == Layout::ScrollRegion) scrollid = parent.id;
+        }
+        else if (!context.containerStack.empty() &&
+            (context.containerStack.top() >> WidgetTypeBits) == WT_Scrollable)
+            scrollid = context.containerStack.top();
+
+        if (scrollid != -1)
+        {
+            // Viewport is from last frame, which is invalid for the very first frame
+            const auto& region = context.ScrollRegion(scrollid);
+            if (region.viewport.Min.x >= 0.f && region.viewport.GetHeight() > 0.f)
+                return { region.state.pos.y, region.state.pos.y + region.viewport.GetHeight() };
+        }
+
+        return { 0.f, context.MaximumSize().y };
+    }
+
+    std::pair<int32_t, int32_t> BeginVirtualGridLayout(int32_t totalRows, int cols, float rowHeight, int32_t geometry,
+        ImVec2 spacing, int32_t overscan)
+    {
+        assert(rowHeight > 0.f && totalRows >= 0);
+        auto& context = GetContext();
+        auto [vstart, vend] = GetVisibleVerticalRange(context);
+        auto pitch = rowHeight + spacing.y;
+
+        auto first = clamp((int32_t)(vstart / pitch) - overscan, 0, totalRows);
+        auto last = clamp((int32_t)std::ceil(vend / pitch) + overscan, first, totalRows);
+
+        BeginGridLayoutRegion(-1, cols, GridLayoutDirection::ByRows, geometry, {}, {}, spacing, ImVec2{}, 
+            NeighborWidgets{}, -1);
+
+        auto& layout = context.layouts[context.layoutStack.top()];
+        layout.virtualGrid.totalRows = totalRows;
+        layout.virtualGrid.firstRow = first;
+        layout.virtualGrid.rowHeight = rowHeight;
+        return { first, last };
+    }
+
     ImRect BeginLayout(std::string_view desc, const NeighborWidgets& neighbors)
     {
         // TODO: Implement layout CSS parsing
@@ -2126,13 +2279,25 @@ namespace glimmer
         auto currow = 0, currcol = 0;
         ImVec2 currpos{};
         ImVec2 min{ FLT_MAX, FLT_MAX }, max;
+        const auto isVirtual = layout.virtualGrid.totalRows != -1;
+
+        if (isVirtual)
+        {
+            // Only the populated band of rows is laid out, every row has the specified height
+            // and the band starts at the position of first populated row.
+            auto bandsz = layout.rows.size() + (layout.currcol > 0 ? 1 : 0);
+            layout.rows.clear(false);
+            for (auto row = 0; row < bandsz; ++row)
+                layout.rows.emplace_back(0.f, layout.virtualGrid.rowHeight);
+            currpos.y = (float)layout.virtualGrid.firstRow * (layout.virtualGrid.rowHeight + layout.spacing.y);
+        }
 
         if (layout.gpmethod == ItemGridPopulateMethod::ByRows)
         {
             // Pre-fill cell geometries of grid layout
             if (layout.cols.empty())
             {
-                Vector<float, int16_t> colmaxs{ (int16_t)layout.gridsz.second, 0.f };
+                FrameVector<float, int16_t> colmaxs{ (int16_t)layout.gridsz.second, 0.f };
 
                 if (layout.fill & FD_Horizontal)
                 {
@@ -2191,7 +2356,7 @@ namespace glimmer
             // Pre-fill cell geometries of grid layout
             if (layout.rows.empty())
             {
-                Vector<float, int16_t> colmaxs{ (int16_t)layout.gridsz.second, 0.f };
+                FrameVector<float, int16_t> colmaxs{ (int16_t)layout.gridsz.second, 0.f };
 
                 if (layout.fill & FD_Vertical)
                 {
@@ -2247,6 +2412,16 @@ namespace glimmer
         }
 
         auto& context = GetContext();
+
+        // Report size of all rows, without them being populated
+        if (isVirtual)
+        {
+            min.y = 0.f;
+            max.y = std::max(0.f, (float)layout.virtualGrid.totalRows * (layout.virtualGrid.rowHeight + layout.spacing.y) - 
+                layout.spacing.y);
+            if (layout.griditems.empty()) min.x = max.x = 0.f;
+        }
+
         auto implicitW = max.x - min.x;
         auto implicitH = max.y - min.y;
 
@@ -2347,6 +2522,7 @@ namespace glimmer
     {
 #if GLIMMER_FLEXBOX_ENGINE == GLIMMER_FLAT_ENGINE
 
+        GLIMMER_PROFILE_LAYOUT(layout, alignUs);
         AlignLayoutAxisItems(layout);
         AlignCrossAxisItems(layout, depth);
 
@@ -2420,9 +2596,15 @@ namespace glimmer
         }
 
         if (layout.type == Layout::Horizontal || layout.type == Layout::Vertical)
+        {
+            GLIMMER_PROFILE_LAYOUT(layout, layoutUs);
             PerformFlexboxLayout(context, layout);
-        else if (layout.type == Layout::Grid) 
+        }
+        else if (layout.type == Layout::Grid)
+        {
+            GLIMMER_PROFILE_LAYOUT(layout, layoutUs);
             PerformGridLayout(layout);
+        }
         else if (layout.type == Layout::ScrollRegion)
         {
             // This is a scroll region inside a layout hierarchy
@@ -2493,6 +2675,7 @@ namespace glimmer
                     UpdateItemGeometry(context, item, sublayout);
 
                 // This does not generate any draw commands but only computes widget geometry
+                GLIMMER_PROFILE_LAYOUT(sublayout, renderUs);
                 RenderWidgetInstance(item, styleStack, io, false);
                 break;
             }
@@ -2577,6 +2760,8 @@ namespace glimmer
                 auto& item = context.layoutItems[(int16_t)data];
                 if (WidgetContextData::CacheItemGeometry) 
                     item.margin = context.GetGeometry(item.id);
+
+                GLIMMER_PROFILE_LAYOUT(context.layouts[item.layoutIdx], renderUs);
                 if (auto res = RenderWidgetInstance(item, stack, io, true); res.event != WidgetEvent::None)
                     result = res;
                 break;
@@ -2706,6 +2891,75 @@ namespace glimmer
         return shift;
     }
 
+    // Child layouts of every layout in context.layouts, in CSR form i.e. children of layout
+    // `idx` are LayoutChildren[LayoutChildOffsets[idx]...LayoutChildOffsets[idx + 1])
+    static Vector<int16_t, int16_t, 64> LayoutChildOffsets{ false };
+    static Vector<int16_t, int16_t, 64> LayoutChildren{ false };
+
+    static void BuildLayoutChildIndex(WidgetContextData& context)
+    {
+        auto total = context.layouts.size();
+        LayoutChildOffsets.clear(false);
+        LayoutChildOffsets.resize(total + 1, (int16_t)0);
+        LayoutChildren.clear(false);
+        LayoutChildren.resize(total, (int16_t)-1);
+
+        for (const auto& layout : context.layouts)
+            if (layout.parentIdx != -1) LayoutChildOffsets[(int16_t)(layout.parentIdx + 1)]++;
+
+        for (int16_t idx = 1; idx <= total; ++idx)
+            LayoutChildOffsets[idx] += LayoutChildOffsets[idx - 1];
+
+        // Children are placed in creation order, this keeps sibling order deterministic
+        for (int16_t idx = 0; idx < total; ++idx)
+        {
+            auto pidx = context.layouts[idx].parentIdx;
+            if (pidx != -1) LayoutChildren[LayoutChildOffsets[(int16_t)pidx]++] = idx;
+        }
+
+        for (int16_t idx = total; idx > 0; --idx)
+            LayoutChildOffsets[idx] = LayoutChildOffsets[idx - 1];
+        LayoutChildOffsets[0] = 0;
+    }
+
+    // Sub-layouts never shift their content (only top-level layouts are aligned inside
+    // available space) hence, their children are translated by their origin only.
+    // Region and item geometries are updated in depth-first creation order.
+    static void TranslateLayoutSubtree(WidgetContextData& context, int16_t lidx)
+    {
+        for (auto cidx = LayoutChildOffsets[lidx]; cidx < LayoutChildOffsets[lidx + 1]; ++cidx)
+        {
+            auto sublidx = LayoutChildren[cidx];
+            auto& sublayout = context.layouts[sublidx];
+            sublayout.geometry.Translate(context.layouts[lidx].geometry.Min);
+            UpdateRegionGeometry(context, sublayout, false);
+            TranslateLayoutSubtree(context, sublidx);
+        }
+    }
+
+    // Propagate layout shifts of top-level layout to entire tree, sizes of all sub-layouts
+    // are resolved by now. The child index makes this linear in number of layouts.
+    // Subtrees are not computed concurrently: each sub-layout is computed in EndLayout as
+    // the application closes it, interleaved with its widget calls, and the geometry pass
+    // which follows measures text and reads style stacks shared by all subtrees.
+    static void PropagateLayoutShifts(WidgetContextData& context, LayoutBuilder& layout, ImVec2 shift)
+    {
+        auto root = (int16_t)context.layoutStack.top();
+        BuildLayoutChildIndex(context);
+
+        auto hasParentAligned = layout.parentIdx == -1 || layout.type != Layout::Grid;
+        auto offset = layout.geometry.Min + (hasParentAligned ? ImVec2{} : shift);
+
+        for (auto cidx = LayoutChildOffsets[root]; cidx < LayoutChildOffsets[root + 1]; ++cidx)
+        {
+            auto sublidx = LayoutChildren[cidx];
+            auto& sublayout = context.layouts[sublidx];
+            sublayout.geometry.Translate(offset);
+            UpdateRegionGeometry(context, sublayout, false);
+            TranslateLayoutSubtree(context, sublidx);
+        }
+    }
+
     WidgetDrawResult EndLayout(int depth)
     {
         WidgetDrawResult result;
@@ -2723,41 +2977,8 @@ namespace glimmer
             
             if (context.layoutStack.size() == 1)
             {
-                // Propagate layout shifts to entire tree
-                static Vector<std::pair<int32_t, ImVec2>, int16_t, 16> parents, currps;
-                parents.clear(true); currps.clear(true);
-
-                auto lidx = context.layoutStack.top();
                 auto shift = UpdateRegionGeometry(context, layout, true);
-                parents.emplace_back(lidx, shift);
-
-                while (!parents.empty())
-                {
-                    currps.clear(true);
-
-                    for (auto pidx = 0; pidx < parents.size(); ++pidx)
-                    {
-                        lidx = 0;
-                        for (auto& sublayout : context.layouts)
-                        {
-                            if (sublayout.parentIdx == parents[pidx].first)
-                            {
-                                assert(sublayout.parentIdx != lidx);
-
-                                const auto& parent = context.layouts[parents[pidx].first];
-                                auto hasParentAligned = parent.parentIdx == -1 || parent.type != Layout::Grid;
-                                auto offset = parent.geometry.Min + (hasParentAligned ? ImVec2{} : parents[pidx].second);
-                                sublayout.geometry.Translate(offset);
-
-                                auto chshift = UpdateRegionGeometry(context, sublayout, false);
-                                currps.emplace_back(lidx, chshift);
-                            }
-                            ++lidx;
-                        }
-                    }
-
-                    std::swap(parents, currps);
-                }
+                PropagateLayoutShifts(context, layout, shift);
 
                 context.AddItemGeometry(layout.id, layout.geometry);
                 RenderWidgets(context, layout, result);
@@ -2,8 +2,24 @@
 
 #include "types.h"
 
+#include <span>
+
 namespace glimmer
 {
+    // Per-layout profile data, only recorded when GLIMMER_ENABLE_LAYOUT_PROFILING is defined.
+    // All timings are in microseconds, alignment time is only available for flat flexbox engine.
+    struct LayoutProfileData
+    {
+        int32_t id = -1;
+        int32_t parentId = -1;
+        int16_t depth = 0; // nesting depth, 0 for top-level layouts
+        int16_t items = 0; // number of items directly added to layout
+        float addItemUs = 0.f; // time spent in AddItemToLayout
+        float layoutUs = 0.f; // time spent in flexbox/grid layout algorithm
+        float alignUs = 0.f; // time spent in aligning items on main/cross axis
+        float renderUs = 0.f; // time spent in replay of items (geometry update + render)
+    };
+
     void Move(int32_t direction); // Combination of Direction enum values
     void Move(int32_t id, int32_t direction); // Combination of Direction enum values
     void Move(std::string_view id, int32_t direction); // Combination of Direction enum values
@@ -35,6 +51,13 @@ namespace glimmer
         const std::initializer_list<float>& colExtents = {}, ImVec2 spacing = { 0.f, 0.f }, ImVec2 size = { 0.f, 0.f },
         const NeighborWidgets& neighbors = NeighborWidgets{});
     ImRect BeginLayout(std::string_view desc, const NeighborWidgets& neighbors = NeighborWidgets{});
+
+    // Virtualized row-wise grid layout of `totalRows` rows of known/estimated height, to be placed
+    // inside a scrollable region. Only the rows visible in the region (plus `overscan` rows on
+    // either side) have to be populated, returns the range of rows [first, last) to populate.
+    // The scrollable region's content size is set to the size of all rows. End with EndLayout().
+    std::pair<int32_t, int32_t> BeginVirtualGridLayout(int32_t totalRows, int cols, float rowHeight, int32_t geometry,
+        ImVec2 spacing = { 0.f, 0.f }, int32_t overscan = 2);
     void NextRow();
     void NextColumn();
     WidgetDrawResult EndLayout(int depth = 1);
@@ -43,4 +66,9 @@ namespace glimmer
     void InvalidateLayout();
     void ContextPushed(void* data);
     void ContextPopped();
+
+    // Layout profile of last completed frame, empty if profiling is not enabled
+    std::span<LayoutProfileData> GetLayoutProfile();
+    bool DumpLayoutProfile(std::string_view path);
+    void ResetLayoutProfile();
 }
@@ -128,6 +128,48 @@ namespace glimmer
         WT_TotalNestedContexts
     };
 
+    // Widget id given as a string, either hashed at compile time with "id"_gid or looked up
+    // by the string itself at runtime
+    struct StringId
+    {
+        std::string_view text;
+        uint64_t hash = 0; // Non-zero only for ids created with "id"_gid
+
+        template <typename StrT, typename = std::enable_if_t<std::is_convertible_v<const StrT&, std::string_view>>>
+        constexpr StringId(const StrT& id) : text{ id } {}
+        constexpr StringId(std::string_view id, uint64_t value) : text{ id }, hash{ value } {}
+    };
+
+    // FNV-1a hash of the id literal, i.e. Button("save"_gid, "Save") resolves the widget id
+    // through a flat hash table without hashing or comparing strings at runtime
+    consteval StringId operator""_gid(const char* str, std::size_t len)
+    {
+        uint64_t hash = 14695981039346656037ull;
+        for (std::size_t idx = 0; idx < len; ++idx)
+        {
+            hash ^= (uint8_t)str[idx];
+            hash *= 1099511628211ull;
+        }
+        return StringId{ std::string_view{ str, len }, hash == 0 ? 1 : hash };
+    }
+
+    // Widget id along with the generation of its state slot, ids are reused once their state is
+    // released, a handle detects whether the id still refers to the same widget
+    struct WidgetHandle
+    {
+        int32_t id = -1;
+        uint32_t generation = 0;
+    };
+
+    // Memory held by states of a widget type across contexts, heavy persistent states i.e. of
+    // text inputs and item grids are only allocated once the widget is drawn
+    struct WidgetMemoryUsage
+    {
+        int32_t widgets = 0; // Widget state slots
+        int32_t allocated = 0; // Allocated heavy persistent states
+        int64_t bytes = 0;
+    };
+
     enum class LineType
     {
         Solid, Dashed, Dotted, DashDot
@@ -222,6 +264,7 @@ namespace glimmer
         };
         ScrollbarStyleDescriptor scrollbar;
         ICustomWidget* (*CustomWidgetProvider)(int16_t) = nullptr;
+        // Called when a string id is assigned a widget id, the string is only valid during the call
         void (*RecordWidgetId)(std::string_view, int32_t) = nullptr;
         IWidgetLogger* logger = nullptr;
         void* iconFont = nullptr;
@@ -421,7 +464,7 @@ namespace glimmer
 
     struct TextInputState : public CommonWidgetData
     {
-        std::vector<char> text;
+        TextGapBuffer text;
         Span<char> out;
         std::string_view placeholder;
         std::pair<int, int> selection{ -1, -1 };
@@ -433,13 +476,16 @@ namespace glimmer
         SymbolIcon suffixIcon = SymbolIcon::None;
         bool isMasked = false;
         bool isSelectable = true;
+        bool isMultiline = false; // Enter inserts a new line, only visible lines are laid out
+        bool wrapLines = false; // Wrap lines of multi-line input at viewport width
     };
 
     enum DropDownSizingPolicy
     {
         DD_FitToInitialContent = 1,
         DD_FitToLongestOption = 2,
-        DD_SetPopupWidthToInitial = 4
+        DD_SetPopupWidthToInitial = 4,
+        DD_FilterOptions = 8 // Type-ahead filters options by substring instead of jumping to prefix match
     };
 
     struct DropDownState : public CommonWidgetData
@@ -541,6 +587,59 @@ namespace glimmer
         bool disabled = false;
     };
 
+    // Typed key of a cell for the built-in ItemGrid sort engine, text keys must remain
+    // valid until the sort completes i.e. within the frame in which they are extracted
+    struct ItemGridSortKey
+    {
+        std::string_view text;
+        double number = 0.0;
+        bool isText = false;
+
+        ItemGridSortKey() {}
+        ItemGridSortKey(double value) : number{ value } {}
+        ItemGridSortKey(int64_t value) : number{ (double)value } {}
+        ItemGridSortKey(int32_t value) : number{ (double)value } {}
+        ItemGridSortKey(std::string_view value) : text{ value }, isText{ true } {}
+    };
+
+    enum class ItemGridColumnType
+    {
+        Integer, Real, Text, Timestamp
+    };
+
+    // Typed column of ItemGrid's columnar data source, values are indexed by data row and read in place.
+    // Numbers are formatted with printf-style format, timestamps (seconds since epoch, UTC) with
+    // strftime-style format, both are optional. Number formats have a single conversion, which takes
+    // long long for integers (e.g. "%08llx") or double for reals (e.g. "%.2f"), else default is used.
+    // Background filtering/export work on a copy, values may change once SetItemGridDataSource returns.
+    struct ItemGridColumnData
+    {
+        ItemGridColumnType type = ItemGridColumnType::Text;
+        std::span<const int64_t> integers; // For Integer and Timestamp columns
+        std::span<const double> reals;
+        std::span<const std::string_view> texts;
+        std::string_view format;
+        TextType textType = TextType::PlainText;
+    };
+
+    struct ItemGridDataSource
+    {
+        std::span<const ItemGridColumnData> columns; // One per logical column
+        uint64_t version = 0; // Change when values change, to discard formatted cells
+    };
+
+    // Lazily loaded hierarchy of a tree ItemGrid, nodes are identified by application defined ids
+    // (unique across the tree, root is -1), children of a node are requested on its first expansion
+    struct ItemGridTreeModel
+    {
+        using HasChildrenProviderT = bool (*)(int32_t node);
+        using LoadChildrenT = void (*)(int32_t grid, int32_t node);
+
+        HasChildrenProviderT hasChildren = nullptr; // Decides if expander is shown, before children are loaded
+        LoadChildrenT loadChildren = nullptr; // Children are set via SetItemGridTreeChildren, now or later from any thread
+        std::string_view loadingText = "Loading...";
+    };
+
     enum class WidgetEvent
     {
         None, Focused, Clicked, Hovered, Pressed, DoubleClicked, RightClicked, 
@@ -597,6 +696,111 @@ namespace glimmer
         IG_Selected = 1, IG_Highlighted = 2
     };
 
+    // Selected rows, columns and cells of an ItemGrid as interval sets. Rows and cells are
+    // tracked per depth, as row indexes in tree mode are counted per depth.
+    struct ItemGridSelection
+    {
+        using SetT = IntervalSet<int32_t, int32_t>;
+
+        bool isRowSelected(int32_t row, int16_t depth) const;
+        bool isColumnSelected(int16_t col) const;
+        bool isCellSelected(int32_t row, int16_t col, int16_t depth) const;
+
+        void selectRows(int32_t from, int32_t to, int16_t depth, bool select = true);
+        void selectColumns(int16_t from, int16_t to, bool select = true);
+        void selectCell(int32_t row, int16_t col, int16_t depth, bool select = true);
+        void selectAll();
+        void invert();
+        void clear();
+        void shiftRows(int32_t delta); // Row ids of all depths move down by delta, negative ones are dropped
+        bool empty() const;
+
+        // Selected ids within [0, limit)
+        SetT::ValueRange rows(int16_t depth, int32_t limit) const;
+        SetT::ValueRange columns(int16_t limit) const;
+        SetT::ValueRange cells(int16_t col, int16_t depth, int32_t limit) const;
+        int32_t rowCount(int16_t depth, int32_t limit) const;
+
+    private:
+
+        struct DepthSelection
+        {
+            SetT rows;
+            Vector<SetT, int16_t, 8> cells{ false }; // selected rows per column
+        };
+
+        DepthSelection& at(int16_t depth);
+        SetT& cellsAt(int16_t col, int16_t depth);
+        const SetT& unset() const;
+
+        Vector<DepthSelection, int16_t, 4> depths{ false };
+        SetT cols;
+        bool inverted = false; // depths/columns added later start out inverted
+    };
+
+    // Rows of a streaming ItemGrid, appended by one producer thread and consumed by the grid once
+    // per frame into a bounded ring buffer, where oldest rows are discarded once it is full
+    struct ItemGridStream
+    {
+        struct Row
+        {
+            int16_t ends[GLIMMER_ITEMGRID_STREAM_MAX_COLUMNS]; // End offset of each cell's text
+            int16_t columns = 0;
+            char text[GLIMMER_ITEMGRID_STREAM_ROW_SZ];
+        };
+
+        explicit ItemGridStream(int32_t capacity, int32_t pending = 4096);
+
+        // Producer thread only, returns false if pending rows are not yet consumed
+        bool append(std::span<const std::string_view> cells);
+
+        // UI thread only, moves pending rows to ring buffer, returns rows appended and discarded
+        std::pair<int32_t, int32_t> consume();
+
+        std::string_view cell(int32_t row, int16_t col) const; // row 0 is the oldest row
+        int32_t size() const { return _count; }
+        int32_t capacity() const { return _rows.size(); }
+        int32_t origin() const { return _origin; } // Ring index of oldest row
+        uint64_t first() const { return _total - (uint64_t)_count; } // Sequence number of oldest row
+
+    private:
+
+        SpscQueue<Row> _pending;
+        Vector<Row, int32_t> _rows{ false };
+        int32_t _origin = 0, _count = 0;
+        uint64_t _total = 0;
+    };
+
+    enum class ItemGridExportFormat
+    {
+        CSV, TSV
+    };
+
+    struct ItemGridExportOptions
+    {
+        using ProgressT = bool (*)(int32_t grid, int64_t exported, int64_t total, void* data);
+        using TextProviderT = std::string_view (*)(int32_t row, int16_t col);
+
+        int fd = -1; // Written to, but not closed
+        ItemGridExportFormat format = ItemGridExportFormat::CSV;
+        TextProviderT text = nullptr; // Cell text, grid's filter text provider or data source is used if not set
+        std::span<const std::string_view> names; // Column names for header, static grid's header names if empty
+        bool header = true;
+        bool selectedOnly = false;
+
+        // Invoked from background thread after each batch of rows, with exported as -1 if writing
+        // failed or Cleanup() cut the export short. Return false to stop the export. Without a text
+        // provider, values of a batch are copied while the grid is populated, i.e. a batch per frame,
+        // and exported is -1 (reported on the UI thread) if the grid or exported rows go away.
+        ProgressT progress = nullptr;
+        void* data = nullptr;
+    };
+
+    enum class ItemGridAggregate
+    {
+        None, Count, Sum, Average, Min, Max
+    };
+
     struct ItemGridConfig : public CommonWidgetData
     {
         struct ColumnConfig
@@ -657,11 +861,21 @@ namespace glimmer
         using CellWidgetProviderT = void (*)(const CellGeometry& cell);
         using CellContentProviderT = std::pair<std::string_view, TextType> (*)(const CellGeometry& cell);
         using HeaderProviderT = void (*)(ImVec2, float, int16_t, int16_t, int16_t);
+        using SortKeyProviderT = ItemGridSortKey (*)(int32_t row, int16_t col);
+        using FilterTextProviderT = std::string_view (*)(int32_t row, int16_t col);
+        using RowVersionProviderT = uint64_t (*)(int32_t row);
+        using AggregateValueProviderT = double (*)(int32_t row, int16_t col);
 
         CellPropertiesProviderT cellprops = nullptr;
         CellWidgetProviderT cellwidget = nullptr;
         CellContentProviderT cellcontent = nullptr;
         HeaderProviderT header = nullptr;
+        SortKeyProviderT sortkey = nullptr; // If set, rows are sorted by the grid itself
+        FilterTextProviderT filtertext = nullptr; // If set, rows are filtered by the filter row, may be invoked from background thread
+        ItemGridDataSource source; // If set, used in place of cellcontent, rows are sorted and filtered by the grid
+        ItemGridTreeModel tree; // If set, providers receive node id as row, and vstate/children of cellprops are ignored
+        ItemGridStream* stream = nullptr; // If set, rows are tailed from stream, used in place of cellcontent
+        RowVersionProviderT rowversion = nullptr; // If set, text extents of a row's cells are reused till its version changes
 
         struct EpilogueRowProviders
         {
@@ -670,10 +884,96 @@ namespace glimmer
             CellContentProviderT cellcontent = nullptr;
         } epilogue;
 
+        // Per column aggregates over displayed rows, shown in epilogue rows without content providers
+        struct AggregateConfig
+        {
+            std::span<const ItemGridAggregate> columns;
+            AggregateValueProviderT value = nullptr; // Data source is used if not set, may be invoked from worker threads
+            std::string_view format = "%g";
+        } aggregates;
+
         void setColumnResizable(int16_t col, bool resizable);
         void setColumnProps(int16_t col, ColumnProperty prop, bool set = true);
     };
 
+#ifndef GLIMMER_DISABLE_PLOTS
+    enum class ChartDecimation
+    {
+        None, // All points in view are plotted
+        MinMax, // Minimum and maximum per pixel column, keeps every spike
+        LTTB // Largest-Triangle-Three-Buckets over min/max reduced points, keeps the shape of line
+    };
+
+    // Points with ascending x, along with a min/max pyramid of y values. Plotting it with
+    // PlotSeries picks the pyramid level from the visible x range, hence the cost depends on
+    // the width of plot in pixels rather than on the number of points.
+    struct ChartSeries
+    {
+        std::vector<double> xs; // Empty if x values are uniformly spaced
+        std::vector<double> ys;
+        double start = 0.0, step = 1.0; // x = start + idx * step, when xs is empty
+        ChartDecimation decimation = ChartDecimation::MinMax;
+        MinMaxPyramid<double, int32_t> pyramid;
+
+        void assign(std::span<const double> x, std::span<const double> y);
+        void assign(std::span<const double> y, double xstart = 0.0, double xstep = 1.0);
+        void append(double x, double y);
+        void append(double y); // For uniformly spaced x values
+        void update(int32_t from); // Call after modifying ys in place from the index onwards
+        void clear();
+
+        int32_t size() const { return (int32_t)ys.size(); }
+        double x(int32_t idx) const { return xs.empty() ? start + (double)idx * step : xs[idx]; }
+        int32_t lowerBound(double value) const; // Index of first point with x >= value
+        int64_t memory() const;
+
+        // Points to plot when x values in [from, to] span the given number of pixels
+        void decimate(double from, double to, int32_t pixels, std::vector<double>& outx, std::vector<double>& outy) const;
+    };
+
+    // Samples of a real-time chart, pushed by one producer thread and consumed by the UI thread
+    // into a fixed capacity ring buffer, where the oldest samples are overwritten once it is full.
+    // Only the pyramid buckets of consumed samples are updated, and decimation looks up each pixel
+    // column, hence the history is never copied or scanned as a whole.
+    struct ChartStream
+    {
+        struct Sample
+        {
+            double x = 0.0, y = 0.0;
+        };
+
+        ChartDecimation decimation = ChartDecimation::MinMax;
+
+        explicit ChartStream(int32_t capacity, int32_t pending = 16384);
+
+        // Producer thread only, returns false if pending samples are not yet consumed, x must ascend
+        bool push(double x, double y);
+
+        // UI thread only, moves pending samples to ring buffer, returns samples appended and discarded.
+        // SetupPlotStream and PlotStream consume the stream before using it.
+        std::pair<int32_t, int32_t> consume();
+
+        int32_t size() const { return _count; }
+        int32_t capacity() const { return (int32_t)_ys.size(); }
+        double x(int32_t idx) const { return _xs[(_origin + idx) % _xs.size()]; } // idx 0 is the oldest sample
+        double y(int32_t idx) const { return _ys[(_origin + idx) % _ys.size()]; }
+        int32_t lowerBound(double value) const; // Index of first sample with x >= value
+        int64_t memory() const;
+
+        // Points to plot when x values in [from, to] span the given number of pixels
+        void decimate(double from, double to, int32_t pixels, std::vector<double>& outx, std::vector<double>& outy) const;
+
+    private:
+
+        std::pair<double, double> _extent(int32_t from, int32_t to) const; // Min/max of y in [from, to)
+
+        SpscQueue<Sample> _pending;
+        std::vector<double> _xs, _ys;
+        MinMaxPyramid<double, int32_t> _pyramid;
+        int32_t _origin = 0, _count = 0;
+    };
+#endif
+
     struct WidgetConfigData
     {
         WidgetType type;
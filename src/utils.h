@@ -2,12 +2,24 @@
 
 #include <type_traits>
 #include <span>
+#include <string_view>
 #include <optional>
 #include <assert.h>
 #include <cstdlib>
+#include <cstring>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <limits>
+#include <algorithm>
 
 #include "config.h"
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define GLIMMER_SSE2
+#include <emmintrin.h>
+#endif
+
 namespace glimmer
 {
     template <typename T>
@@ -83,10 +95,126 @@ namespace glimmer
     inline void (*DeallocateFunc)(void* ptr) = &std::free;
 #endif
 
-    template <typename T, typename Sz, Sz blocksz = 128>
+    // Default allocation policy for containers, routes through the allocation hooks above
+    struct HeapAllocator
+    {
+        static void* allocate(size_t amount) { return AllocateFunc(amount); }
+        static void* reallocate(void* ptr, size_t, size_t amount) { return ReallocateFunc(ptr, amount); }
+        static void deallocate(void* ptr) { DeallocateFunc(ptr); }
+    };
+
+    // Linear allocator for data which only lives till the end of current frame. Allocations are
+    // bump allocated from blocks, which are all released at once by reset() in ResetFrameData.
+    // If a frame needed more than one block, the blocks are coalesced into one during reset, 
+    // hence in steady-state no heap allocation is made for frame data.
+    struct FrameArena
+    {
+        struct Block
+        {
+            char* data = nullptr;
+            size_t size = 0;
+            size_t used = 0;
+        };
+
+        Block blocks[32];
+        int32_t current = 0, total = 0;
+        char* last = nullptr; // last allocation, can be grown in-place
+        size_t usedBytes = 0, peakBytes = 0;
+        int32_t blockAllocations = 0; // heap allocations made by arena itself, for diagnostics
+
+        ~FrameArena()
+        {
+            for (auto idx = 0; idx < total; ++idx) DeallocateFunc(blocks[idx].data);
+        }
+
+        void* allocate(size_t amount)
+        {
+            amount = (amount + 15u) & ~(size_t)15u;
+            while (current < total && (blocks[current].used + amount) > blocks[current].size) ++current;
+
+            if (current == total)
+            {
+                assert(total < 32);
+                auto& block = blocks[total++];
+                auto prevsz = total > 1 ? blocks[total - 2].size * 2u : (size_t)GLIMMER_FRAME_ARENA_BLOCKSZ;
+                block.size = std::max(amount, prevsz);
+                block.data = (char*)AllocateFunc(block.size);
+                block.used = 0;
+                ++blockAllocations;
+            }
+
+            auto& block = blocks[current];
+            last = block.data + block.used;
+            block.used += amount;
+            usedBytes += amount;
+            return last;
+        }
+
+        void* reallocate(void* ptr, size_t oldsz, size_t amount)
+        {
+            if (ptr == nullptr) return allocate(amount);
+            if (amount <= oldsz) return ptr;
+
+            // Grow last allocation in-place if possible, otherwise copy to a new allocation
+            if (ptr == last && current < total)
+            {
+                auto& block = blocks[current];
+                auto newused = (size_t)(last - block.data) + ((amount + 15u) & ~(size_t)15u);
+
+                if (newused <= block.size)
+                {
+                    usedBytes += newused - block.used;
+                    block.used = newused;
+                    return ptr;
+                }
+            }
+
+            auto result = allocate(amount);
+            std::memcpy(result, ptr, oldsz);
+            return result;
+        }
+
+        void reset()
+        {
+            if (total > 1)
+            {
+                size_t totalsz = 0;
+                for (auto idx = 0; idx < total; ++idx)
+                {
+                    totalsz += blocks[idx].size;
+                    DeallocateFunc(blocks[idx].data);
+                    blocks[idx] = Block{};
+                }
+
+                blocks[0].size = totalsz;
+                blocks[0].data = (char*)AllocateFunc(totalsz);
+                total = 1;
+                ++blockAllocations;
+            }
+
+            for (auto idx = 0; idx < total; ++idx) blocks[idx].used = 0;
+            peakBytes = std::max(peakBytes, usedBytes);
+            usedBytes = 0;
+            current = 0;
+            last = nullptr;
+        }
+    };
+
+    inline FrameArena FrameMemory;
+
+    // Allocation policy for containers whose content is valid only for a frame, such containers
+    // must be released (Vector::release) before FrameMemory is reset
+    struct FrameAllocator
+    {
+        static void* allocate(size_t amount) { return FrameMemory.allocate(amount); }
+        static void* reallocate(void* ptr, size_t oldsz, size_t amount) { return FrameMemory.reallocate(ptr, oldsz, amount); }
+        static void deallocate(void*) {}
+    };
+
+    template <typename T, typename Sz, Sz blocksz = 128, typename Allocator = HeapAllocator>
     struct Vector
     {
-        template <typename Ty, typename S, S v> friend struct DynamicStack;
+        template <typename Ty, typename S, S v, typename A> friend struct DynamicStack;
 
         static_assert(blocksz > 0, "Block size has to non-zero");
         static_assert(std::is_integral_v<Sz>, "Sz must be integral type");
@@ -133,7 +261,7 @@ namespace glimmer
         {
             if constexpr (std::is_destructible_v<T> && std::is_scalar_v<T>)
                 for (auto idx = 0; idx < _size; ++idx) _data[idx].~T();
-            DeallocateFunc(_data);
+            Allocator::deallocate(_data);
         }
 
         explicit Vector(bool init = true)
@@ -141,7 +269,7 @@ namespace glimmer
             if (init)
             {
                 _capacity = blocksz;
-                _data = (T*)AllocateFunc(sizeof(T) * blocksz);
+                _data = (T*)Allocator::allocate(sizeof(T) * blocksz);
                 _default_init(0, _capacity);
             }
         }
@@ -149,24 +277,24 @@ namespace glimmer
         template <typename IntegralT,
             typename = std::enable_if_t<std::is_integral_v<IntegralT> && !std::is_same_v<IntegralT, bool>>>
         explicit Vector(IntegralT initialsz)
-            : _data{ (T*)AllocateFunc(sizeof(T) * (Sz)initialsz) }, _size{ 0 }, _capacity{ (Sz)initialsz }
+            : _data{ (T*)Allocator::allocate(sizeof(T) * (Sz)initialsz) }, _size{ 0 }, _capacity{ (Sz)initialsz }
         {
             _default_init(0, _capacity);
         }
 
         explicit Vector(Sz initialsz, const T& el)
-            : _data{ (T*)AllocateFunc(sizeof(T) * initialsz) }, _size{ initialsz }, _capacity{ initialsz }
+            : _data{ (T*)Allocator::allocate(sizeof(T) * initialsz) }, _size{ initialsz }, _capacity{ initialsz }
         {
             Fill(_data, _data + _capacity, el);
         }
 
-        Vector(Vector<T, Sz, blocksz>&& source)
+        Vector(Vector<T, Sz, blocksz, Allocator>&& source)
             : _data{ source._data }, _size{ source._size }, _capacity{ source._capacity }
         {
             source._capacity = source._size = 0; source._data = nullptr;
         }
 
-        Vector& operator=(Vector<T, Sz, blocksz>&& source)
+        Vector& operator=(Vector<T, Sz, blocksz, Allocator>&& source)
         {
             _data = source._data; _size = source._size; _capacity = source._capacity;
             source._capacity = source._size = 0; source._data = nullptr;
@@ -178,11 +306,11 @@ namespace glimmer
             auto count = to - from;
             if (_data == nullptr)
             {
-                _data = (T*)AllocateFunc(sizeof(T) * count);
+                _data = (T*)Allocator::allocate(sizeof(T) * count);
             }
             else if (_capacity < count)
             {
-                auto ptr = (T*)ReallocateFunc(_data, sizeof(T) * count);
+                auto ptr = (T*)Allocator::reallocate(_data, sizeof(T) * _capacity, sizeof(T) * count);
                 assert(ptr != nullptr);
                 _data = ptr;
             }
@@ -200,11 +328,11 @@ namespace glimmer
         {
             if (_data == nullptr)
             {
-                _data = (T*)AllocateFunc(sizeof(T) * count);
+                _data = (T*)Allocator::allocate(sizeof(T) * count);
             }
             else if (_capacity < count)
             {
-                auto ptr = (T*)ReallocateFunc(_data, sizeof(T) * count);
+                auto ptr = (T*)Allocator::reallocate(_data, sizeof(T) * _capacity, sizeof(T) * count);
                 assert(ptr != nullptr);
                 _data = ptr;
             }
@@ -217,11 +345,11 @@ namespace glimmer
         {
             if (_data == nullptr)
             {
-                _data = (T*)AllocateFunc(sizeof(T) * count);
+                _data = (T*)Allocator::allocate(sizeof(T) * count);
             }
             else if (_capacity < count)
             {
-                auto ptr = (T*)ReallocateFunc(_data, sizeof(T) * count);
+                auto ptr = (T*)Allocator::reallocate(_data, sizeof(T) * _capacity, sizeof(T) * count);
                 assert(ptr != nullptr);
                 _data = ptr;
             }
@@ -242,7 +370,7 @@ namespace glimmer
 
             if (_capacity < targetsz)
             {
-                auto ptr = (T*)ReallocateFunc(_data, sizeof(T) * targetsz);
+                auto ptr = (T*)Allocator::reallocate(_data, sizeof(T) * _capacity, sizeof(T) * targetsz);
                 assert(ptr != nullptr);
                 _data = ptr;
                 _capacity = targetsz;
@@ -257,7 +385,7 @@ namespace glimmer
 
             if (_capacity < targetsz)
             {
-                auto ptr = (T*)ReallocateFunc(_data, sizeof(T) * targetsz);
+                auto ptr = (T*)Allocator::reallocate(_data, sizeof(T) * _capacity, sizeof(T) * targetsz);
                 assert(ptr != nullptr);
                 _data = ptr;
                 _capacity = targetsz;
@@ -287,7 +415,11 @@ namespace glimmer
         void pop_back(bool definit) { if constexpr (std::is_default_constructible_v<T>) if (definit) _data[_size - 1] = T{}; --_size; }
         void clear(bool definit) { if (definit) _default_init(0, _size); _size = 0; }
         void reset(const T& el) { Fill(_data, _data + _size, el); }
-        void shrink_to_fit() { _data = (T*)ReallocateFunc(_data, _size * sizeof(T)); _capacity = _size; }
+        void shrink_to_fit() { _data = (T*)Allocator::reallocate(_data, _capacity * sizeof(T), _size * sizeof(T)); _capacity = _size; }
+
+        // Give up the storage without destroying elements, required for frame allocated vectors
+        // which outlive the frame, as their memory is reclaimed in bulk
+        void release() { Allocator::deallocate(_data); _data = nullptr; _size = _capacity = 0; }
 
         Iterator begin() { return _data; }
         Iterator end() { return _data + _size; }
@@ -302,6 +434,7 @@ namespace glimmer
         T& back() { assert(_size > 0); return _data[_size - 1]; }
         T const& back() const { assert(_size > 0); return _data[_size - 1]; }
         T* data() { return _data; }
+        const T* data() const { return _data; }
 
         Sz size() const { return _size; }
         Sz capacity() const { return _capacity; }
@@ -325,14 +458,21 @@ namespace glimmer
         void _reallocate(bool initialize)
         {
             T* ptr = nullptr;
+            Sz grow = blocksz;
+
+            // Frame allocations are copied when they cannot grow in-place, which happens when
+            // vectors grow alternately, hence they grow geometrically to keep arena usage linear
+            if constexpr (std::is_same_v<Allocator, FrameAllocator>)
+                grow = std::max(blocksz, (Sz)std::min<int64_t>(_capacity, (int64_t)std::numeric_limits<Sz>::max() - _capacity));
+
             if (_size == _capacity) 
-                ptr = (T*)ReallocateFunc(_data, (_capacity + blocksz) * sizeof(T));
+                ptr = (T*)Allocator::reallocate(_data, _capacity * sizeof(T), (_capacity + grow) * sizeof(T));
 
             if (ptr != nullptr)
             {
                 _data = ptr;
-                if (initialize) _default_init(_capacity, _capacity + blocksz);
-                _capacity += blocksz;
+                if (initialize) _default_init(_capacity, _capacity + grow);
+                _capacity += grow;
             }
         }
 
@@ -428,9 +568,12 @@ namespace glimmer
     };
 
     template <typename T, typename Sz, Sz blocksz = 128>
+    using FrameVector = Vector<T, Sz, blocksz, FrameAllocator>;
+
+    template <typename T, typename Sz, Sz blocksz = 128, typename Allocator = HeapAllocator>
     struct DynamicStack
     {
-        using IteratorT = typename Vector<T, Sz, blocksz>::Iterator;
+        using IteratorT = typename Vector<T, Sz, blocksz, Allocator>::Iterator;
         static_assert(std::is_default_constructible_v<T>, "Element type must be default constructible");
 
         DynamicStack(Sz capacity, const T& el)
@@ -490,60 +633,1215 @@ namespace glimmer
 
     private:
 
-        Vector<T, Sz, blocksz> _data;
+        Vector<T, Sz, blocksz, Allocator> _data;
         Sz _max = 0;
     };
 
+    // Undo/redo history of operations, each with a byte payload of any size kept in an arena
+    // shared by all operations. The latest operation can be extended in-place to coalesce
+    // edits, and oldest history (except the latest operation) is discarded when records and
+    // payloads exceed the memory limit.
     template <typename T>
     struct UndoRedoStack
     {
-        Vector<T, int16_t> stack{ 16 };
-        int16_t pos = 0;
-        int16_t total = 0;
+        struct Record
+        {
+            T op;
+            int32_t offset = 0, size = 0; // Location of payload in arena
+        };
 
-        template <typename... ArgsT>
-        T& push(ArgsT&&... args)
+        using Entry = std::pair<T, std::string_view>;
+
+        explicit UndoRedoStack(int32_t limit = GLIMMER_TEXT_UNDO_MEMORY_LIMIT)
+            : _limit{ limit }
+        {}
+
+        // Record an operation, discarding operations which can be redone
+        void push(const T& op, std::string_view payload)
+        {
+            _truncate(_pos);
+            auto& record = _records.emplace_back();
+            record.op = op;
+            record.offset = _used;
+            record.size = (int32_t)payload.size();
+            _reserve(_used + record.size);
+            memcpy(_arena.data() + _used, payload.data(), payload.size());
+            _used += record.size;
+            _pos = _records.size();
+            _discard();
+        }
+
+        // Latest operation, if nothing has been undone since, which can be extended
+        T* latest() { return _pos > _first && _pos == _records.size() ? &(_records[_pos - 1].op) : nullptr; }
+
+        // Grow payload of the latest operation, at the front for text removed before it
+        void extend(std::string_view payload, bool atFront)
         {
-            if (pos == stack.size())
+            assert(latest() != nullptr);
+            auto& record = _records[_pos - 1];
+            auto count = (int32_t)payload.size();
+            _reserve(_used + count);
+
+            if (atFront)
             {
-                pos++;
-                total = pos;
-                return stack.emplace_back(std::forward<ArgsT>(args)...);
+                memmove(_arena.data() + record.offset + count, _arena.data() + record.offset, record.size);
+                memcpy(_arena.data() + record.offset, payload.data(), count);
             }
-            else
+            else memcpy(_arena.data() + record.offset + record.size, payload.data(), count);
+
+            record.size += count;
+            _used += count;
+            _discard();
+        }
+
+        std::optional<Entry> undo()
+        {
+            if (_pos == _first) return std::nullopt;
+            --_pos;
+            return _entry(_records[_pos]);
+        }
+
+        std::optional<Entry> redo()
+        {
+            if (_pos == _records.size()) return std::nullopt;
+            ++_pos;
+            return _entry(_records[_pos - 1]);
+        }
+
+        void limit(int32_t bytes) { _limit = bytes; _discard(); }
+        void clear() { _truncate(0); _used = _first = _pos = 0; }
+
+        // Bytes used by live records and their payloads
+        int32_t memory() const
+        {
+            auto count = _records.size() - _first;
+            return count == 0 ? 0 : (_used - _records[_first].offset) + count * (int32_t)sizeof(Record);
+        }
+
+        bool empty() const { return _pos == _first; }
+        bool canRedo() const { return _pos < _records.size(); }
+
+    private:
+
+        Entry _entry(const Record& record) const
+        {
+            return { record.op, std::string_view{ _arena.data() + record.offset, (std::size_t)record.size } };
+        }
+
+        void _reserve(int32_t bytes)
+        {
+            if (bytes > _arena.size())
+                _arena.resize(std::max(bytes, std::max(_arena.size() * 2, 256)), false);
+        }
+
+        void _truncate(int32_t count)
+        {
+            if (count < _records.size()) _used = _records[count].offset;
+            while (_records.size() > count) _records.pop_back(false);
+        }
+
+        // Drop oldest operations beyond the limit, and compact once half of the records are dead.
+        // Latest operation is always kept, even if its payload alone exceeds the limit.
+        void _discard()
+        {
+            while (_first + 1 < _records.size() && memory() > _limit) ++_first;
+            _pos = std::max(_pos, _first);
+
+            if (_first > 0 && _first * 2 >= _records.size())
             {
-                for (auto idx = pos; idx < stack.size(); ++idx)
-                    stack[idx].~T();
-                ::new (&(stack[pos])) T{ std::forward<ArgsT>(args)... };
-                pos++;
-                total = pos;
-                return stack[pos - 1];
+                auto base = _first < _records.size() ? _records[_first].offset : _used;
+                memmove(_arena.data(), _arena.data() + base, _used - base);
+                _used -= base;
+
+                auto count = _records.size() - _first;
+                for (auto idx = 0; idx < count; ++idx)
+                {
+                    _records[idx] = _records[idx + _first];
+                    _records[idx].offset -= base;
+                }
+
+                while (_records.size() > count) _records.pop_back(false);
+                _pos -= _first;
+                _first = 0;
             }
         }
 
-        T& top() { return stack.back(); }
+        Vector<Record, int32_t> _records{ false };
+        Vector<char, int32_t> _arena{ false };
+        int32_t _used = 0, _first = 0, _pos = 0;
+        int32_t _limit = GLIMMER_TEXT_UNDO_MEMORY_LIMIT;
+    };
+
+    // Fenwick tree over a sequence of values, point updates and prefix sums are O(log n)
+    // and so is locating the element which contains a given offset into the sequence
+    template <typename T, typename Sz>
+    struct PrefixSumTree
+    {
+        static_assert(std::is_arithmetic_v<T>, "T must be an arithmetic type");
+
+        void resize(Sz count, const T& value)
+        {
+            if (count > _values.size()) _values.resize(count, value);
+            else _values.resize(count, false);
+            _tree.resize(count + 1, false);
+            _rebuild();
+        }
+
+        void update(Sz idx, const T& value)
+        {
+            auto delta = value - _values[idx];
+            _values[idx] = value;
+
+            // Rounding errors of floating point deltas accumulate in the nodes, they are
+            // rebuilt from values once there have been as many updates as values
+            if constexpr (std::is_floating_point_v<T>)
+                if (++_updates > _values.size())
+                {
+                    _rebuild();
+                    return;
+                }
+
+            for (Sz pos = idx + 1; pos <= _values.size(); pos += (pos & -pos))
+                _tree[pos] += delta;
+        }
+
+        // Sum of first `count` elements
+        T prefix(Sz count) const
+        {
+            T sum{};
+            for (Sz pos = count; pos > 0; pos -= (pos & -pos))
+                sum += _tree[pos];
+            return sum;
+        }
+
+        // Index of the element whose span [prefix(idx), prefix(idx + 1)) contains offset,
+        // offsets beyond the total are clamped to the last element
+        Sz find(T offset) const
+        {
+            const auto count = _values.size();
+            Sz pos = 0, step = 1;
+            while ((step << 1) <= count) step <<= 1;
+
+            for (; step > 0; step >>= 1)
+                if (pos + step <= count && _tree[pos + step] <= offset)
+                {
+                    pos += step;
+                    offset -= _tree[pos];
+                }
+
+            return pos < count ? pos : std::max<Sz>(count - 1, 0);
+        }
+
+        // Grow to `count` elements, where existing values move (in order) to the indexes for
+        // which keep(idx) is true, and the other indexes get value. O(n)
+        template <typename PredT>
+        void spread(Sz count, const T& value, PredT&& keep)
+        {
+            auto src = _values.size();
+            assert(count >= src);
+            _values.resize(count, value);
+
+            // Values only move towards the end, hence filling from the end does not overwrite
+            for (Sz idx = count - 1; idx >= 0; --idx)
+                _values[idx] = keep(idx) && src > 0 ? _values[--src] : value;
+
+            _tree.resize(count + 1, false);
+            _rebuild();
+        }
+
+        // Move `count` values from index `from` to index `to`, indexes left behind get value. O(n)
+        void move(Sz from, Sz to, Sz count, const T& value)
+        {
+            auto data = _values.data();
+            std::memmove(data + to, data + from, sizeof(T) * count);
+            auto vacated = to > from ? std::min(from + count, to) : from + count;
+            for (auto idx = to > from ? from : std::max(to + count, from); idx < vacated; ++idx)
+                data[idx] = value;
+            _rebuild();
+        }
+
+        T total() const { return prefix(_values.size()); }
+        const T& operator[](Sz idx) const { return _values[idx]; }
+        Sz size() const { return _values.size(); }
+        bool empty() const { return _values.empty(); }
+        int64_t memory() const { return (int64_t)(_values.capacity() + _tree.capacity()) * (int64_t)sizeof(T); }
+
+    private:
+
+        void _rebuild()
+        {
+            const auto count = _values.size();
+            _updates = 0;
+            _tree[0] = T{};
+            for (Sz pos = 1; pos <= count; ++pos) _tree[pos] = _values[pos - 1];
+            for (Sz pos = 1; pos <= count; ++pos)
+            {
+                Sz parent = pos + (pos & -pos);
+                if (parent <= count) _tree[parent] += _tree[pos];
+            }
+        }
+
+        Vector<T, Sz> _values{ false };
+        Vector<T, Sz> _tree{ false };
+        Sz _updates = 0; // Since last rebuild
+    };
+
+    // Sequence of values kept in a PrefixSumTree with a gap (run of zero valued slots) at the
+    // last edit position. Insertions and removals at the gap, prefix sums and offset lookups
+    // are O(log n), moving the gap by k elements costs O(min(k log n, n)).
+    template <typename T, typename Sz>
+    struct GapPrefixSumTree
+    {
+        void insert(Sz idx, const T& value)
+        {
+            if (_gaplen == 0) _grow();
+            _moveGap(idx);
+            _tree.update(_gapstart, value);
+            ++_gapstart; --_gaplen;
+        }
+
+        void erase(Sz idx, Sz count)
+        {
+            _moveGap(idx);
+            for (Sz slot = _gapstart + _gaplen; slot < _gapstart + _gaplen + count; ++slot)
+                _tree.update(slot, T{});
+            _gaplen += count;
+        }
+
+        void update(Sz idx, const T& value) { _tree.update(_slot(idx), value); }
+
+        void clear()
+        {
+            _tree.resize(0, T{});
+            _gapstart = _gaplen = 0;
+        }
+
+        // Sum of first `count` elements
+        T prefix(Sz count) const { return count <= 0 ? T{} : _tree.prefix(_slot(count - 1) + 1); }
+
+        // Index of the element whose span contains offset, offsets beyond the total are
+        // clamped to the last element
+        Sz find(T offset) const
+        {
+            if (size() == 0) return 0;
+            auto slot = _tree.find(offset);
+            auto idx = slot < _gapstart ? slot : slot < _gapstart + _gaplen ? _gapstart : slot - _gaplen;
+            return std::min<Sz>(idx, size() - 1);
+        }
+
+        T total() const { return _tree.total(); }
+        T operator[](Sz idx) const { return _tree[_slot(idx)]; }
+        Sz size() const { return _tree.size() - _gaplen; }
+        int64_t memory() const { return _tree.memory(); }
+        bool empty() const { return size() == 0; }
+
+    private:
+
+        Sz _slot(Sz idx) const { return idx < _gapstart ? idx : idx + _gaplen; }
+
+        void _moveGap(Sz idx)
+        {
+            // Far moves shift the values and rebuild the tree instead of updating each one
+            auto distance = idx > _gapstart ? idx - _gapstart : _gapstart - idx;
+            Sz depth = 1;
+            for (auto count = _tree.size(); count > 1; count >>= 1) ++depth;
+
+            if (distance * 2 * depth > _tree.size())
+            {
+                if (idx < _gapstart) _tree.move(idx, idx + _gaplen, _gapstart - idx, T{});
+                else _tree.move(_gapstart + _gaplen, _gapstart, idx - _gapstart, T{});
+                _gapstart = idx;
+                return;
+            }
+
+            for (; _gapstart > idx; --_gapstart)
+            {
+                auto value = _tree[_gapstart - 1];
+                _tree.update(_gapstart - 1, T{});
+                _tree.update(_gapstart + _gaplen - 1, value);
+            }
+
+            for (; _gapstart < idx; ++_gapstart)
+            {
+                auto value = _tree[_gapstart + _gaplen];
+                _tree.update(_gapstart + _gaplen, T{});
+                _tree.update(_gapstart, value);
+            }
+        }
+
+        // Double the slots, the new slots become the gap at the end
+        void _grow()
+        {
+            _moveGap(size());
+            auto count = _tree.size();
+            _tree.resize(std::max<Sz>(count * 2, 16), T{});
+            _gaplen += _tree.size() - count;
+        }
+
+        PrefixSumTree<T, Sz> _tree;
+        Sz _gapstart = 0, _gaplen = 0;
+    };
+
+    // Formatted text of cells for a window of rows, the slot of a cell is (row % rows) * cols + col.
+    // Text handed out is referenced by deferred draw commands till the end of the frame, hence a
+    // row whose slot was handed out to another row in the same frame (rows of a sorted or filtered
+    // window can be congruent modulo rows) is formatted into frame memory, keeping the slot as is.
+    template <int32_t textsz>
+    struct FormattedTextCache
+    {
+        // Text of a cell, format(buffer, size) writes it and returns its length if not cached
+        template <typename FormatT>
+        std::string_view get(int32_t row, int32_t col, uint64_t version, int32_t frame, FormatT&& format)
+        {
+            auto& slot = _slots[(row % _rows) * _cols + col];
+            if (slot.row != row || slot.version != version)
+            {
+                if (slot.frame == frame && slot.version == version)
+                {
+                    auto buffer = static_cast<char*>(FrameMemory.allocate(textsz));
+                    return std::string_view{ buffer, (size_t)format(buffer, textsz) };
+                }
+
+                slot.length = (int16_t)format(slot.text, textsz);
+                slot.row = row;
+                slot.version = version;
+            }
+
+            slot.frame = frame;
+            return std::string_view{ slot.text, (size_t)slot.length };
+        }
+
+        // Discard all text, keeping slots for rows * cols cells
+        void reset(int32_t rows, int32_t cols)
+        {
+            _rows = rows; _cols = cols;
+            _slots.clear(false);
+            _slots.resize(rows * cols, true);
+        }
+
+        bool fits(int32_t rows, int32_t cols) const { return _rows == rows && _cols == cols && !_slots.empty(); }
+        void clear() { _slots.clear(false); }
+        int64_t memory() const { return (int64_t)_slots.capacity() * (int64_t)sizeof(Slot); }
+
+    private:
+
+        struct Slot
+        {
+            uint64_t version = 0;
+            int32_t row = -1;
+            int32_t frame = -1; // Frame in which the text was last handed out
+            int16_t length = 0;
+            char text[textsz];
+        };
+
+        Vector<Slot, int32_t> _slots{ false };
+        int32_t _rows = 0, _cols = 0;
+    };
+
+    // Characters with a gap (unused run) at the last edit position, so that edits near each other
+    // cost O(1) amortized and moving the gap by k characters costs O(k). Reads of a range which
+    // spans the gap move the gap out of it, towards the nearer end of the range.
+    struct TextGapBuffer
+    {
+        void insert(int32_t pos, std::string_view text)
+        {
+            auto count = (int32_t)text.size();
+            if (_gaplen < count) _grow(count);
+            _moveGap(pos);
+            std::memcpy(_chars.data() + _gapstart, text.data(), text.size());
+            _gapstart += count; _gaplen -= count; ++_edits;
+        }
+
+        void erase(int32_t pos, int32_t count)
+        {
+            _moveGap(pos);
+            _gaplen += count; ++_edits;
+        }
+
+        void assign(std::string_view text)
+        {
+            clear();
+            insert(0, text);
+        }
+
+        void clear()
+        {
+            _gapstart = 0;
+            _gaplen = (int32_t)_chars.size(); ++_edits;
+        }
+
+        void reserve(int32_t count) { if (count > size() + _gaplen) _grow(count - size()); }
+        void set(int32_t idx, char ch) { _chars[_index(idx)] = ch; ++_edits; }
+
+        // Characters [from, from + count)
+        std::string_view view(int32_t from, int32_t count) const
+        {
+            if (from < _gapstart && from + count > _gapstart)
+                _moveGap(_gapstart - from < from + count - _gapstart ? from : from + count);
+            return std::string_view{ _chars.data() + (count > 0 ? _index(from) : 0), (size_t)count };
+        }
+
+        std::string_view view() const { return view(0, size()); }
+        char operator[](int32_t idx) const { return _chars[_index(idx)]; }
+        int32_t size() const { return (int32_t)_chars.size() - _gaplen; }
+        bool empty() const { return size() == 0; }
+        int64_t memory() const { return (int64_t)_chars.capacity(); }
+
+        // Changes on every modification, compare to tell if the text was edited since
+        uint32_t edits() const { return _edits; }
+
+    private:
+
+        int32_t _index(int32_t idx) const { return idx < _gapstart ? idx : idx + _gaplen; }
+
+        void _moveGap(int32_t pos) const
+        {
+            auto data = _chars.data();
+            if (pos < _gapstart) std::memmove(data + pos + _gaplen, data + pos, (size_t)(_gapstart - pos));
+            else if (pos > _gapstart) std::memmove(data + _gapstart, data + _gapstart + _gaplen, (size_t)(pos - _gapstart));
+            _gapstart = pos;
+        }
+
+        // Gap is moved to the end and grown to at least count, capacity at least doubles
+        void _grow(int32_t count)
+        {
+            _moveGap(size());
+            auto used = size();
+            _chars.resize(std::max<size_t>({ _chars.size() * 2, (size_t)(used + count), 64 }));
+            _gaplen = (int32_t)_chars.size() - used;
+        }
+
+        // Reads move the gap, which leaves the text the same
+        mutable std::vector<char> _chars;
+        mutable int32_t _gapstart = 0;
+        int32_t _gaplen = 0;
+        uint32_t _edits = 0;
+    };
+
+    // Open addressing hash table keyed by hashes computed in advance (i.e. at compile time).
+    // Keys are non-zero, slots are probed linearly and the table is kept under 3/4 full.
+    template <typename V, typename Sz>
+    struct PrehashedTable
+    {
+        V* find(uint64_t key)
+        {
+            if (_count == 0) return nullptr;
+            const auto mask = _slots.size() - 1;
+            for (auto idx = _index(key, mask); _slots[idx].key != 0; idx = (idx + 1) & mask)
+                if (_slots[idx].key == key) return &_slots[idx].value;
+            return nullptr;
+        }
+
+        V& insert(uint64_t key, const V& value)
+        {
+            assert(key != 0);
+            if ((_count + 1) * 4 > _slots.size() * 3) _grow();
+
+            const auto mask = _slots.size() - 1;
+            auto idx = _index(key, mask);
+            while (_slots[idx].key != 0 && _slots[idx].key != key) idx = (idx + 1) & mask;
+            if (_slots[idx].key == 0) ++_count;
+
+            _slots[idx].key = key;
+            _slots[idx].value = value;
+            return _slots[idx].value;
+        }
+
+        // Remove entries for which pred(value) holds, the table is resized to fit the rest
+        template <typename PredT>
+        void eraseIf(PredT pred)
+        {
+            auto old = std::move(_slots);
+            _count = 0;
+
+            for (auto& slot : old)
+                if (slot.key != 0 && pred(slot.value)) slot.key = 0;
+            for (const auto& slot : old)
+                if (slot.key != 0) insert(slot.key, slot.value);
+        }
+
+        void clear() { _slots.reset(Slot{}); _count = 0; }
+        Sz size() const { return _count; }
+
+    private:
 
-        std::optional<T> undo()
+        struct Slot
         {
-            if (pos == 0) return std::nullopt;
+            uint64_t key = 0;
+            V value{};
+        };
+
+        static Sz _index(uint64_t key, Sz mask) { return (Sz)((key ^ (key >> 31)) & (uint64_t)mask); }
+
+        void _grow()
+        {
+            auto old = std::move(_slots);
+            _slots = Vector<Slot, Sz>{ std::max<Sz>(old.size() * 2, 16), Slot{} };
+            _count = 0;
+            for (const auto& slot : old)
+                if (slot.key != 0) insert(slot.key, slot.value);
+        }
+
+        Vector<Slot, Sz> _slots{ false };
+        Sz _count = 0;
+    };
+
+    // Minimum and maximum of values over buckets of consecutive values, level 0 buckets span
+    // `bucket` values and buckets of each next level span two buckets of the previous one.
+    // Mins and maxs are kept in separate arrays, float and double values are reduced with SSE2
+    // where available (compilers do not vectorize these reductions themselves) and other types
+    // with scalar loops. Updating a range of values costs O(range + levels).
+    template <typename T, typename Sz = int32_t>
+    struct MinMaxPyramid
+    {
+        static constexpr int MaxLevels = 32;
+
+        explicit MinMaxPyramid(Sz bucket = GLIMMER_CHART_PYRAMID_BUCKET)
+            : _bucket{ bucket }
+        {}
+
+        void build(const T* values, Sz count)
+        {
+            _levels = 0;
+            update(values, 0, count);
+        }
+
+        // Recompute buckets which cover values in [from, count), count is the total number of values
+        void update(const T* values, Sz from, Sz count)
+        {
+            update(values, from, count, count);
+        }
+
+        // Recompute buckets which cover values in [from, to), count is the total number of values
+        void update(const T* values, Sz from, Sz to, Sz count)
+        {
+            _count = count;
+            auto first = from / _bucket;
+            auto last = (to + _bucket - 1) / _bucket;
+            auto total = (count + _bucket - 1) / _bucket;
+            auto& base = _data[0];
+            base.mins.resize(total);
+            base.maxs.resize(total);
+
+            for (auto bidx = first; bidx < last; ++bidx)
+            {
+                auto start = bidx * _bucket, end = std::min(start + _bucket, count);
+                _reduce(values, start, end, base.mins[bidx], base.maxs[bidx]);
+            }
+
+            _levels = total > 0 ? 1 : 0;
+
+            for (; _levels < MaxLevels && total > 1; ++_levels)
+            {
+                auto& prev = _data[_levels - 1];
+                auto& curr = _data[_levels];
+                auto prevtotal = total;
+                first /= 2;
+                last = (last + 1) / 2;
+                total = (total + 1) / 2;
+                curr.mins.resize(total);
+                curr.maxs.resize(total);
+
+                // Pairs are reduced first, which leaves a trailing odd bucket
+                auto pairs = std::min(prevtotal / 2, last);
+                _reducePairs(prev, curr, first, pairs);
+
+                if (pairs < last && pairs == prevtotal / 2)
+                {
+                    curr.mins[pairs] = prev.mins[2 * pairs];
+                    curr.maxs[pairs] = prev.maxs[2 * pairs];
+                }
+            }
+        }
+
+        // Minimum and maximum of values in [from, to), values outside whole buckets are read
+        // directly, hence it costs O(bucket + levels)
+        std::pair<T, T> range(const T* values, Sz from, Sz to) const
+        {
+            assert(from < to && to <= _count);
+            T lo = values[from], hi = values[from];
+            auto take = [&lo, &hi](T vmin, T vmax) {
+                lo = std::min(lo, vmin);
+                hi = std::max(hi, vmax);
+            };
+
+            for (; from < to && from % _bucket != 0; ++from) take(values[from], values[from]);
+            for (; to > from && to % _bucket != 0; --to) take(values[to - 1], values[to - 1]);
+
+            auto bfrom = from / _bucket, bto = to / _bucket;
+            for (Sz level = 0; bfrom < bto && level < _levels; ++level)
+            {
+                if (bfrom & 1) { take(min(level, bfrom), max(level, bfrom)); ++bfrom; }
+                if (bfrom < bto && (bto & 1)) { --bto; take(min(level, bto), max(level, bto)); }
+                bfrom /= 2;
+                bto /= 2;
+            }
+
+            return { lo, hi };
+        }
+
+        void clear() { _count = 0; _levels = 0; }
+
+        Sz levels() const { return _levels; }
+        Sz size() const { return _count; }
+        Sz bucket(Sz level) const { return _bucket << level; }
+        Sz buckets(Sz level) const { return (Sz)_data[level].mins.size(); }
+        T min(Sz level, Sz idx) const { return _data[level].mins[idx]; }
+        T max(Sz level, Sz idx) const { return _data[level].maxs[idx]; }
+
+        int64_t memory() const
+        {
+            int64_t total = 0;
+            for (auto level = 0; level < MaxLevels; ++level)
+                total += (int64_t)(_data[level].mins.capacity() + _data[level].maxs.capacity()) * (int64_t)sizeof(T);
+            return total;
+        }
+
+    private:
+
+        struct Level
+        {
+            std::vector<T> mins;
+            std::vector<T> maxs;
+        };
+
+        // Min/max of values[start, end) into lo and hi, vector lanes are reduced independently and
+        // combined at the end. The argument order of SSE min/max matches std::min/std::max.
+        static void _reduce(const T* values, Sz start, Sz end, T& lo, T& hi)
+        {
+            auto idx = start;
+            lo = hi = values[start];
+
+#ifdef GLIMMER_SSE2
+            constexpr Sz Lanes = std::is_same_v<T, float> ? 4 : std::is_same_v<T, double> ? 2 : 0;
+            if constexpr (Lanes > 0)
+            {
+                if (end - start >= Lanes)
+                {
+                    T los[Lanes], his[Lanes];
+
+                    if constexpr (std::is_same_v<T, float>)
+                    {
+                        auto vlo = _mm_set1_ps(lo), vhi = vlo;
+                        for (; idx + Lanes <= end; idx += Lanes)
+                        {
+                            auto v = _mm_loadu_ps(values + idx);
+                            vlo = _mm_min_ps(v, vlo);
+                            vhi = _mm_max_ps(v, vhi);
+                        }
+                        _mm_storeu_ps(los, vlo);
+                        _mm_storeu_ps(his, vhi);
+                    }
+                    else
+                    {
+                        auto vlo = _mm_set1_pd(lo), vhi = vlo;
+                        for (; idx + Lanes <= end; idx += Lanes)
+                        {
+                            auto v = _mm_loadu_pd(values + idx);
+                            vlo = _mm_min_pd(v, vlo);
+                            vhi = _mm_max_pd(v, vhi);
+                        }
+                        _mm_storeu_pd(los, vlo);
+                        _mm_storeu_pd(his, vhi);
+                    }
+
+                    for (Sz lane = 0; lane < Lanes; ++lane)
+                    {
+                        lo = std::min(lo, los[lane]);
+                        hi = std::max(hi, his[lane]);
+                    }
+                }
+            }
+#endif
+
+            for (; idx < end; ++idx)
+            {
+                lo = std::min(lo, values[idx]);
+                hi = std::max(hi, values[idx]);
+            }
+        }
+
+        // Buckets [first, pairs) of curr from pairs of buckets of prev, even and odd buckets of
+        // prev are separated with shuffles so that each vector holds results of whole lanes
+        static void _reducePairs(const Level& prev, Level& curr, Sz first, Sz pairs)
+        {
+            auto bidx = first;
+
+#ifdef GLIMMER_SSE2
+            if constexpr (std::is_same_v<T, float>)
+            {
+                for (; bidx + 4 <= pairs; bidx += 4)
+                {
+                    auto lo0 = _mm_loadu_ps(prev.mins.data() + 2 * bidx), lo1 = _mm_loadu_ps(prev.mins.data() + 2 * bidx + 4);
+                    auto hi0 = _mm_loadu_ps(prev.maxs.data() + 2 * bidx), hi1 = _mm_loadu_ps(prev.maxs.data() + 2 * bidx + 4);
+                    _mm_storeu_ps(curr.mins.data() + bidx, _mm_min_ps(_mm_shuffle_ps(lo0, lo1, _MM_SHUFFLE(3, 1, 3, 1)),
+                        _mm_shuffle_ps(lo0, lo1, _MM_SHUFFLE(2, 0, 2, 0))));
+                    _mm_storeu_ps(curr.maxs.data() + bidx, _mm_max_ps(_mm_shuffle_ps(hi0, hi1, _MM_SHUFFLE(3, 1, 3, 1)),
+                        _mm_shuffle_ps(hi0, hi1, _MM_SHUFFLE(2, 0, 2, 0))));
+                }
+            }
+            else if constexpr (std::is_same_v<T, double>)
+            {
+                for (; bidx + 2 <= pairs; bidx += 2)
+                {
+                    auto lo0 = _mm_loadu_pd(prev.mins.data() + 2 * bidx), lo1 = _mm_loadu_pd(prev.mins.data() + 2 * bidx + 2);
+                    auto hi0 = _mm_loadu_pd(prev.maxs.data() + 2 * bidx), hi1 = _mm_loadu_pd(prev.maxs.data() + 2 * bidx + 2);
+                    _mm_storeu_pd(curr.mins.data() + bidx, _mm_min_pd(_mm_shuffle_pd(lo0, lo1, 3), _mm_shuffle_pd(lo0, lo1, 0)));
+                    _mm_storeu_pd(curr.maxs.data() + bidx, _mm_max_pd(_mm_shuffle_pd(hi0, hi1, 3), _mm_shuffle_pd(hi0, hi1, 0)));
+                }
+            }
+#endif
+
+            for (; bidx < pairs; ++bidx)
+            {
+                curr.mins[bidx] = std::min(prev.mins[2 * bidx], prev.mins[2 * bidx + 1]);
+                curr.maxs[bidx] = std::max(prev.maxs[2 * bidx], prev.maxs[2 * bidx + 1]);
+            }
+        }
+
+        Level _data[MaxLevels];
+        Sz _bucket = 8;
+        Sz _count = 0;
+        Sz _levels = 0;
+    };
+
+    // Objects per index which are only constructed on first access, for states which are large
+    // but needed by few indexes. Unaccessed indexes cost a null pointer.
+    template <typename T, typename Sz = int32_t>
+    struct LazyArray
+    {
+        T& operator[](Sz idx)
+        {
+            if (idx >= (Sz)_items.size()) _items.resize(idx + 1);
+            auto& item = _items[idx];
+            if (!item) { item = std::make_unique<T>(); ++_allocated; }
+            return *item;
+        }
+
+        const T* find(Sz idx) const { return idx < (Sz)_items.size() ? _items[idx].get() : nullptr; }
+
+        void reset(Sz idx)
+        {
+            if (idx < (Sz)_items.size() && _items[idx])
+            {
+                _items[idx].reset();
+                --_allocated;
+            }
+        }
+
+        void resize(Sz count) { if (count > (Sz)_items.size()) _items.resize(count); }
+        void clear() { for (auto& item : _items) item.reset(); _allocated = 0; }
+        Sz size() const { return (Sz)_items.size(); }
+        Sz allocated() const { return _allocated; }
+
+        template <typename FuncT>
+        void forEach(FuncT&& func) const
+        {
+            for (const auto& item : _items)
+                if (item) func(*item);
+        }
+
+    private:
+
+        std::vector<std::unique_ptr<T>> _items;
+        Sz _allocated = 0;
+    };
+
+    // Index allocator of a slot map. Released indexes are reused and carry a generation which
+    // is bumped on release, hence handles to released slots can be detected. Live indexes are
+    // kept densely packed for iteration, along with the frame in which they were last used.
+    // Slots marked transient are the ones which may be released once they go unused.
+    template <typename Sz>
+    struct SlotAllocator
+    {
+        struct Handle
+        {
+            Sz index = -1;
+            uint32_t generation = 0;
+        };
+
+        Sz acquire(int32_t frame)
+        {
+            Sz index = 0;
+
+            if (!_free.empty())
+            {
+                index = _free[_free.size() - 1];
+                _free.pop_back(false);
+            }
             else
             {
-                pos--; total--;
-                return stack[pos];
+                index = _slots.size();
+                _slots.emplace_back();
+            }
+
+            _slots[index].dense = _dense.size();
+            _slots[index].used = frame;
+            _slots[index].transient = false;
+            _dense.push_back(index);
+            return index;
+        }
+
+        bool release(Sz index)
+        {
+            if (!live(index)) return false;
+
+            auto& slot = _slots[index];
+            auto last = _dense[_dense.size() - 1];
+            _dense[slot.dense] = last;
+            _slots[last].dense = slot.dense;
+            _dense.pop_back(false);
+
+            slot.dense = -1;
+            ++slot.generation;
+            _free.push_back(index);
+            return true;
+        }
+
+        void touch(Sz index, int32_t frame) { if (index < _slots.size()) _slots[index].used = frame; }
+        void transient(Sz index) { if (live(index)) _slots[index].transient = true; }
+        bool unused(Sz index, int32_t frame, int32_t frames) const { return _slots[index].transient && frame - _slots[index].used > frames; }
+
+        bool live(Sz index) const { return index >= 0 && index < _slots.size() && _slots[index].dense != -1; }
+        bool valid(Handle handle) const { return live(handle.index) && _slots[handle.index].generation == handle.generation; }
+        Handle handle(Sz index) const { return Handle{ index, index < _slots.size() ? _slots[index].generation : 0u }; }
+
+        // Live indexes in no particular order
+        Sz operator[](Sz pos) const { return _dense[pos]; }
+        const Sz* begin() const { return _dense.begin(); }
+        const Sz* end() const { return _dense.end(); }
+        Sz size() const { return _dense.size(); }
+
+    private:
+
+        struct Slot
+        {
+            Sz dense = -1; // Position in _dense, -1 if slot is free
+            uint32_t generation = 0;
+            int32_t used = 0;
+            bool transient = false;
+        };
+
+        Vector<Slot, Sz> _slots{ false };
+        Vector<Sz, Sz> _dense{ false };
+        Vector<Sz, Sz> _free{ false };
+    };
+
+    // Strings copied into fixed size pages, each page counts the live strings in it and is
+    // recycled once all of them are released. Strings larger than a page get a page of their own.
+    template <int32_t pagesz>
+    struct PagedStringArena
+    {
+        ~PagedStringArena()
+        {
+            for (auto& page : _pages) std::free(page.data);
+        }
+
+        // Copy of the string and the page it is stored in
+        std::pair<std::string_view, int32_t> store(std::string_view str)
+        {
+            auto sz = (int32_t)str.size();
+            if (_current == -1 || _pages[_current].used + sz > _pages[_current].capacity)
+            {
+                // Current page without strings is only free once it stops being current
+                if (_current != -1 && _pages[_current].live == 0) _recycle(_current);
+                _current = _acquire(std::max(sz, pagesz));
             }
+
+            auto& page = _pages[_current];
+            auto dest = page.data + page.used;
+            if (sz > 0) memcpy(dest, str.data(), sz);
+            page.used += sz;
+            ++page.live;
+            return { std::string_view{ dest, (std::size_t)sz }, _current };
+        }
+
+        // Another reference to a string in the page
+        void retain(int32_t page) { ++_pages[page].live; }
+
+        // Release all strings at once, pages are kept for reuse
+        void clear()
+        {
+            _free.clear(false);
+            for (auto idx = 0; idx < _pages.size(); ++idx)
+            {
+                _pages[idx].used = _pages[idx].live = 0;
+                _free.push_back(idx);
+            }
+            _current = -1;
+        }
+
+        void release(int32_t page)
+        {
+            auto& target = _pages[page];
+            assert(target.live > 0);
+            if (--target.live > 0) return;
+
+            target.used = 0;
+            if (page != _current) _recycle(page);
         }
 
-        std::optional<T> redo()
+        // Bytes allocated for pages
+        int64_t memory() const
         {
-            if (pos == total) return std::nullopt;
+            int64_t total = 0;
+            for (const auto& page : _pages) total += page.capacity;
+            return total;
+        }
+
+    private:
+
+        struct Page
+        {
+            char* data = nullptr;
+            int32_t used = 0, capacity = 0, live = 0;
+        };
+
+        // Oversized pages are freed, others are kept for reuse
+        void _recycle(int32_t index)
+        {
+            auto& page = _pages[index];
+            if (page.capacity > pagesz)
+            {
+                std::free(page.data);
+                page.data = nullptr;
+                page.capacity = 0;
+            }
+
+            _free.push_back(index);
+        }
+
+        int32_t _acquire(int32_t sz)
+        {
+            int32_t index = -1;
+
+            if (!_free.empty())
+            {
+                index = _free[_free.size() - 1];
+                _free.pop_back(false);
+            }
             else
             {
-                pos++;
-                return stack[pos];
+                index = _pages.size();
+                _pages.emplace_back();
+            }
+
+            auto& page = _pages[index];
+            if (page.capacity < sz)
+            {
+                std::free(page.data);
+                page.data = (char*)std::malloc(sz);
+                page.capacity = sz;
+                assert(page.data != nullptr);
+            }
+
+            return index;
+        }
+
+        Vector<Page, int32_t, 16> _pages{ false };
+        Vector<int32_t, int32_t, 16> _free{ false };
+        int32_t _current = -1;
+    };
+
+    // Set of integral values stored as sorted, disjoint and non-adjacent closed intervals.
+    // Membership tests are O(log n) and the set can be inverted in O(1), in which case the
+    // intervals record the values which are excluded. Values are expected to be non-negative.
+    template <typename T, typename Sz>
+    struct IntervalSet
+    {
+        static_assert(std::is_integral_v<T>, "T must be an integral type");
+
+        struct Interval
+        {
+            T from = 0, to = 0;
+        };
+
+        // Iterates over the values present in the set within [0, limit)
+        struct Iterator
+        {
+            const IntervalSet* set = nullptr;
+            T current = 0;
+            T limit = 0;
+
+            T operator*() const { return current; }
+            Iterator& operator++() { current = set->_next(current + 1, limit); return *this; }
+            bool operator!=(const Iterator& other) const { return current != other.current; }
+        };
+
+        struct ValueRange
+        {
+            const IntervalSet* set = nullptr;
+            T limit = 0;
+
+            Iterator begin() const { return Iterator{ set, set->_next(0, limit), limit }; }
+            Iterator end() const { return Iterator{ set, limit, limit }; }
+        };
+
+        bool contains(T value) const
+        {
+            auto idx = _lowerBound(value);
+            auto found = idx < _ranges.size() && _ranges[idx].from <= value;
+            return found != _inverted;
+        }
+
+        void insert(T from, T to) { _inverted ? _remove(from, to) : _add(from, to); }
+        void erase(T from, T to) { _inverted ? _add(from, to) : _remove(from, to); }
+        void clear() { _ranges.clear(false); _inverted = false; }
+        void fill() { _ranges.clear(false); _inverted = true; }
+        void invert() { _inverted = !_inverted; }
+
+        // Move values down by delta, values which become negative are dropped
+        void shift(T delta)
+        {
+            Sz kept = 0;
+            for (Sz idx = 0; idx < _ranges.size(); ++idx)
+            {
+                if (_ranges[idx].to < delta) continue;
+                _ranges[kept].from = std::max<T>(_ranges[idx].from - delta, 0);
+                _ranges[kept].to = _ranges[idx].to - delta;
+                ++kept;
+            }
+
+            while (_ranges.size() > kept) _ranges.pop_back(false);
+        }
+
+        // Number of values present within [0, limit)
+        T count(T limit) const
+        {
+            T total = 0;
+            for (Sz idx = 0; idx < _ranges.size(); ++idx)
+            {
+                auto from = std::max<T>(_ranges[idx].from, 0), to = std::min<T>(_ranges[idx].to, limit - 1);
+                if (to >= from) total += to - from + 1;
             }
+
+            return _inverted ? limit - total : total;
         }
 
-        bool empty() const { return total == 0; }
+        ValueRange values(T limit) const { return ValueRange{ this, limit }; }
+        const Interval& interval(Sz idx) const { return _ranges[idx]; }
+        Sz intervals() const { return _ranges.size(); }
+        bool inverted() const { return _inverted; }
+        bool empty() const { return _ranges.empty() && !_inverted; }
+
+    private:
+
+        // First interval which ends at or after value
+        Sz _lowerBound(T value) const
+        {
+            Sz low = 0, high = _ranges.size();
+            while (low < high)
+            {
+                auto mid = low + ((high - low) / 2);
+                if (_ranges[mid].to < value) low = mid + 1;
+                else high = mid;
+            }
+            return low;
+        }
+
+        // Smallest value present in the set which is >= from, or limit
+        T _next(T from, T limit) const
+        {
+            if (from >= limit) return limit;
+            auto idx = _lowerBound(from);
+
+            if (!_inverted)
+                return idx < _ranges.size() ? std::min(std::max(from, _ranges[idx].from), limit) : limit;
+            return (idx < _ranges.size() && _ranges[idx].from <= from) ? std::min<T>(_ranges[idx].to + 1, limit) : from;
+        }
+
+        void _add(T from, T to)
+        {
+            auto start = _lowerBound(from > 0 ? from - 1 : from), end = start;
+            while (end < _ranges.size() && _ranges[end].from <= to + 1)
+            {
+                from = std::min(from, _ranges[end].from);
+                to = std::max(to, _ranges[end].to);
+                ++end;
+            }
+
+            Interval merged{ from, to };
+            _splice(start, end, &merged, 1);
+        }
+
+        void _remove(T from, T to)
+        {
+            auto idx = _lowerBound(from);
+            while (idx < _ranges.size() && _ranges[idx].from <= to)
+            {
+                auto current = _ranges[idx];
+                if (current.from < from && current.to > to)
+                {
+                    Interval split[2] = { { current.from, from - 1 }, { to + 1, current.to } };
+                    _splice(idx, idx + 1, split, 2);
+                    break;
+                }
+                else if (current.from < from) { _ranges[idx].to = from - 1; ++idx; }
+                else if (current.to > to) { _ranges[idx].from = to + 1; break; }
+                else _splice(idx, idx + 1, nullptr, 0);
+            }
+        }
+
+        // Replace intervals [start, end) with `count` intervals from items
+        void _splice(Sz start, Sz end, const Interval* items, Sz count)
+        {
+            const Sz removed = end - start, tail = _ranges.size() - end;
+            if (count > removed) _ranges.expand_and_create(count - removed, false);
+
+            auto data = _ranges.data();
+            if (tail > 0) std::memmove(data + start + count, data + end, sizeof(Interval) * tail);
+            if (count > 0) std::memcpy(data + start, items, sizeof(Interval) * count);
+            for (auto idx = count; idx < removed; ++idx) _ranges.pop_back(false);
+        }
+
+        Vector<Interval, Sz> _ranges{ false };
+        bool _inverted = false;
+    };
+
+    // Bounded lock-free queue for exactly one producer and one consumer thread. Slots are
+    // written/read in place, i.e. producer fills back() and publishes it with push(), whereas
+    // consumer reads front() and releases it with pop()
+    template <typename T>
+    struct SpscQueue
+    {
+        explicit SpscQueue(int32_t capacity)
+        {
+            uint32_t count = 1;
+            while (count < (uint32_t)capacity) count <<= 1;
+            _slots.resize((int32_t)count, true);
+            _mask = count - 1;
+        }
+
+        T* back()
+        {
+            auto tail = _tail.load(std::memory_order_relaxed);
+            return (tail - _head.load(std::memory_order_acquire)) > _mask ? nullptr : &_slots[tail & _mask];
+        }
+
+        void push()
+        {
+            _tail.store(_tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        }
+
+        const T* front() const
+        {
+            auto head = _head.load(std::memory_order_relaxed);
+            return head == _tail.load(std::memory_order_acquire) ? nullptr : &_slots[head & _mask];
+        }
+
+        void pop()
+        {
+            _head.store(_head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        }
+
+        int32_t capacity() const { return (int32_t)_mask + 1; }
+
+    private:
+
+        Vector<T, int32_t> _slots{ false };
+        uint32_t _mask = 0;
+        alignas(64) std::atomic<uint32_t> _head{ 0 }; // Written by consumer
+        alignas(64) std::atomic<uint32_t> _tail{ 0 }; // Written by producer
     };
 
     template <typename T>
@@ -564,8 +1862,8 @@ namespace glimmer
         {
         }
 
-        template <typename SzT, SzT v>
-        Span(Vector<T, SzT, v>& vec)
+        template <typename SzT, SzT v, typename AllocT>
+        Span(Vector<T, SzT, v, AllocT>& vec)
             : source{ vec.data() }, sz{ vec.size() }
         {
         }
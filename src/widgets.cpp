@@ -5,6 +5,12 @@
 #include <cmath>
 #include <cctype>
 #include <charconv>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <limits>
+#include <ctime>
 #include "style.h"
 #include "draw.h"
 #include "context.h"
@@ -21,6 +27,13 @@
 #include <string>
 #include <stdint.h>
 
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#include <cerrno>
+#endif
+
 namespace glimmer
 {
     // This is required, as for some widgets, double clicking leads to a editor, and hence a text input widget
@@ -41,19 +54,35 @@ namespace glimmer
 
 #pragma region Widget ID Handling
 
-    static Vector<char, int32_t> IdStringBackingStore{ GLIMMER_TOTAL_ID_SIZE, 0 };
-    static int32_t IdStringBackingStoreSize = 0;
-    static std::unordered_map<std::string_view, int32_t> NamedIds[WT_TotalTypes];
-    static std::unordered_map<void*, int32_t> OutPtrIds[WT_TotalTypes];
+    struct NamedIdEntry
+    {
+        int32_t id = -1;
+        int32_t page = -1; // Page of IdStrings which holds the key
+        int32_t generation = 0; // Generation in which the id was last used
+        uint32_t slot = 0; // Generation of the widget state slot, detects released ids
+        NamedIdEntry* alias = nullptr; // Entry of "id" for keys "#id .class", used together
+    };
 
-    static std::string_view CreatePermanentCopy(std::string_view input)
+    struct OutPtrIdEntry
     {
-        auto sz = input.size();
-        memcpy(IdStringBackingStore.data() + IdStringBackingStoreSize, input.data(), sz);
-        auto res = std::string_view{ IdStringBackingStore.data() + IdStringBackingStoreSize, sz };
-        IdStringBackingStoreSize += sz;
-        return res;
-    }
+        int32_t id = -1;
+        int32_t generation = 0;
+        uint32_t slot = 0;
+    };
+
+    struct HashedIdEntry
+    {
+        NamedIdEntry* named = nullptr; // Id and its usage are tracked in the named entry
+#ifdef _DEBUG
+        std::string_view text; // Different literals with the same hash are reported in debug builds
+#endif
+    };
+
+    static PagedStringArena<GLIMMER_ID_STRING_PAGE_SZ> IdStrings;
+    static std::unordered_map<std::string_view, NamedIdEntry> NamedIds[WT_TotalTypes];
+    static std::unordered_map<void*, OutPtrIdEntry> OutPtrIds[WT_TotalTypes];
+    static PrehashedTable<HashedIdEntry, int32_t> HashedIds[WT_TotalTypes];
+    static int32_t IdGeneration = 0, IdGenerationFrames = 0;
 
     static WidgetIdClasses ExtractIdClasses(std::string_view input)
     {
@@ -91,21 +120,119 @@ namespace glimmer
         return result;
     }
 
+    static int32_t NewTransientId(WidgetType type, uint32_t& slot)
+    {
+        auto& context = GetContext();
+        auto id = GetNextId(type);
+        context.MarkTransient(id);
+        slot = context.Handle(id).generation;
+        return id;
+    }
+
+    // Ids resolved by name or pointer are released once unused, in which case the name or
+    // pointer gets a new id with fresh widget state
+    static bool IsReleasedId(int32_t id, uint32_t slot, WidgetType type)
+    {
+        auto& context = GetContext();
+        return context.RecyclesIds(type) && !context.IsValid({ id, slot });
+    }
+
+    // Alias of a key with classes is kept for as long as the key is used
+    static void TouchNamedId(NamedIdEntry& entry)
+    {
+        entry.generation = IdGeneration;
+        if (entry.alias != nullptr) entry.alias->generation = IdGeneration;
+    }
+
     std::pair<int32_t, bool> GetIdFromString(std::string_view id, WidgetType type)
     {
-        auto initial = false;
-        auto it = NamedIds[type].find(id);
-        if (it == NamedIds[type].end())
+        auto& ids = NamedIds[type];
+        auto it = ids.find(id);
+
+        if (it == ids.end())
         {
-            auto key = CreatePermanentCopy(id);
+            auto [key, page] = IdStrings.store(id);
             auto idClasses = ExtractIdClasses(key);
-            it = NamedIds[type].emplace(idClasses.id, GetNextId(type)).first;
-            GetContext().RegisterWidgetIdClass(type, it->second, idClasses);
-            if (Config.RecordWidgetId) (*Config.RecordWidgetId)(key, it->second);
-            if (Config.logger) Config.logger->RegisterId(it->second, id);
-            initial = true;
+            auto hasClasses = !idClasses.id.empty() && idClasses.id.size() != key.size();
+            auto alias = hasClasses ? ids.find(idClasses.id) : ids.end();
+
+            NamedIdEntry entry;
+            if (alias != ids.end() && !IsReleasedId(alias->second.id, alias->second.slot, type))
+            {
+                entry.id = alias->second.id;
+                entry.slot = alias->second.slot;
+            }
+            else entry.id = NewTransientId(type, entry.slot);
+            entry.page = page;
+            entry.generation = IdGeneration;
+            auto& named = ids.emplace(key, entry).first->second;
+
+            // Id with classes i.e. "#id .class" can be looked up by "id" as well
+            if (hasClasses && alias == ids.end())
+            {
+                IdStrings.retain(page);
+                named.alias = &ids.emplace(idClasses.id, entry).first->second;
+            }
+            else if (alias != ids.end())
+            {
+                alias->second.id = entry.id;
+                alias->second.slot = entry.slot;
+                alias->second.generation = IdGeneration;
+                named.alias = &alias->second;
+            }
+
+            GetContext().RegisterWidgetIdClass(type, entry.id & WidgetIndexMask, idClasses);
+            if (Config.RecordWidgetId) (*Config.RecordWidgetId)(key, entry.id);
+            if (Config.logger) Config.logger->RegisterId(entry.id, id);
+            return { entry.id, true };
+        }
+
+        auto& entry = it->second;
+        TouchNamedId(entry);
+
+        if (IsReleasedId(entry.id, entry.slot, type))
+        {
+            auto released = entry.id;
+            auto idClasses = ExtractIdClasses(it->first);
+            entry.id = NewTransientId(type, entry.slot);
+
+            if (entry.alias != nullptr && entry.alias->id == released)
+            {
+                entry.alias->id = entry.id;
+                entry.alias->slot = entry.slot;
+            }
+
+            GetContext().RegisterWidgetIdClass(type, entry.id & WidgetIndexMask, idClasses);
+            if (Config.RecordWidgetId) (*Config.RecordWidgetId)(it->first, entry.id);
+            return { entry.id, true };
+        }
+
+        return { entry.id, false };
+    }
+
+    // Ids hashed at compile time skip the string map after they are first registered
+    std::pair<int32_t, bool> GetIdFromString(StringId id, WidgetType type)
+    {
+        if (id.hash == 0) return GetIdFromString(id.text, type);
+
+        if (auto entry = HashedIds[type].find(id.hash); entry != nullptr)
+        {
+#ifdef _DEBUG
+            assert(entry->text == id.text && "Hash collision between widget id literals");
+#endif
+            TouchNamedId(*entry->named);
+            if (!IsReleasedId(entry->named->id, entry->named->slot, type)) return { entry->named->id, false };
+            return GetIdFromString(id.text, type);
         }
-        return { it->second, initial };
+
+        auto result = GetIdFromString(id.text, type);
+        HashedIdEntry entry;
+        entry.named = &NamedIds[type].find(id.text)->second;
+#ifdef _DEBUG
+        entry.text = id.text;
+#endif
+        HashedIds[type].insert(id.hash, entry);
+        return result;
     }
 
     static std::pair<int32_t, bool> GetIdFromOutPtr(void* ptr, WidgetType type)
@@ -114,11 +241,60 @@ namespace glimmer
         auto it = OutPtrIds[type].find(ptr);
         if (it == OutPtrIds[type].end())
         {
-            auto id = GetNextId(type);
-            if (Config.logger) Config.logger->RegisterId(id, ptr);
-            return { OutPtrIds[type].emplace(ptr, id).first->second, true };
+            OutPtrIdEntry entry;
+            entry.id = NewTransientId(type, entry.slot);
+            entry.generation = IdGeneration;
+            if (Config.logger) Config.logger->RegisterId(entry.id, ptr);
+            return { OutPtrIds[type].emplace(ptr, entry).first->second.id, true };
+        }
+
+        auto& entry = it->second;
+        entry.generation = IdGeneration;
+        if (!IsReleasedId(entry.id, entry.slot, type)) return { entry.id, false };
+
+        entry.id = NewTransientId(type, entry.slot);
+        return { entry.id, true };
+    }
+
+    template <typename MapT, typename ReleaseT>
+    static void EraseStaleIds(MapT& ids, ReleaseT release)
+    {
+        auto count = ids.size();
+
+        for (auto it = ids.begin(); it != ids.end();)
+        {
+            if (it->second.generation < IdGeneration)
+            {
+                release(it->second);
+                it = ids.erase(it);
+            }
+            else ++it;
+        }
+
+        if (ids.size() < count / 2) ids.rehash(0);
+    }
+
+    // Every GLIMMER_ID_RECLAIM_FRAMES frames a new generation of ids starts, and the ids which
+    // were not used in the generation that ended are removed. Ids are kept when a logger is
+    // attached, as it refers to id strings. Widget state of ids resolved by name or pointer
+    // is released as well, if it was not used for as many frames.
+    void ReclaimWidgetIds()
+    {
+        if (GLIMMER_ID_RECLAIM_FRAMES <= 0 || ++IdGenerationFrames < GLIMMER_ID_RECLAIM_FRAMES) return;
+        IdGenerationFrames = 0;
+        GetContext().ReleaseUnusedIds(GLIMMER_ID_RECLAIM_FRAMES);
+
+        if (Config.logger == nullptr)
+        {
+            for (auto type = 0; type < WT_TotalTypes; ++type)
+            {
+                HashedIds[type].eraseIf([](const HashedIdEntry& entry) { return entry.named->generation < IdGeneration; });
+                EraseStaleIds(NamedIds[type], [](const NamedIdEntry& entry) { IdStrings.release(entry.page); });
+                EraseStaleIds(OutPtrIds[type], [](const OutPtrIdEntry&) {});
+            }
         }
-        return { it->second, false };
+
+        ++IdGeneration;
     }
 
     int32_t GetNextId(WidgetType type)
@@ -134,6 +310,21 @@ namespace glimmer
         return context.GetNextCount(type);
     }
 
+    WidgetHandle GetWidgetHandle(int32_t id)
+    {
+        return GetContext().Handle(id);
+    }
+
+    bool IsWidgetAlive(WidgetHandle handle)
+    {
+        return GetContext().IsValid(handle);
+    }
+
+    bool ReleaseWidget(int32_t id)
+    {
+        return GetContext().ReleaseId(id);
+    }
+
 #pragma endregion
 
 #pragma region WidgetConfigData
@@ -415,7 +606,7 @@ namespace glimmer
                 auto index = (int16_t)(id >> WidgetTypeBits);
                 persistent.widgets[index].emplace_back(
                     (int16_t)(id & WidgetIndexMask),
-                    (int16_t)(persistent.items.size() - 1)
+                    persistent.items.size() - 1
                 );
 
                 const auto& config = nestedSrc.value().base->GetState(ddid).state.dropdown;
@@ -949,7 +1140,7 @@ namespace glimmer
         }
     }
 
-    void BeginScrollableRegion(std::string_view id, int32_t flags, int32_t geometry, const NeighborWidgets& neighbors, ImVec2 maxsz)
+    void BeginScrollableRegion(StringId id, int32_t flags, int32_t geometry, const NeighborWidgets& neighbors, ImVec2 maxsz)
     {
         auto [iid, __] = GetIdFromString(id, WT_Scrollable);
         BeginScrollableRegion(iid, flags, geometry, neighbors);
@@ -1638,7 +1829,7 @@ namespace glimmer
         BeginFlexLayoutRegion(dir, geometry, wrap, spacing, size, neighbors, context.regionBuilders.top());
     }
 
-    void BeginFlexRegion(std::string_view id, Direction dir, ImVec2 spacing, bool wrap, int32_t events, ImVec2 size, int32_t geometry, const NeighborWidgets& neighbors)
+    void BeginFlexRegion(StringId id, Direction dir, ImVec2 spacing, bool wrap, int32_t events, ImVec2 size, int32_t geometry, const NeighborWidgets& neighbors)
     {
         auto wid = GetIdFromString(id, WT_Region).first;
         BeginFlexRegion(wid, dir, spacing, wrap, events, size, geometry, neighbors);
@@ -1665,7 +1856,7 @@ namespace glimmer
             size, neighbors, context.regionBuilders.top());
     }
 
-    void BeginGridRegion(std::string_view id, int rows, int cols, ImVec2 spacing, int32_t events, ImVec2 size, int32_t geometry, const NeighborWidgets& neighbors)
+    void BeginGridRegion(StringId id, int rows, int cols, ImVec2 spacing, int32_t events, ImVec2 size, int32_t geometry, const NeighborWidgets& neighbors)
     {
         auto wid = GetIdFromString(id, WT_Region).first;
         BeginGridRegion(wid, rows, cols, spacing, events, size, geometry, neighbors);
@@ -1786,14 +1977,14 @@ namespace glimmer
         return Widget(id, WT_Label, geometry, neighbors);
     }
 
-    WidgetDrawResult Label(std::string_view id, std::string_view content, int32_t geometry, const NeighborWidgets& neighbors)
+    WidgetDrawResult Label(StringId id, std::string_view content, int32_t geometry, const NeighborWidgets& neighbors)
     {
         auto wid = GetIdFromString(id, WT_Label).first;
         CreateWidgetConfig(wid).state.label.text = content;
         return Widget(wid, WT_Label, geometry, neighbors);
     }
 
-    WidgetDrawResult Label(std::string_view id, std::string_view content, TextType type, int32_t geometry, const NeighborWidgets& neighbors)
+    WidgetDrawResult Label(StringId id, std::string_view content, TextType type, int32_t geometry, const NeighborWidgets& neighbors)
     {
         auto wid = GetIdFromString(id, WT_Label).first;
         auto& label = CreateWidgetConfig(wid).state.label;
@@ -1801,7 +1992,7 @@ namespace glimmer
         return Widget(wid, WT_Label, geometry, neighbors);
     }
 
-    WidgetDrawResult Label(std::string_view id, std::string_view content, std::string_view tooltip, int32_t geometry, const NeighborWidgets& neighbors)
+    WidgetDrawResult Label(StringId id, std::string_view content, std::string_view tooltip, int32_t geometry, const NeighborWidgets& neighbors)
     {
         auto wid = GetIdFromString(id, WT_Label).first;
         auto& config = CreateWidgetConfig(wid).state.label;
@@ -1814,14 +2005,14 @@ namespace glimmer
         return Widget(id, WT_Button, geometry, neighbors);
     }
 
-    WidgetDrawResult Button(std::string_view id, std::string_view content, int32_t geometry, const NeighborWidgets& neighbors)
+    WidgetDrawResult Button(StringId id, std::string_view content, int32_t geometry, const NeighborWidgets& neighbors)
     {
         auto wid = GetIdFromString(id, WT_Button).first;
         CreateWidgetConfig(wid).state.button.text = content;
         return Widget(wid, WT_Button, geometry, neighbors);
     }
 
-    void BeginButton(std::string_view id, int32_t geometry, const NeighborWidgets& neighbors)
+    void BeginButton(StringId id, int32_t geometry, const NeighborWidgets& neighbors)
     {
         auto wid = GetIdFromString(id, WT_Button).first;
         BeginFlexRegion(wid, DIR_Horizontal, { 0.f, 0.f }, true, ETP_Hovered | ETP_Clicked, { -1.f, -1.f }, geometry, neighbors);
@@ -2193,7 +2384,7 @@ namespace glimmer
         return Widget(id, WT_ToggleButton, geometry, neighbors);
     }
 
-    WidgetDrawResult ToggleButton(std::string_view id, bool* state, int32_t geometry, const NeighborWidgets& neighbors)
+    WidgetDrawResult ToggleButton(StringId id, bool* state, int32_t geometry, const NeighborWidgets& neighbors)
     {
         auto wid = GetIdFromString(id, WT_ToggleButton).first;
         auto& config = CreateWidgetConfig(wid).state.toggle;
@@ -2288,7 +2479,7 @@ namespace glimmer
         return Widget(id, WT_RadioButton, geometry, neighbors);
     }
 
-    WidgetDrawResult RadioButton(std::string_view id, bool* state, int32_t geometry, const NeighborWidgets& neighbors)
+    WidgetDrawResult RadioButton(StringId id, bool* state, int32_t geometry, const NeighborWidgets& neighbors)
     {
         auto wid = GetIdFromString(id, WT_RadioButton).first;
         auto& config = CreateWidgetConfig(wid).state.radio;
@@ -2397,7 +2588,7 @@ namespace glimmer
         return Widget(id, WT_Checkbox, geometry, neighbors);
     }
 
-    WidgetDrawResult Checkbox(std::string_view id, CheckState* state, int32_t geometry, const NeighborWidgets& neighbors)
+    WidgetDrawResult Checkbox(StringId id, CheckState* state, int32_t geometry, const NeighborWidgets& neighbors)
     {
         auto wid = GetIdFromString(id, WT_Checkbox).first;
         auto& config = CreateWidgetConfig(wid).state.checkbox;
@@ -2671,7 +2862,7 @@ namespace glimmer
         return Widget(id, WT_Spinner, geometry, neighbors);
     }
 
-    WidgetDrawResult Spinner(std::string_view id, int32_t* value, int32_t step, std::pair<int32_t, int32_t> range, int32_t geometry, const NeighborWidgets& neighbors)
+    WidgetDrawResult Spinner(StringId id, int32_t* value, int32_t step, std::pair<int32_t, int32_t> range, int32_t geometry, const NeighborWidgets& neighbors)
     {
         auto wid = GetIdFromString(id, WT_Spinner).first;
         auto& config = CreateWidgetConfig(wid).state.spinner;
@@ -2689,7 +2880,7 @@ namespace glimmer
         return Widget(id, WT_Spinner, geometry, neighbors);
     }
 
-    WidgetDrawResult Spinner(std::string_view id, float* value, float step, std::pair<float, float> range, int32_t geometry, const NeighborWidgets& neighbors)
+    WidgetDrawResult Spinner(StringId id, float* value, float step, std::pair<float, float> range, int32_t geometry, const NeighborWidgets& neighbors)
     {
         auto wid = GetIdFromString(id, WT_Spinner).first;
         auto& config = CreateWidgetConfig(wid).state.spinner;
@@ -2707,7 +2898,7 @@ namespace glimmer
         return Widget(id, WT_Spinner, geometry, neighbors);
     }
 
-    WidgetDrawResult Spinner(std::string_view id, double* value, float step, std::pair<float, float> range, int32_t geometry, const NeighborWidgets& neighbors)
+    WidgetDrawResult Spinner(StringId id, double* value, float step, std::pair<float, float> range, int32_t geometry, const NeighborWidgets& neighbors)
     {
         auto wid = GetIdFromString(id, WT_Spinner).first;
         auto& config = CreateWidgetConfig(wid).state.spinner;
@@ -2849,7 +3040,7 @@ namespace glimmer
         return Widget(id, WT_Slider, geometry, neighbors);
     }
 
-    WidgetDrawResult Slider(std::string_view id, int32_t* value, std::pair<int32_t, int32_t> range, int32_t geometry, const NeighborWidgets& neighbors)
+    WidgetDrawResult Slider(StringId id, int32_t* value, std::pair<int32_t, int32_t> range, int32_t geometry, const NeighborWidgets& neighbors)
     {
         auto wid = GetIdFromString(id, WT_Slider).first;
         auto& config = CreateWidgetConfig(wid).state.slider;
@@ -2867,7 +3058,7 @@ namespace glimmer
         return Widget(id, WT_Slider, geometry, neighbors);
     }
 
-    WidgetDrawResult Slider(std::string_view id, float* value, std::pair<float, float> range, int32_t geometry, const NeighborWidgets& neighbors)
+    WidgetDrawResult Slider(StringId id, float* value, std::pair<float, float> range, int32_t geometry, const NeighborWidgets& neighbors)
     {
         auto wid = GetIdFromString(id, WT_Slider).first;
         auto& config = CreateWidgetConfig(wid).state.slider;
@@ -2885,7 +3076,7 @@ namespace glimmer
         return Widget(id, WT_Slider, geometry, neighbors);
     }
 
-    WidgetDrawResult Slider(std::string_view id, double* value, std::pair<float, float> range, int32_t geometry, const NeighborWidgets& neighbors)
+    WidgetDrawResult Slider(StringId id, double* value, std::pair<float, float> range, int32_t geometry, const NeighborWidgets& neighbors)
     {
         auto wid = GetIdFromString(id, WT_Slider).first;
         auto& config = CreateWidgetConfig(wid).state.slider;
@@ -3095,7 +3286,7 @@ namespace glimmer
         return Widget(id, WT_RangeSlider, geometry, neighbors);
     }
 
-    WidgetDrawResult RangeSlider(std::string_view id, int32_t* min_val, int32_t* max_val, std::pair<int32_t, int32_t> range, int32_t geometry, const NeighborWidgets& neighbors)
+    WidgetDrawResult RangeSlider(StringId id, int32_t* min_val, int32_t* max_val, std::pair<int32_t, int32_t> range, int32_t geometry, const NeighborWidgets& neighbors)
     {
         auto wid = GetIdFromString(id, WT_RangeSlider).first;
         auto& config = CreateWidgetConfig(wid).state.rangeSlider;
@@ -3123,7 +3314,7 @@ namespace glimmer
         return Widget(id, WT_RangeSlider, geometry, neighbors);
     }
 
-    WidgetDrawResult RangeSlider(std::string_view id, float* min_val, float* max_val, std::pair<float, float> range, int32_t geometry, const NeighborWidgets& neighbors)
+    WidgetDrawResult RangeSlider(StringId id, float* min_val, float* max_val, std::pair<float, float> range, int32_t geometry, const NeighborWidgets& neighbors)
     {
         auto wid = GetIdFromString(id, WT_RangeSlider).first;
         auto& config = CreateWidgetConfig(wid).state.rangeSlider;
@@ -3151,7 +3342,7 @@ namespace glimmer
         return Widget(id, WT_RangeSlider, geometry, neighbors);
     }
 
-    WidgetDrawResult RangeSlider(std::string_view id, double* min_val, double* max_val, std::pair<float, float> range, int32_t geometry, const NeighborWidgets& neighbors)
+    WidgetDrawResult RangeSlider(StringId id, double* min_val, double* max_val, std::pair<float, float> range, int32_t geometry, const NeighborWidgets& neighbors)
     {
         auto wid = GetIdFromString(id, WT_RangeSlider).first;
         auto& config = CreateWidgetConfig(wid).state.rangeSlider;
@@ -3169,50 +3360,299 @@ namespace glimmer
 
 #pragma region TextInput
 
-    static void UpdatePosition(const TextInputState& state, int index, InputTextPersistentState& input, const StyleDescriptor& style, IRenderer& renderer)
+    static float MeasureChar(char ch, const StyleDescriptor& style, IRenderer& renderer)
+    {
+        if (ch == '\n') return 0.f;
+        return renderer.GetTextSize(std::string_view{ &ch, 1 }, style.font.font, style.font.size).x;
+    }
+
+    // Character range of a line excluding the terminating new line
+    static std::pair<int32_t, int32_t> TextLineExtent(const TextInputState& state, const InputTextPersistentState& input, int32_t line)
+    {
+        auto from = input.lines.lengths.prefix(line), to = from + input.lines.lengths[line];
+        if (to > from && state.text[to - 1] == '\n') --to;
+        return { from, to };
+    }
+
+    // End of the visual row which starts at `from` in a line ending at `to`. Rows are broken
+    // after the last space which fits in width, or at the character crossing it otherwise.
+    static int32_t NextRowBreak(const TextInputState& state, const InputTextPersistentState& input, int32_t from, int32_t to, float width)
+    {
+        if (width <= 0.f || from >= to) return to;
+
+        auto limit = input.pixelpos(from - 1) + width;
+        if (input.pixelpos(to - 1) <= limit) return to;
+
+        auto brk = std::clamp(input.advances.find(limit), from + 1, to);
+        for (auto idx = brk; idx > from + 1; --idx)
+            if (state.text[idx - 1] == ' ') return idx;
+        return brk;
+    }
+
+    // Re-measure a line after an edit, this is O(rows * log n)
+    static void UpdateTextLine(const TextInputState& state, InputTextPersistentState& input, int32_t line)
+    {
+        auto& lines = input.lines;
+        auto [from, to] = TextLineExtent(state, input, line);
+        auto width = input.pixelpos(to - 1) - input.pixelpos(from - 1);
+        auto rows = 1;
+
+        for (auto end = NextRowBreak(state, input, from, to, lines.wrapWidth); end < to;
+            end = NextRowBreak(state, input, end, to, lines.wrapWidth))
+            ++rows;
+
+        if (lines.rows[line] != rows) lines.rows.update(line, rows);
+        lines.widest = std::max(lines.widest, width);
+        lines.sweepWidest = std::max(lines.sweepWidest, width);
+    }
+
+    static void BuildTextLineIndex(const TextInputState& state, InputTextPersistentState& input)
     {
-        for (auto idx = index; idx < (int)state.text.size(); ++idx)
+        auto& lines = input.lines;
+        auto size = (int32_t)state.text.size(), from = 0, count = 0;
+        lines.lengths.clear();
+        lines.rows.clear();
+        lines.widest = lines.sweepWidest = 0.f;
+        lines.sweep = -1;
+
+        for (auto idx = 0; idx <= size; ++idx)
         {
-            auto sz = renderer.GetTextSize(std::string_view{ state.text.data() + idx, 1 }, style.font.font, style.font.size).x;
-            input.pixelpos[idx] = sz + (idx > 0 ? input.pixelpos[idx - 1] : 0.f);
+            if (idx == size || state.text[idx] == '\n')
+            {
+                auto end = idx == size ? idx : idx + 1;
+                lines.lengths.insert(count, end - from);
+                lines.rows.insert(count, 1);
+                from = end;
+                ++count;
+            }
         }
+
+        for (auto line = 0; line < count; ++line)
+            UpdateTextLine(state, input, line);
     }
 
-    static void RemoveCharAt(int position, TextInputState& state, InputTextPersistentState& input)
+    // Measure a batch of lines of the pending re-index
+    static void ReindexTextLines(const TextInputState& state, InputTextPersistentState& input)
+    {
+        auto& lines = input.lines;
+        if (lines.sweep == -1) return;
+
+        auto last = std::min(lines.lengths.size(), lines.sweep + GLIMMER_MULTILINE_REINDEX_BATCH);
+        for (; lines.sweep < last; ++lines.sweep)
+            UpdateTextLine(state, input, lines.sweep);
+
+        if (lines.sweep >= lines.lengths.size())
+        {
+            lines.widest = lines.sweepWidest;
+            lines.sweep = -1;
+        }
+    }
+
+    // Visual row of the caret at `offset` and its horizontal position relative to the row start
+    static std::pair<int32_t, float> TextCaretPosition(const TextInputState& state, const InputTextPersistentState& input, int32_t offset)
+    {
+        const auto& lines = input.lines;
+        auto line = lines.lengths.find(offset);
+        auto [from, to] = TextLineExtent(state, input, line);
+        auto row = lines.rows.prefix(line), start = from;
+
+        for (auto end = NextRowBreak(state, input, start, to, lines.wrapWidth); end < to && end <= offset;
+            end = NextRowBreak(state, input, start, to, lines.wrapWidth))
+        {
+            start = end;
+            ++row;
+        }
+
+        return { row, input.pixelpos(offset - 1) - input.pixelpos(start - 1) };
+    }
+
+    // Caret offset nearest to horizontal position `x` (relative to row start) in a visual row
+    static int32_t TextOffsetAt(const TextInputState& state, const InputTextPersistentState& input, int32_t row, float x)
+    {
+        const auto& lines = input.lines;
+        row = std::clamp(row, 0, lines.rows.total() - 1);
+        auto line = lines.rows.find(row);
+        auto [from, to] = TextLineExtent(state, input, line);
+        auto start = from, end = NextRowBreak(state, input, start, to, lines.wrapWidth);
+
+        for (auto skip = row - lines.rows.prefix(line); skip > 0 && end < to; --skip)
+        {
+            start = end;
+            end = NextRowBreak(state, input, start, to, lines.wrapWidth);
+        }
+
+        if (start == end) return start;
+
+        auto target = input.pixelpos(start - 1) + std::max(x, 0.f);
+        auto idx = std::clamp(input.advances.find(target), start, end - 1);
+        if (target > input.pixelpos(idx - 1) + input.advances[idx] * 0.5f) ++idx;
+
+        // Offset at a wrap point belongs to the next row
+        return idx == end && end < to ? end - 1 : idx;
+    }
+
+    // Split the line at `position` for each new line in inserted content
+    static void IndexInsertedText(int position, std::string_view content, const TextInputState& state, InputTextPersistentState& input)
+    {
+        auto& lines = input.lines;
+        auto line = lines.lengths.find(position), current = line;
+        auto offset = position - lines.lengths.prefix(line), remaining = lines.lengths[line] - offset;
+        std::size_t from = 0;
+
+        for (auto nl = content.find('\n'); nl != std::string_view::npos; nl = content.find('\n', from))
+        {
+            lines.lengths.update(current, offset + (int32_t)(nl - from) + 1);
+            lines.lengths.insert(current + 1, 0);
+            lines.rows.insert(current + 1, 1);
+            offset = 0;
+            from = nl + 1;
+            ++current;
+        }
+
+        lines.lengths.update(current, offset + (int32_t)(content.size() - from) + remaining);
+        for (; line <= current; ++line)
+            UpdateTextLine(state, input, line);
+    }
+
+    // Only the inserted characters are measured, advances of the rest of the text are untouched
+    static void InsertText(int position, std::string_view content, TextInputState& state, InputTextPersistentState& input, 
+        const StyleDescriptor& style, IRenderer& renderer)
+    {
+        state.text.insert(position, content);
+        for (auto idx = 0; idx < (int)content.size(); ++idx)
+            input.advances.insert(position + idx, MeasureChar(content[idx], style, renderer));
+
+        if (state.isMultiline && !input.lines.lengths.empty())
+            IndexInsertedText(position, content, state, input);
+    }
+
+    static void EraseText(int position, int count, TextInputState& state, InputTextPersistentState& input)
+    {
+        auto& lines = input.lines;
+        auto indexed = state.isMultiline && !lines.lengths.empty();
+        int32_t first = 0, last = 0, length = 0;
+
+        if (indexed)
+        {
+            // Lines [first, last] are merged into one, widest line is re-computed if removed
+            first = lines.lengths.find(position);
+            last = lines.lengths.find(position + count);
+            length = lines.lengths.prefix(last + 1) - count - lines.lengths.prefix(first);
+
+            for (auto line = first; line <= last; ++line)
+            {
+                auto [from, to] = TextLineExtent(state, input, line);
+                if (input.pixelpos(to - 1) - input.pixelpos(from - 1) >= lines.widest)
+                    lines.reindex(false);
+            }
+        }
+
+        state.text.erase(position, count);
+        input.advances.erase(position, count);
+
+        if (indexed)
+        {
+            if (last > first)
+            {
+                lines.lengths.erase(first + 1, last - first);
+                lines.rows.erase(first + 1, last - first);
+            }
+
+            lines.lengths.update(first, length);
+            UpdateTextLine(state, input, first);
+        }
+    }
+
+    // Record an edit in undo/redo history. Consecutive typing and single character deletions are
+    // merged into the latest operation, typing is split at whitespace so that undo works per word.
+    static void RecordTextOperation(InputTextPersistentState& input, TextOpType type, int32_t position,
+        std::string_view text, bool coalesce)
     {
-        auto diff = input.pixelpos[position] - (position == 0 ? 0.f : input.pixelpos[position - 1]);
-        auto& op = input.ops.push();
-        op.type = TextOpType::Deletion;
-        op.opmem[0] = state.text[position - 1];
-        op.opmem[1] = 0;
+        auto latest = coalesce ? input.ops.latest() : nullptr;
+        auto length = (int32_t)text.size();
+
+        if (latest != nullptr && latest->type == type)
+        {
+            if (type == TextOpType::Addition && latest->range.first + latest->range.second == position &&
+                !std::isspace((unsigned char)text.front()))
+            {
+                latest->range.second += length;
+                input.ops.extend(text, false);
+                return;
+            }
+            else if (type == TextOpType::Deletion && position + length == latest->range.first)
+            {
+                // Backspace, text is removed before the previous deletion
+                latest->range.first = position;
+                latest->range.second += length;
+                input.ops.extend(text, true);
+                return;
+            }
+            else if (type == TextOpType::Deletion && position == latest->range.first)
+            {
+                latest->range.second += length;
+                input.ops.extend(text, false);
+                return;
+            }
+        }
+
+        TextInputOperation op;
+        op.type = type;
+        op.range = std::make_pair(position, length);
         op.caretpos = input.caretpos;
-        op.range = std::make_pair(position - 1, 1);
+        input.ops.push(op, text);
+    }
+
+    static void ApplyTextOperation(const TextInputOperation& op, std::string_view payload, bool undo, TextInputState& state, 
+        InputTextPersistentState& input, const StyleDescriptor& style, IRenderer& renderer)
+    {
+        auto [position, length] = op.range;
 
-        for (auto idx = position; idx < (int)state.text.size(); ++idx)
+        switch (op.type)
+        {
+        case TextOpType::Addition:
+            if (undo) EraseText(position, length, state, input);
+            else InsertText(position, payload, state, input, style, renderer);
+            input.caretpos = undo ? op.caretpos : position + length;
+            break;
+        case TextOpType::Deletion:
+            if (undo) InsertText(position, payload, state, input, style, renderer);
+            else EraseText(position, length, state, input);
+            input.caretpos = undo ? op.caretpos : position;
+            break;
+        case TextOpType::Replacement:
         {
-            state.text[idx - 1] = state.text[idx];
-            input.pixelpos[idx - 1] -= diff;
+            auto replaced = payload.substr(0, length), inserted = payload.substr(length);
+            EraseText(position, undo ? (int)inserted.size() : length, state, input);
+            InsertText(position, undo ? replaced : inserted, state, input, style, renderer);
+            input.caretpos = undo ? op.caretpos : position + (int)inserted.size();
+            break;
+        }
+        default: break;
         }
 
+        state.selection.first = state.selection.second = -1;
+        input.selectionStart = -1.f;
+        input.scroll.state.pos.x = std::min(input.scroll.state.pos.x, input.advances.total());
+    }
+
+    static void RemoveCharAt(int position, TextInputState& state, InputTextPersistentState& input)
+    {
+        auto diff = input.advances[position - 1];
+        EraseText(position - 1, 1, state, input);
         input.scroll.state.pos.x = std::max(0.f, input.scroll.state.pos.x - diff);
-        state.text.pop_back();
-        input.pixelpos.pop_back(true);
     }
 
     static void ClearAllText(TextInputState& state, InputTextPersistentState& input)
     {
-        auto& op = input.ops.push();
-        auto selectionsz = (int)state.text.size();
-        op.type = TextOpType::Deletion;
-        op.range = std::make_pair(0, selectionsz);
-        op.caretpos = input.caretpos;
-        memcpy(op.opmem, state.text.data(), selectionsz);
-        op.opmem[selectionsz] = 0;
+        if (!state.text.empty())
+            RecordTextOperation(input, TextOpType::Deletion, 0, state.text.view(), false);
 
         state.text.clear();
-        input.pixelpos.clear(true);
+        input.advances.clear();
+        if (state.isMultiline) BuildTextLineIndex(state, input);
 
-        input.scroll.state.pos.x = 0.f;
+        input.scroll.state.pos.x = input.scroll.state.pos.y = 0.f;
         input.caretpos = 0;
         state.selection.first = state.selection.second = -1;
         input.selectionStart = -1.f;
@@ -3220,126 +3660,465 @@ namespace glimmer
 
     static void DeleteSelectedText(TextInputState& state, InputTextPersistentState& input)
     {
-        auto from = std::max(state.selection.first, state.selection.second) + 1,
-            to = std::min(state.selection.first, state.selection.second);
+        auto from = std::min(state.selection.first, state.selection.second),
+            to = std::max(state.selection.first, state.selection.second) + 1;
 
-        if (from - to >= (int)state.text.size())
+        if (to - from >= (int)state.text.size())
             ClearAllText(state, input);
         else
         {
-            float shift = input.pixelpos[from - 1] - input.pixelpos[to - 1];
-            auto textsz = (int)state.text.size();
+            float shift = input.pixelpos(to - 1) - input.pixelpos(from - 1);
 
-            auto& op = input.ops.push();
-            auto selectionsz = to - from;
-            op.type = TextOpType::Deletion;
-            op.range = std::make_pair(from, selectionsz);
-            op.caretpos = input.caretpos;
-            memcpy(op.opmem, state.text.data() + to, selectionsz);
-            op.opmem[selectionsz] = 0;
-
-            for (; from < textsz; ++from, ++to)
-            {
-                state.text[to] = state.text[from];
-                input.pixelpos[to] = input.pixelpos[from] - shift;
-            }
-
-            for (auto idx = to; idx < textsz; ++idx)
-            {
-                state.text.pop_back();
-                input.pixelpos.pop_back(true);
-            }
+            RecordTextOperation(input, TextOpType::Deletion, from, 
+                state.text.view(from, to - from), false);
+            EraseText(from, to - from, state, input);
 
             input.scroll.state.pos.x = std::max(0.f, input.scroll.state.pos.x - shift);
-            input.caretpos = std::min(state.selection.first, state.selection.second);
+            input.caretpos = from;
             state.selection.first = state.selection.second = -1;
             input.selectionStart = -1.f;
         }
     }
 
-    void HandleTextInputEvent(WidgetContextData& context, int32_t id, const ImRect& content, const ImRect& suffix, const IODescriptor& io,
-        IRenderer& renderer, WidgetDrawResult& result)
+    // Measure text and build line index when text is set or changed outside of the widget
+    static void SyncTextLineIndex(TextInputState& state, InputTextPersistentState& input, const StyleDescriptor& style, IRenderer& renderer)
     {
-        if (!context.deferEvents)
+        auto size = (int32_t)state.text.size();
+
+        if (input.advances.size() != size)
         {
-            auto& state = context.GetState(id).state.input;
-            auto& input = context.InputTextState(id);
-            auto style = context.GetStyle(state.state, state.id);
+            input.advances.clear();
+            for (auto idx = 0; idx < size; ++idx)
+                input.advances.insert(idx, MeasureChar(state.text[idx], style, renderer));
+            input.caretpos = size;
+            input.lines.lengths.clear();
+        }
 
-            auto mousepos = io.mousepos;
-            auto mouseover = content.Contains(mousepos) || (state.state & WS_Pressed);
-            auto ispressed = mouseover && io.isLeftMouseDown();
-            auto hasclick = io.clicked();
-            auto isclicked = (hasclick && mouseover) || (!hasclick && (state.state & WS_Focused));
-            mouseover ? state.state |= WS_Hovered : state.state &= ~WS_Hovered;
-            ispressed ? state.state |= WS_Pressed : state.state &= ~WS_Pressed;
-            isclicked ? state.state |= WS_Focused : state.state &= ~WS_Focused;
-            if (input.lastClickTime != -1.f) input.lastClickTime += io.deltaTime;
-            if (mouseover) WidgetContextData::CurrentWidgetId = id;
+        if (input.lines.lengths.empty() || input.lines.lengths.total() != size)
+            BuildTextLineIndex(state, input);
+    }
 
-            if (mouseover) 
-                Config.platform->SetMouseCursor(MouseCursor::TextInput);
+    static void ScrollToTextCaret(const TextInputState& state, InputTextPersistentState& input, const ImRect& content, float lineh)
+    {
+        auto [row, x] = TextCaretPosition(state, input, input.caretpos);
+        auto& pos = input.scroll.state.pos;
+        auto top = (float)row * lineh, width = content.GetWidth() - Config.scrollbar.width;
 
-            // When mouse is down inside the input, text selection is in progress
-            // Hence, either text selection is starting, in which case record the start position.
-            // If mouse gets released at the same position, it is a click and not a selection,
-            // in which case, move the caret to the respective char position.
-            // If mouse gets dragged, select the region of text
-            if (state.state & WS_Pressed)
-            {
-                if (!state.text.empty() && mousepos.y < (content.Max.y - (1.5f * 5.f)) && state.isSelectable)
-                {
-                    auto posx = mousepos.x - content.Min.x;
-                    if (input.selectionStart == -1.f) input.selectionStart = posx;
-                    else if ((fabsf(input.selectionStart - posx) > 5.f) || input.isSelecting)
-                    {
-                        if (state.selection.first == -1)
-                        {
-                            auto it = std::lower_bound(input.pixelpos.begin(), input.pixelpos.end(), input.selectionStart + input.scroll.state.pos.x);
-                            if (it != input.pixelpos.end())
-                            {
-                                auto idx = it - input.pixelpos.begin();
-                                if (idx > 0 && (*it - posx) > 0.f) --idx;
-                                state.selection.first = it - input.pixelpos.begin();
-                                input.isSelecting = true;
-                                input.caretVisible = false;
-                                input.caretpos = state.selection.first + 1;
-                            }
-                        }
+        if (top < pos.y) pos.y = top;
+        else if (top + lineh > pos.y + content.GetHeight()) pos.y = top + lineh - content.GetHeight();
 
-                        auto it = std::lower_bound(input.pixelpos.begin(), input.pixelpos.end(), posx + input.scroll.state.pos.x);
+        if (x < pos.x) pos.x = x;
+        else if (x > pos.x + width) pos.x = x - width;
+    }
 
-                        if (it != input.pixelpos.end())
-                        {
-                            auto idx = it - input.pixelpos.begin();
-                            if (idx > 0 && (*it - posx) > 0.f) --idx;
+    // Selection spans from the anchor to the caret
+    static void SelectTextToCaret(TextInputState& state, InputTextPersistentState& input, int32_t anchor)
+    {
+        auto from = std::min(anchor, input.caretpos), to = std::max(anchor, input.caretpos);
+        input.lines.anchor = anchor;
 
-                            auto prevpos = input.caretpos;
-                            state.selection.second = it - input.pixelpos.begin();
-                            input.caretpos = state.selection.second + 1;
+        if (from < to) state.selection = { from, to - 1 };
+        else state.selection = { -1, -1 };
+    }
 
-                            if (state.selection.second > state.selection.first)
-                            {
-                                if ((prevpos < input.caretpos) && (input.pixelpos[input.caretpos - 1] - input.scroll.state.pos.x > content.GetWidth()))
-                                {
-                                    auto width = fabsf(input.pixelpos[input.caretpos - 1] - (input.caretpos > 1 ? input.pixelpos[input.caretpos - 2] : 0.f));
-                                    input.moveRight(width);
-                                }
-                            }
-                            else
-                            {
-                                if (prevpos > input.caretpos && (input.pixelpos[input.caretpos - 1] - input.scroll.state.pos.x < 0.f))
-                                {
-                                    auto width = fabsf(input.pixelpos[prevpos - 1] - (prevpos > 1 ? input.pixelpos[prevpos - 2] : 0.f));
-                                    input.moveLeft(width);
-                                }
-                            }
-                        }
-                    }
-                }
-            }
-            else
-            {
+    static void MoveTextCaret(TextInputState& state, InputTextPersistentState& input, int32_t position, bool extend)
+    {
+        auto anchor = state.selection.second != -1 ? input.lines.anchor : input.caretpos;
+        input.caretpos = std::clamp(position, 0, (int32_t)state.text.size());
+
+        if (extend && state.isSelectable) SelectTextToCaret(state, input, anchor);
+        else
+        {
+            state.selection = { -1, -1 };
+            input.lines.anchor = -1;
+        }
+    }
+
+    // Characters that can be added while the text and its NUL terminator fit the output buffer
+    static int32_t TextInputRoom(const TextInputState& state)
+    {
+        return state.out.source == nullptr ? INT32_MAX :
+            std::max(0, state.out.size() - 1 - (int32_t)state.text.size());
+    }
+
+    static void InsertTypedText(std::string_view content, TextInputState& state, InputTextPersistentState& input,
+        const StyleDescriptor& style, IRenderer& renderer)
+    {
+        if (state.selection.second != -1) DeleteSelectedText(state, input);
+        content = content.substr(0, (size_t)TextInputRoom(state));
+        if (content.empty()) return;
+
+        RecordTextOperation(input, TextOpType::Addition, input.caretpos, content, content.size() == 1u);
+        InsertText(input.caretpos, content, state, input, style, renderer);
+        input.caretpos += (int32_t)content.size();
+    }
+
+    // Events of multi-line input, caret movement and hit-testing go through the line index
+    // so that their cost does not depend on the size of the text
+    static void HandleMultilineTextEvent(TextInputState& state, InputTextPersistentState& input, const StyleDescriptor& style,
+        const ImRect& content, const IODescriptor& io, IRenderer& renderer, WidgetDrawResult& result)
+    {
+        SyncTextLineIndex(state, input, style, renderer);
+
+        auto& lines = input.lines;
+        auto lineh = style.font.size;
+        auto mousepos = io.mousepos;
+        auto& scroll = input.scroll.state.pos;
+        auto hitpos = [&] {
+            auto row = (int32_t)((mousepos.y - content.Min.y + scroll.y) / lineh);
+            return TextOffsetAt(state, input, row, mousepos.x - content.Min.x + scroll.x);
+        };
+
+        if (state.state & WS_Pressed)
+        {
+            if (!input.isSelecting && mousepos.x < content.Max.x - Config.scrollbar.width &&
+                mousepos.y < content.Max.y - Config.scrollbar.width)
+            {
+                auto extend = (io.modifiers & ShiftKeyMod) != 0;
+                input.isSelecting = true;
+                lines.desiredx = -1.f;
+
+                // Double click selects the line
+                if (IsBetween(input.lastClickTime, 0.f, 0.5f) && state.isSelectable)
+                {
+                    auto line = lines.lengths.find(input.caretpos);
+                    auto [from, to] = TextLineExtent(state, input, line);
+                    input.caretpos = to;
+                    SelectTextToCaret(state, input, from);
+                    input.lastClickTime = -1.f;
+                    input.isSelecting = false;
+                }
+                else MoveTextCaret(state, input, hitpos(), extend);
+            }
+            else if (input.isSelecting && state.isSelectable)
+            {
+                auto anchor = lines.anchor == -1 ? input.caretpos : lines.anchor;
+                input.caretpos = hitpos();
+                SelectTextToCaret(state, input, anchor);
+                ScrollToTextCaret(state, input, content, lineh);
+            }
+        }
+        else if (input.isSelecting)
+        {
+            input.isSelecting = false;
+            input.lastClickTime = 0.f;
+            if (state.selection.second == -1) lines.anchor = -1;
+            result.event = state.selection.second != -1 ? WidgetEvent::Selected : WidgetEvent::Focused;
+        }
+
+        if (state.state & WS_Focused)
+        {
+            Config.platform->ToggleTextInputMode(true);
+
+            if (input.lastCaretShowTime > 0.5f)
+            {
+                input.caretVisible = !input.caretVisible;
+                input.lastCaretShowTime = 0.f;
+            }
+            else input.lastCaretShowTime += io.deltaTime;
+
+            auto pagerows = std::max(1, (int32_t)(content.GetHeight() / lineh));
+
+            for (auto kidx = 0; io.key[kidx] != Key_Invalid; ++kidx)
+            {
+                auto key = io.key[kidx];
+                auto extend = (io.modifiers & ShiftKeyMod) != 0;
+                auto vertical = key == Key_UpArrow || key == Key_DownArrow || key == Key_PageUp || key == Key_PageDown;
+                input.lastCaretShowTime = 0.f;
+                input.caretVisible = true;
+
+                if (vertical)
+                {
+                    auto [row, x] = TextCaretPosition(state, input, input.caretpos);
+                    auto delta = key == Key_UpArrow ? -1 : key == Key_DownArrow ? 1 : key == Key_PageUp ? -pagerows : pagerows;
+                    if (lines.desiredx < 0.f) lines.desiredx = x;
+
+                    auto target = row + delta < 0 ? 0 : row + delta >= lines.rows.total() ? (int32_t)state.text.size() :
+                        TextOffsetAt(state, input, row + delta, lines.desiredx);
+                    MoveTextCaret(state, input, target, extend);
+                }
+                else if (key == Key_LeftArrow || key == Key_RightArrow)
+                {
+                    auto position = input.caretpos;
+                    if (state.selection.second != -1 && !extend)
+                        position = key == Key_LeftArrow ? state.selection.first : state.selection.second + 1;
+                    else position += key == Key_LeftArrow ? -1 : 1;
+                    MoveTextCaret(state, input, position, extend);
+                }
+                else if (key == Key_Home || key == Key_End)
+                {
+                    auto [row, x] = TextCaretPosition(state, input, input.caretpos);
+                    auto target = io.modifiers & CtrlKeyMod ? (key == Key_Home ? 0 : (int32_t)state.text.size()) :
+                        TextOffsetAt(state, input, row, key == Key_Home ? 0.f : FLT_MAX);
+                    MoveTextCaret(state, input, target, extend);
+                }
+                else if (key == Key_Enter)
+                {
+                    InsertTypedText("\n", state, input, style, renderer);
+                    result.event = WidgetEvent::Edited;
+                }
+                else if (key == Key_Backspace || key == Key_Delete)
+                {
+                    if (state.selection.second != -1) DeleteSelectedText(state, input);
+                    else
+                    {
+                        auto position = key == Key_Backspace ? input.caretpos - 1 : input.caretpos;
+                        if (position < 0 || position >= (int32_t)state.text.size()) continue;
+
+                        RecordTextOperation(input, TextOpType::Deletion, position,
+                            state.text.view(position, 1), true);
+                        EraseText(position, 1, state, input);
+                        input.caretpos = position;
+                    }
+
+                    result.event = WidgetEvent::Edited;
+                }
+                else if (key == Key_Space || (key >= Key_0 && key <= Key_Z) ||
+                    (key >= Key_Apostrophe && key <= Key_GraveAccent) ||
+                    (key >= Key_Keypad0 && key <= Key_KeypadEqual))
+                {
+                    if (key == Key_V && io.modifiers & CtrlKeyMod)
+                    {
+                        auto clipboard = Config.platform->GetClipboardText();
+                        if (clipboard.empty()) continue;
+                        InsertTypedText(clipboard, state, input, style, renderer);
+                        result.event = WidgetEvent::Edited;
+                    }
+                    else if ((key == Key_C || key == Key_X) && (io.modifiers & CtrlKeyMod))
+                    {
+                        if (state.selection.second == -1) continue;
+                        CopyToClipboard(state.text, state.selection.first, state.selection.second);
+
+                        if (key == Key_X)
+                        {
+                            DeleteSelectedText(state, input);
+                            result.event = WidgetEvent::Edited;
+                        }
+                    }
+                    else if (key == Key_A && (io.modifiers & CtrlKeyMod))
+                    {
+                        input.caretpos = (int32_t)state.text.size();
+                        if (state.isSelectable) SelectTextToCaret(state, input, 0);
+                    }
+                    else if ((key == Key_Z || key == Key_Y) && (io.modifiers & CtrlKeyMod))
+                    {
+                        auto undo = key == Key_Z && !(io.modifiers & ShiftKeyMod);
+                        auto entry = undo ? input.ops.undo() : input.ops.redo();
+
+                        if (entry.has_value())
+                        {
+                            ApplyTextOperation(entry->first, entry->second, undo, state, input, style, renderer);
+                            lines.anchor = -1;
+                            result.event = WidgetEvent::Edited;
+                        }
+                    }
+                    else
+                    {
+                        auto ch = io.modifiers & ShiftKeyMod ? KeyMappings[key].second : KeyMappings[key].first;
+                        auto typed = (char)(io.capslock ? std::toupper(ch) : std::tolower(ch));
+                        auto overwrite = io.insert && state.selection.second == -1 &&
+                            input.caretpos < (int32_t)state.text.size() && state.text[input.caretpos] != '\n';
+
+                        if (overwrite)
+                        {
+                            char replaced[2] = { state.text[input.caretpos], typed };
+                            TextInputOperation op;
+                            op.type = TextOpType::Replacement;
+                            op.range = std::make_pair(input.caretpos, 1);
+                            op.caretpos = input.caretpos;
+                            input.ops.push(op, std::string_view{ replaced, 2 });
+                            EraseText(input.caretpos, 1, state, input);
+                            InsertText(input.caretpos, std::string_view{ &typed, 1 }, state, input, style, renderer);
+                            input.caretpos++;
+                        }
+                        else InsertTypedText(std::string_view{ &typed, 1 }, state, input, style, renderer);
+
+                        result.event = WidgetEvent::Edited;
+                    }
+                }
+                else continue;
+
+                if (!vertical) lines.desiredx = -1.f;
+                input.caretVisible = state.selection.second == -1;
+                ScrollToTextCaret(state, input, content, lineh);
+            }
+
+            ShowTooltip(state._hoverDuration, content, state.tooltip, io);
+        }
+        else
+        {
+            input.caretVisible = false;
+            Config.platform->ToggleTextInputMode(false);
+        }
+    }
+
+    // Draw characters [from, to) of a visual row, only the horizontally visible part is drawn
+    static void DrawTextRow(const TextInputState& state, const InputTextPersistentState& input, int32_t from, int32_t to,
+        ImVec2 pos, const ImRect& content, std::pair<int32_t, int32_t> selection, const StyleDescriptor& style,
+        const StyleDescriptor& selstyle, IRenderer& renderer)
+    {
+        if (from >= to) return;
+
+        auto base = input.pixelpos(from - 1), left = input.scroll.state.pos.x;
+        auto first = std::clamp(input.advances.find(base + left), from, to);
+        auto last = std::clamp(input.advances.find(base + left + content.GetWidth()) + 1, first, to);
+        int32_t bounds[4] = { first, std::clamp(selection.first, first, last), std::clamp(selection.second, first, last), last };
+
+        for (auto part = 0; part < 3; ++part)
+        {
+            if (bounds[part] >= bounds[part + 1]) continue;
+
+            auto text = state.text.view(bounds[part], bounds[part + 1] - bounds[part]);
+            ImVec2 start{ pos.x + input.pixelpos(bounds[part] - 1) - base, pos.y };
+
+            if (part == 1)
+            {
+                auto width = input.pixelpos(bounds[2] - 1) - input.pixelpos(bounds[1] - 1);
+                renderer.DrawRect(start, start + ImVec2{ width, style.font.size }, selstyle.bgcolor, true);
+                renderer.DrawText(text, start, selstyle.fgcolor);
+            }
+            else renderer.DrawText(text, start, style.fgcolor);
+        }
+    }
+
+    // Only the rows inside the viewport are visited, rows of lines which are visited are kept
+    // up to date while a re-index is pending
+    static void DrawMultilineText(const TextInputState& state, InputTextPersistentState& input, const ImRect& content,
+        const StyleDescriptor& style, const StyleDescriptor& selstyle, IRenderer& renderer)
+    {
+        auto& lines = input.lines;
+        if (lines.lengths.empty() || input.advances.size() != (int32_t)state.text.size()) return;
+
+        auto wrap = state.wrapLines ? std::max(content.GetWidth() - Config.scrollbar.width, style.font.size) : 0.f;
+        if (wrap != lines.wrapWidth)
+        {
+            lines.wrapWidth = wrap;
+            lines.reindex(true);
+        }
+
+        ReindexTextLines(state, input);
+
+        auto lineh = style.font.size;
+        auto scroll = input.scroll.state.pos;
+        auto total = lines.rows.total();
+        auto row = std::clamp((int32_t)(scroll.y / lineh), 0, total - 1);
+        auto lastrow = std::clamp((int32_t)((scroll.y + content.GetHeight()) / lineh), 0, total - 1);
+        auto line = lines.rows.find(row), skip = row - lines.rows.prefix(line);
+        ImVec2 pos{ content.Min.x - scroll.x, content.Min.y + (float)row * lineh - scroll.y };
+        std::pair<int32_t, int32_t> selection{ -1, -1 };
+
+        if (state.selection.second != -1)
+            selection = { std::min(state.selection.first, state.selection.second),
+                std::max(state.selection.first, state.selection.second) + 1 };
+
+        for (; row <= lastrow && line < lines.lengths.size(); ++line, skip = 0)
+        {
+            auto [from, to] = TextLineExtent(state, input, line);
+            auto start = from, end = NextRowBreak(state, input, start, to, lines.wrapWidth), count = 1;
+
+            for (; count <= skip && end < to; ++count)
+            {
+                start = end;
+                end = NextRowBreak(state, input, start, to, lines.wrapWidth);
+            }
+
+            for (; row <= lastrow; ++count)
+            {
+                DrawTextRow(state, input, start, end, pos, content, selection, style, selstyle, renderer);
+                pos.y += lineh;
+                ++row;
+
+                if (end >= to) break;
+                start = end;
+                end = NextRowBreak(state, input, start, to, lines.wrapWidth);
+            }
+
+            if (skip == 0 && end >= to && count != lines.rows[line])
+                lines.rows.update(line, count);
+        }
+    }
+
+    void HandleTextInputEvent(WidgetContextData& context, int32_t id, const ImRect& content, const ImRect& suffix, const IODescriptor& io,
+        IRenderer& renderer, WidgetDrawResult& result)
+    {
+        if (!context.deferEvents)
+        {
+            auto& state = context.GetState(id).state.input;
+            auto& input = context.InputTextState(id);
+            auto style = context.GetStyle(state.state, state.id);
+
+            auto mousepos = io.mousepos;
+            auto mouseover = content.Contains(mousepos) || (state.state & WS_Pressed);
+            auto ispressed = mouseover && io.isLeftMouseDown();
+            auto hasclick = io.clicked();
+            auto isclicked = (hasclick && mouseover) || (!hasclick && (state.state & WS_Focused));
+            mouseover ? state.state |= WS_Hovered : state.state &= ~WS_Hovered;
+            ispressed ? state.state |= WS_Pressed : state.state &= ~WS_Pressed;
+            isclicked ? state.state |= WS_Focused : state.state &= ~WS_Focused;
+            if (input.lastClickTime != -1.f) input.lastClickTime += io.deltaTime;
+            if (mouseover) WidgetContextData::CurrentWidgetId = id;
+
+            if (mouseover) 
+                Config.platform->SetMouseCursor(MouseCursor::TextInput);
+
+            // When mouse is down inside the input, text selection is in progress
+            // Hence, either text selection is starting, in which case record the start position.
+            // If mouse gets released at the same position, it is a click and not a selection,
+            // in which case, move the caret to the respective char position.
+            // If mouse gets dragged, select the region of text
+            if (state.isMultiline)
+                HandleMultilineTextEvent(state, input, style, content, io, renderer, result);
+            else if (state.state & WS_Pressed)
+            {
+                if (!state.text.empty() && mousepos.y < (content.Max.y - (1.5f * 5.f)) && state.isSelectable)
+                {
+                    auto posx = mousepos.x - content.Min.x;
+                    if (input.selectionStart == -1.f) input.selectionStart = posx;
+                    else if ((fabsf(input.selectionStart - posx) > 5.f) || input.isSelecting)
+                    {
+                        if (state.selection.first == -1)
+                        {
+                            auto idx = input.charAt(input.selectionStart + input.scroll.state.pos.x);
+                            if (idx != -1)
+                            {
+                                state.selection.first = idx;
+                                input.isSelecting = true;
+                                input.caretVisible = false;
+                                input.caretpos = state.selection.first + 1;
+                            }
+                        }
+
+                        auto idx = input.charAt(posx + input.scroll.state.pos.x);
+
+                        if (idx != -1)
+                        {
+
+                            auto prevpos = input.caretpos;
+                            state.selection.second = idx;
+                            input.caretpos = state.selection.second + 1;
+
+                            if (state.selection.second > state.selection.first)
+                            {
+                                if ((prevpos < input.caretpos) && (input.pixelpos(input.caretpos - 1) - input.scroll.state.pos.x > content.GetWidth()))
+                                {
+                                    auto width = fabsf(input.pixelpos(input.caretpos - 1) - (input.caretpos > 1 ? input.pixelpos(input.caretpos - 2) : 0.f));
+                                    input.moveRight(width);
+                                }
+                            }
+                            else
+                            {
+                                if (prevpos > input.caretpos && (input.pixelpos(input.caretpos - 1) - input.scroll.state.pos.x < 0.f))
+                                {
+                                    auto width = fabsf(input.pixelpos(prevpos - 1) - (prevpos > 1 ? input.pixelpos(prevpos - 2) : 0.f));
+                                    input.moveLeft(width);
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+            else
+            {
                 if (!state.text.empty() && mousepos.y < (content.Max.y - (1.5f * 5.f)) && state.isSelectable)
                 {
                     auto posx = mousepos.x - content.Min.x;
@@ -3347,8 +4126,8 @@ namespace glimmer
                     // This means we have clicked, not selecting text
                     if (fabsf(input.selectionStart - posx) < 5.f)
                     {
-                        auto it = std::lower_bound(input.pixelpos.begin(), input.pixelpos.end(), posx + input.scroll.state.pos.x);
-                        auto idx = it - input.pixelpos.begin();
+                        auto idx = input.charAt(posx + input.scroll.state.pos.x);
+                        if (idx == -1) idx = (int)state.text.size();
 
                         // This is a double click, select entire content
                         if (IsBetween(input.lastClickTime, 0.f, 1.f) && !state.text.empty())
@@ -3375,25 +4154,21 @@ namespace glimmer
                     {
                         if (state.selection.first == -1)
                         {
-                            auto it = std::lower_bound(input.pixelpos.begin(), input.pixelpos.end(), input.selectionStart + input.scroll.state.pos.x);
-                            if (it != input.pixelpos.end())
+                            auto idx = input.charAt(input.selectionStart + input.scroll.state.pos.x);
+                            if (idx != -1)
                             {
-                                auto idx = it - input.pixelpos.begin();
-                                if (idx > 0 && (*it - posx) > 0.f) --idx;
-                                state.selection.first = it - input.pixelpos.begin();
+                                state.selection.first = idx;
                                 input.isSelecting = true;
                                 input.caretVisible = false;
                             }
                         }
 
-                        auto it = std::lower_bound(input.pixelpos.begin(), input.pixelpos.end(), posx + input.scroll.state.pos.x);
+                        auto idx = input.charAt(posx + input.scroll.state.pos.x);
 
-                        if (it != input.pixelpos.end())
+                        if (idx != -1)
                         {
-                            auto idx = it - input.pixelpos.begin();
-                            if (idx > 0 && (*it - posx) > 0.f) --idx;
 
-                            state.selection.second = it - input.pixelpos.begin();
+                            state.selection.second = idx;
                             result.event = WidgetEvent::Selected;
                             input.caretVisible = false;
                             input.isSelecting = false;
@@ -3430,7 +4205,7 @@ namespace glimmer
                                 if (state.isSelectable)
                                     if (state.selection.second == -1)
                                     {
-                                        input.selectionStart = input.pixelpos[input.caretpos];
+                                        input.selectionStart = input.pixelpos(input.caretpos);
                                         state.selection.first = input.caretpos;
                                         state.selection.second = input.caretpos;
                                     }
@@ -3442,9 +4217,9 @@ namespace glimmer
                             }
                             else input.caretpos = std::max(input.caretpos - 1, 0);
 
-                            if (prevpos > input.caretpos && (input.pixelpos[input.caretpos - 1] - input.scroll.state.pos.x < 0.f))
+                            if (prevpos > input.caretpos && (input.pixelpos(input.caretpos - 1) - input.scroll.state.pos.x < 0.f))
                             {
-                                auto width = fabsf(input.pixelpos[prevpos - 1] - (prevpos > 1 ? input.pixelpos[prevpos - 2] : 0.f));
+                                auto width = fabsf(input.pixelpos(prevpos - 1) - (prevpos > 1 ? input.pixelpos(prevpos - 2) : 0.f));
                                 input.moveLeft(width);
                             }
                         }
@@ -3457,7 +4232,7 @@ namespace glimmer
                                 if (state.isSelectable)
                                     if (state.selection.second == -1)
                                     {
-                                        input.selectionStart = input.pixelpos[input.caretpos];
+                                        input.selectionStart = input.pixelpos(input.caretpos);
                                         state.selection.first = input.caretpos;
                                         state.selection.second = input.caretpos;
                                     }
@@ -3469,9 +4244,9 @@ namespace glimmer
                             }
                             else input.caretpos = std::min(input.caretpos + 1, (int)state.text.size());
 
-                            if ((prevpos < input.caretpos) && (input.pixelpos[input.caretpos - 1] - input.scroll.state.pos.x > content.GetWidth()))
+                            if ((prevpos < input.caretpos) && (input.pixelpos(input.caretpos - 1) - input.scroll.state.pos.x > content.GetWidth()))
                             {
-                                auto width = fabsf(input.pixelpos[input.caretpos - 1] - (input.caretpos > 1 ? input.pixelpos[input.caretpos - 2] : 0.f));
+                                auto width = fabsf(input.pixelpos(input.caretpos - 1) - (input.caretpos > 1 ? input.pixelpos(input.caretpos - 2) : 0.f));
                                 input.moveRight(width);
                             }
                         }
@@ -3479,27 +4254,21 @@ namespace glimmer
                         {
                             if (state.selection.second == -1)
                             {
-                                std::string_view text{ state.text.data(), state.text.size() };
-                                auto caretAtEnd = input.caretpos == (int)text.size();
-                                if (text.empty()) continue;
+                                auto caretAtEnd = input.caretpos == state.text.size();
+                                if (state.text.empty() || input.caretpos == 0) continue;
 
-                                auto& op = input.ops.push();
-                                op.type = TextOpType::Deletion;
-                                op.opmem[0] = state.text[input.caretpos - 1];
-                                op.opmem[1] = 0;
-                                op.range = std::make_pair(input.caretpos - 1, 1);
-                                op.caretpos = input.caretpos;
+                                RecordTextOperation(input, TextOpType::Deletion, input.caretpos - 1, 
+                                    state.text.view(input.caretpos - 1, 1), true);
 
                                 if (caretAtEnd)
                                 {
                                     if (input.scroll.state.pos.x != 0.f)
                                     {
-                                        auto width = input.pixelpos.back() - input.pixelpos[input.pixelpos.size() - 2];
+                                        auto width = input.advances[input.advances.size() - 1];
                                         input.moveLeft(width);
                                     }
 
-                                    state.text.pop_back();
-                                    input.pixelpos.pop_back(true);
+                                    EraseText((int)state.text.size() - 1, 1, state, input);
                                 }
                                 else RemoveCharAt(input.caretpos, state, input);
 
@@ -3513,11 +4282,15 @@ namespace glimmer
                         {
                             if (state.selection.second == -1)
                             {
-                                std::string_view text{ state.text.data(), state.text.size() };
-                                auto caretAtEnd = input.caretpos == (int)text.size();
-                                if (text.empty()) continue;
+                                auto caretAtEnd = input.caretpos == state.text.size();
+                                if (state.text.empty()) continue;
 
-                                if (!caretAtEnd) RemoveCharAt(input.caretpos + 1, state, input);
+                                if (!caretAtEnd)
+                                {
+                                    RecordTextOperation(input, TextOpType::Deletion, input.caretpos, 
+                                        state.text.view(input.caretpos, 1), true);
+                                    RemoveCharAt(input.caretpos + 1, state, input);
+                                }
                             }
                             else DeleteSelectedText(state, input);
 
@@ -3530,37 +4303,13 @@ namespace glimmer
                             if (key == Key_V && io.modifiers & CtrlKeyMod)
                             {
                                 auto content = Config.platform->GetClipboardText();
+                                content = content.substr(0, (size_t)TextInputRoom(state));
                                 auto length = (int)content.size();
 
                                 if (length > 0)
                                 {
-                                    auto caretAtEnd = input.caretpos == (int)state.text.size();
-                                    input.pixelpos.expand(length, 0.f);
-
-                                    if (caretAtEnd)
-                                    {
-                                        for (auto idx = 0; idx < length; ++idx)
-                                        {
-                                            state.text.push_back(content[idx]);
-                                            auto sz = renderer.GetTextSize(std::string_view{ content.data() + idx, 1 }, style.font.font, style.font.size).x;
-                                            input.pixelpos.push_back(sz + (state.text.size() > 1u ? input.pixelpos.back() : 0.f));
-                                        }
-                                    }
-                                    else
-                                    {
-                                        for (auto idx = (int)state.text.size() - 1; idx >= input.caretpos; --idx)
-                                            state.text[idx] = state.text[idx - length];
-                                        for (auto idx = 0; idx < length; ++idx)
-                                            state.text[idx + input.caretpos] = content[idx];
-
-                                        UpdatePosition(state, input.caretpos, input, style, renderer);
-                                    }
-
-                                    auto& op = input.ops.push();
-                                    op.type = TextOpType::Addition;
-                                    op.range = std::make_pair(input.caretpos, std::min(length, 127));
-                                    memcpy(op.opmem, content.data(), std::min(length, 127));
-                                    op.opmem[length] = 0;
+                                    RecordTextOperation(input, TextOpType::Addition, input.caretpos, content, false);
+                                    InsertText(input.caretpos, content, state, input, style, renderer);
 
                                     input.caretpos += length;
                                     result.event = WidgetEvent::Edited;
@@ -3585,68 +4334,48 @@ namespace glimmer
                                     input.caretVisible = false;
                                 }
                             }
-                            else if (key == Key_Z && (io.modifiers & CtrlKeyMod))
+                            else if ((key == Key_Z || key == Key_Y) && (io.modifiers & CtrlKeyMod))
                             {
-                                if (!input.ops.empty())
-                                {
-                                    auto op = input.ops.undo().value();
+                                auto undo = key == Key_Z && !(io.modifiers & ShiftKeyMod);
+                                auto entry = undo ? input.ops.undo() : input.ops.redo();
 
-                                    switch (op.type)
-                                    {
-                                    case TextOpType::Deletion:
-                                    {
-                                        auto length = op.range.second;
-                                        input.pixelpos.expand(length, 0.f);
-                                        state.text.resize(state.text.size() + length);
-
-                                        for (auto idx = (int)state.text.size() - 1; idx >= op.range.first; --idx)
-                                            state.text[idx] = state.text[idx - length];
-                                        for (auto idx = 0; idx < length; ++idx)
-                                            state.text[idx + op.range.first] = op.opmem[idx];
-
-                                        UpdatePosition(state, op.range.first, input, style, renderer);
-                                        input.caretpos = op.caretpos;
-                                        break;
-                                    }
-                                    default:
-                                        break;
-                                    }
+                                if (entry.has_value())
+                                {
+                                    ApplyTextOperation(entry->first, entry->second, undo, state, input, style, renderer);
+                                    result.event = WidgetEvent::Edited;
                                 }
                             }
                             else
                             {
-                                std::string_view text{ state.text.data(), state.text.size() };
                                 auto ch = io.modifiers & ShiftKeyMod ? KeyMappings[key].second : KeyMappings[key].first;
                                 ch = io.capslock ? std::toupper(ch) : std::tolower(ch);
-                                auto caretAtEnd = input.caretpos == (int)text.size();
+                                auto caretAtEnd = input.caretpos == state.text.size();
+                                if ((caretAtEnd || !io.insert) && TextInputRoom(state) == 0) continue;
+
+                                auto typed = (char)ch;
+
+                                if (!caretAtEnd && io.insert)
+                                {
+                                    char replaced[2] = { state.text[input.caretpos], typed };
+                                    TextInputOperation op;
+                                    op.type = TextOpType::Replacement;
+                                    op.range = std::make_pair(input.caretpos, 1);
+                                    op.caretpos = input.caretpos;
+                                    input.ops.push(op, std::string_view{ replaced, 2 });
+                                }
+                                else RecordTextOperation(input, TextOpType::Addition, input.caretpos, std::string_view{ &typed, 1 }, true);
 
                                 if (caretAtEnd)
                                 {
-                                    state.text.push_back(ch);
-                                    std::string_view newtext{ state.text.data(), state.text.size() };
-                                    auto lastpos = (int)state.text.size() - 1;
-                                    auto width = renderer.GetTextSize(newtext.substr(lastpos, 1), style.font.font, style.font.size).x;
-                                    auto nextw = width + (lastpos > 0 ? input.pixelpos[lastpos - 1] : 0.f);
-                                    input.pixelpos.push_back(nextw);
-                                    input.scroll.state.pos.x = std::max(0.f, input.pixelpos.back() - content.GetWidth());
+                                    InsertText(input.caretpos, std::string_view{ &typed, 1 }, state, input, style, renderer);
+                                    input.scroll.state.pos.x = std::max(0.f, input.advances.total() - content.GetWidth());
                                 }
+                                else if (!io.insert)
+                                    InsertText(input.caretpos, std::string_view{ &typed, 1 }, state, input, style, renderer);
                                 else
                                 {
-                                    if (!io.insert)
-                                    {
-                                        state.text.push_back(0);
-                                        input.pixelpos.push_back(0.f);
-                                        for (auto from = (int)state.text.size() - 2; from >= input.caretpos; --from)
-                                            state.text[from + 1] = state.text[from];
-                                        state.text[input.caretpos] = (char)ch;
-                                        UpdatePosition(state, input.caretpos, input, style, renderer);
-                                    }
-                                    else
-                                    {
-                                        // TODO: Position update is not required for monospace fonts, can optimize this
-                                        state.text[input.caretpos] = (char)ch;
-                                        UpdatePosition(state, input.caretpos, input, style, renderer);
-                                    }
+                                    state.text.set(input.caretpos, typed);
+                                    input.advances.update(input.caretpos, MeasureChar(typed, style, renderer));
                                 }
 
                                 input.caretpos++;
@@ -3683,17 +4412,24 @@ namespace glimmer
                 }
             }
 
-            if (!state.text.empty())
+            if (state.isMultiline)
+            {
+                auto totalRows = input.lines.lengths.empty() ? 1 : input.lines.rows.total();
+                input.scroll.content = { state.wrapLines ? 0.f : input.lines.widest, (float)totalRows * style.font.size };
+                input.scroll.viewport = content;
+                auto hasHScroll = HandleHScroll(input.scroll, renderer, io, 5.f, false);
+                HandleVScroll(input.scroll, renderer, io, Config.scrollbar.width, hasHScroll);
+            }
+            else if (!state.text.empty())
             {
-                if (input.pixelpos.size() < state.text.size())
+                if (input.advances.size() < (int32_t)state.text.size())
                 {
-                    auto index = input.pixelpos.size();
-                    input.pixelpos.expand_and_create(state.text.size() - index, true);
-                    UpdatePosition(state, index, input, style, renderer);
+                    for (auto idx = input.advances.size(); idx < (int32_t)state.text.size(); ++idx)
+                        input.advances.insert(idx, MeasureChar(state.text[idx], style, renderer));
                     input.caretpos = state.text.size();
                 }
 
-                input.scroll.content.x = input.pixelpos.back();
+                input.scroll.content.x = input.advances.total();
                 input.scroll.viewport = content;
                 HandleHScroll(input.scroll, renderer, io, 5.f, false);
             }
@@ -3706,17 +4442,21 @@ namespace glimmer
             else
                 input.suffixState = state.text.empty() ? WS_Disabled : WS_Default;
 
-            if (state.out.source)
+            // Output buffer is written once after focus is lost and not per edit, always NUL terminated
+            if (state.out.source && input.written != state.text.edits() && !(state.state & WS_Focused))
             {
-                memset(state.out.source, 0, state.out.size());
-                memcpy(state.out.source, state.text.data(), std::min((int)state.text.size(), state.out.size()));
+                auto text = state.text.view();
+                auto length = std::min((int)text.size(), state.out.size() - 1);
+                memcpy(state.out.source, text.data(), length);
+                state.out.source[length] = 0;
+                input.written = state.text.edits();
             }
 
             HandleContextMenu(id, content, io);
 
             WITH_WIDGET_LOG(id, content);
             LOG_STATE(state.state);
-            LOG_TEXT(state.text);
+            LOG_TEXT2("state.text", state.text.view());
             LOG_STYLE2(state.state, id);
         }
         else context.deferedEvents.emplace_back(EventDeferInfo::ForTextInput(id, content, suffix));
@@ -3772,6 +4512,13 @@ namespace glimmer
             DrawText(content.Min, content.Max, { content.Min, content.Min + sz }, state.placeholder, state.state & WS_Disabled,
                 phstyle, renderer, FontStyleOverflowMarquee | TextIsPlainText);
         }
+        else if (state.isMultiline)
+        {
+            content.Max.x -= suffix.GetWidth();
+            renderer.SetClipRect(content.Min, content.Max);
+            DrawMultilineText(state, input, content, style, context.GetStyle(WS_Selected, state.id), renderer);
+            renderer.ResetClipRect();
+        }
         else
         { 
             content.Max.x -= suffix.GetWidth();
@@ -3787,8 +4534,8 @@ namespace glimmer
 
             if (state.selection.second != -1)
             {
-                std::string_view text{ state.isMasked ? buffer : state.text.data(), 
-                    state.isMasked ? std::min((std::size_t)255, state.text.size()) : state.text.size() };
+                std::string_view text = state.isMasked ? std::string_view{ buffer, 
+                    std::min<std::size_t>(255, state.text.size()) } : state.text.view();
                 auto selection = state.selection;
                 selection = { std::max(0, std::min(state.selection.first, state.selection.second)),
                     std::min(std::max(state.selection.first, state.selection.second), (int32_t)text.size()) };
@@ -3819,19 +4566,43 @@ namespace glimmer
             else
             {
                 ImVec2 startpos{ content.Min.x - input.scroll.state.pos.x, content.Min.y };
-                std::string_view text{ state.isMasked ? buffer : state.text.data(),
-                    state.isMasked ? std::min((std::size_t)255, state.text.size()) : state.text.size() };
+                std::string_view text = state.isMasked ? std::string_view{ buffer,
+                    std::min<std::size_t>(255, state.text.size()) } : state.text.view();
+
+                // Only draw the characters inside the viewport
+                if (!state.isMasked && input.advances.size() == (int32_t)text.size())
+                {
+                    auto first = input.charAt(input.scroll.state.pos.x);
+                    auto last = input.charAt(input.scroll.state.pos.x + content.GetWidth());
+                    if (first == -1) first = (int32_t)text.size();
+                    if (last == -1) last = (int32_t)text.size() - 1;
+                    startpos.x += input.pixelpos(first - 1);
+                    text = text.substr(first, std::max(0, last - first + 1));
+                }
+
                 renderer.DrawText(text, startpos, style.fgcolor);
             }
 
             renderer.ResetClipRect();
         }
 
-        if ((state.state & WS_Focused) && input.caretVisible)
+        if ((state.state & WS_Focused) && input.caretVisible && state.isMultiline)
+        {
+            if (!input.lines.lengths.empty() && input.advances.size() == (int32_t)state.text.size())
+            {
+                auto [row, x] = TextCaretPosition(state, input, input.caretpos);
+                ImVec2 pos{ content.Min.x + x - input.scroll.state.pos.x + (x == 0.f ? 1.f : 0.f),
+                    content.Min.y + (float)row * style.font.size - input.scroll.state.pos.y };
+
+                if (pos.y >= content.Min.y && pos.y + style.font.size <= content.Max.y && pos.x <= content.Max.x)
+                    renderer.DrawLine(pos + ImVec2{ 0.f, 1.f }, pos + ImVec2{ 0.f, style.font.size - 1.f }, style.fgcolor, 2.f);
+            }
+        }
+        else if ((state.state & WS_Focused) && input.caretVisible)
         {
             auto isCaretAtEnd = input.caretpos == (int)state.text.size();
             auto offset = isCaretAtEnd && (input.scroll.state.pos.x == 0.f) ? 1.f : 0.f;
-            auto cursorxpos = (!input.pixelpos.empty() ? input.pixelpos[input.caretpos - 1] - input.scroll.state.pos.x : 0.f) + offset;
+            auto cursorxpos = (!input.advances.empty() ? input.pixelpos(input.caretpos - 1) - input.scroll.state.pos.x : 0.f) + offset;
             renderer.DrawLine(content.Min + ImVec2{ cursorxpos, 1.f }, content.Min + ImVec2{ cursorxpos, content.GetHeight() - 1.f }, style.fgcolor, 2.f);
         }
 
@@ -3848,66 +4619,327 @@ namespace glimmer
         return Widget(id, WT_TextInput, geometry, neighbors);
     }
 
+    // Text is owned by the widget, out is only read when the widget starts using it
+    static void LoadTextInput(TextInputState& config, char* out, int size, int length)
+    {
+        assert(size > 0);
+        if (length < 0)
+        {
+            auto end = static_cast<const char*>(std::memchr(out, 0, (size_t)size));
+            length = end != nullptr ? (int)(end - out) : size - 1;
+        }
+
+        config.out = Span<char>{ out, size };
+        config.text.reserve(size);
+        config.text.assign(std::string_view{ out, (size_t)std::min(length, size - 1) });
+    }
+
     WidgetDrawResult TextInput(char* out, int size, std::string_view placeholder, int32_t geometry, const NeighborWidgets& neighbors)
     {
-        auto length = strlen(out);
-        return TextInput(out, size, length, placeholder, geometry, neighbors);
+        return TextInput(out, size, -1, placeholder, geometry, neighbors);
     }
 
-    WidgetDrawResult TextInput(std::string_view id, char* out, int size, std::string_view placeholder, int32_t geometry, const NeighborWidgets& neighbors)
+    WidgetDrawResult TextInput(StringId id, char* out, int size, std::string_view placeholder, int32_t geometry, const NeighborWidgets& neighbors)
     {
-        auto length = strlen(out);
-        return TextInput(id, out, size, length, placeholder, geometry, neighbors);
+        return TextInput(id, out, size, -1, placeholder, geometry, neighbors);
     }
 
     WidgetDrawResult TextInput(char* out, int size, int strlen, std::string_view placeholder, int32_t geometry, const NeighborWidgets& neighbors)
     {
         auto [id, initial] = GetIdFromOutPtr(out, WT_TextInput);
         auto& config = CreateWidgetConfig(id).state.input;
-        config.placeholder = placeholder; config.out = Span<char>{ out, size };
-        config.text.reserve(size); config.suffixIcon = SymbolIcon::Cross;
-        config.text.assign(out, out + strlen);
+        if (initial || config.out.source != out) LoadTextInput(config, out, size, strlen);
+        config.placeholder = placeholder; config.suffixIcon = SymbolIcon::Cross;
         return Widget(id, WT_TextInput, geometry, neighbors);
     }
 
-    WidgetDrawResult TextInput(std::string_view id, char* out, int size, int strlen, std::string_view placeholder, int32_t geometry, const NeighborWidgets& neighbors)
+    WidgetDrawResult TextInput(StringId id, char* out, int size, int strlen, std::string_view placeholder, int32_t geometry, const NeighborWidgets& neighbors)
     {
         auto [wid, initial] = GetIdFromString(id, WT_TextInput);
         auto& config = CreateWidgetConfig(wid).state.input;
-        config.placeholder = placeholder; config.out = Span<char>{ out, size };
-        config.text.reserve(size); config.suffixIcon = SymbolIcon::Cross;
-        config.text.assign(out, out + strlen);
+        if (initial || config.out.source != out) LoadTextInput(config, out, size, strlen);
+        config.placeholder = placeholder; config.suffixIcon = SymbolIcon::Cross;
         return Widget(wid, WT_TextInput, geometry, neighbors);
     }
 
-#pragma endregion
-
-#pragma region DropDown
+    std::string_view GetTextInputText(int32_t id)
+    {
+        return GetContext().GetState(id).state.input.text.view();
+    }
 
-    static void DrawItemBackground(IRenderer* renderer, const ImRect& geometry, uint32_t color)
+    std::string_view GetTextInputText(StringId id)
     {
-        renderer->BeginAdvance();
-        renderer->DrawRect(geometry.Min, geometry.Max, color, true);
-        renderer->EndAdvance();
+        auto [wid, __] = GetIdFromString(id, WT_TextInput);
+        return GetTextInputText(wid);
     }
 
-    void ShowDropDownOptions(WidgetContextData& parent, DropDownState& state, DropDownPersistentState& persistent, 
-        int32_t id, const ImRect& margin, const ImRect& border, const ImRect& padding, const ImRect& content, 
-        IRenderer& renderer)
+    // Replaces the text as a single undoable change, characters are measured when the widget is drawn next
+    void SetTextInputText(int32_t id, std::string_view text)
     {
-        if (persistent.context == nullptr) return;
+        auto& context = GetContext();
+        auto& state = context.GetState(id).state.input;
+        auto& input = context.InputTextState(id);
+        if (state.out.source != nullptr) text = text.substr(0, std::min(text.size(), (size_t)state.out.size() - 1));
+
+        ClearAllText(state, input);
+        if (!text.empty()) RecordTextOperation(input, TextOpType::Addition, 0, text, false);
+        state.text.assign(text);
+    }
+
+    void SetTextInputText(StringId id, std::string_view text)
+    {
+        auto [wid, __] = GetIdFromString(id, WT_TextInput);
+        SetTextInputText(wid, text);
+    }
+
+    WidgetDrawResult TextEditor(char* out, int size, bool wrapLines, int32_t geometry, const NeighborWidgets& neighbors)
+    {
+        auto [id, initial] = GetIdFromOutPtr(out, WT_TextInput);
+        auto& config = CreateWidgetConfig(id).state.input;
+        if (initial || config.out.source != out) LoadTextInput(config, out, size, -1);
+        config.isMultiline = true; config.wrapLines = wrapLines;
+        return Widget(id, WT_TextInput, geometry, neighbors);
+    }
+
+    WidgetDrawResult TextEditor(StringId id, char* out, int size, bool wrapLines, int32_t geometry, const NeighborWidgets& neighbors)
+    {
+        auto [wid, initial] = GetIdFromString(id, WT_TextInput);
+        auto& config = CreateWidgetConfig(wid).state.input;
+        if (initial || config.out.source != out) LoadTextInput(config, out, size, -1);
+        config.isMultiline = true; config.wrapLines = wrapLines;
+        return Widget(wid, WT_TextInput, geometry, neighbors);
+    }
+
+#pragma endregion
+
+#pragma region DropDown
+
+    static void DrawItemBackground(IRenderer* renderer, const ImRect& geometry, uint32_t color)
+    {
+        renderer->BeginAdvance();
+        renderer->DrawRect(geometry.Min, geometry.Max, color, true);
+        renderer->EndAdvance();
+    }
+
+    static char FoldCase(char ch)
+    {
+        return (char)std::tolower((unsigned char)ch);
+    }
+
+    // Case-insensitive three-way comparison of the prefix of text with query, 0 if text starts with query
+    static int CompareOptionPrefix(std::string_view text, std::string_view query)
+    {
+        for (auto idx = 0; idx < (int)query.size(); ++idx)
+        {
+            if (idx == (int)text.size()) return -1;
+            auto lhs = FoldCase(text[idx]), rhs = FoldCase(query[idx]);
+            if (lhs != rhs) return lhs < rhs ? -1 : 1;
+        }
+
+        return 0;
+    }
+
+    static bool OptionContainsQuery(std::string_view text, std::string_view query)
+    {
+        for (auto from = 0; from + query.size() <= text.size(); ++from)
+            if (CompareOptionPrefix(text.substr(from), query) == 0)
+                return true;
+        return false;
+    }
+
+    static bool IsDropDownOptionShown(const DropDownPersistentState& persistent, int32_t idx)
+    {
+        // Options not yet indexed are placed in the order they are added
+        auto pos = idx < persistent.rank.size() ? persistent.rank[idx] : idx;
+        return pos >= persistent.first && pos < persistent.first + GLIMMER_DROPDOWN_MAX_VISIBLE_OPTIONS;
+    }
+
+    static void ScrollToDropDownOption(DropDownPersistentState& persistent, int32_t idx)
+    {
+        if (idx < 0 || idx >= persistent.rank.size() || persistent.rank[idx] == -1) return;
+
+        auto pos = persistent.rank[idx];
+        if (pos < persistent.first) persistent.first = pos;
+        else if (pos >= persistent.first + GLIMMER_DROPDOWN_MAX_VISIBLE_OPTIONS)
+            persistent.first = pos - GLIMMER_DROPDOWN_MAX_VISIBLE_OPTIONS + 1;
+    }
+
+    static void ClampDropDownWindow(DropDownPersistentState& persistent)
+    {
+        persistent.first = std::max(0, std::min(persistent.first,
+            persistent.shown.size() - GLIMMER_DROPDOWN_MAX_VISIBLE_OPTIONS));
+    }
+
+    // Rebuild the prefix index when option texts change, and the filtered view when the query changes.
+    // The prefix index is sorted by case-folded text, all options starting with the query form a
+    // contiguous range in it which is found by binary search.
+    static void UpdateDropDownIndex(DropDownState& state, DropDownPersistentState& persistent)
+    {
+        auto count = persistent.items.size();
+        const auto& items = persistent.items;
+
+        if (persistent.indexed != persistent.signature || persistent.sorted.size() != count)
+        {
+            persistent.sorted.resize(count, false);
+            for (auto idx = 0; idx < count; ++idx) persistent.sorted[idx] = idx;
+
+            std::sort(persistent.sorted.data(), persistent.sorted.data() + count, [&items](int32_t lhs, int32_t rhs) {
+                auto ltext = items[lhs].text, rtext = items[rhs].text;
+                auto less = std::lexicographical_compare(ltext.begin(), ltext.end(), rtext.begin(), rtext.end(),
+                    [](char a, char b) { return FoldCase(a) < FoldCase(b); });
+                auto greater = std::lexicographical_compare(rtext.begin(), rtext.end(), ltext.begin(), ltext.end(),
+                    [](char a, char b) { return FoldCase(a) < FoldCase(b); });
+                return less || (!greater && lhs < rhs);
+            });
+
+            persistent.indexed = persistent.signature;
+            persistent.queryChanged = true;
+        }
+
+        if (!persistent.queryChanged) return;
+
+        std::string_view query{ persistent.query, (std::size_t)persistent.querylen };
+        auto filter = (state.sizePolicy & DD_FilterOptions) && !query.empty();
+        persistent.shown.clear(false);
+        persistent.rank.resize(count, false);
+
+        for (auto idx = 0; idx < count; ++idx)
+        {
+            if (!filter || OptionContainsQuery(items[idx].text, query))
+            {
+                persistent.rank[idx] = persistent.shown.size();
+                persistent.shown.push_back(idx);
+            }
+            else persistent.rank[idx] = -1;
+        }
+
+        if (!query.empty())
+        {
+            auto begin = persistent.sorted.data(), end = persistent.sorted.data() + count;
+            auto it = std::lower_bound(begin, end, query, [&items](int32_t idx, std::string_view query) {
+                return CompareOptionPrefix(items[idx].text, query) < 0;
+            });
+
+            // Jump to the prefix match which comes first in display order
+            auto target = -1;
+            for (; it != end && CompareOptionPrefix(items[*it].text, query) == 0; ++it)
+                if (persistent.rank[*it] != -1 && (target == -1 || persistent.rank[*it] < persistent.rank[target]))
+                    target = *it;
+
+            if (target == -1 && filter && !persistent.shown.empty())
+                target = persistent.shown[0];
+            if (target != -1)
+            {
+                persistent.active = target;
+                ScrollToDropDownOption(persistent, target);
+            }
+        }
+
+        if (persistent.active >= count || (persistent.active != -1 && persistent.rank[persistent.active] == -1))
+            persistent.active = -1;
+
+        ClampDropDownWindow(persistent);
+        persistent.queryChanged = false;
+    }
+
+    static void SelectDropDownOption(DropDownState& state, DropDownPersistentState& persistent, int32_t idx)
+    {
+        state.selected = idx;
+        state.opened = false;
+        state.selectedText = persistent.items[idx].text;
+        state.selectedTextType = persistent.items[idx].textType;
+        if (state.out) *state.out = idx;
+        WidgetContextData::RemovePopup();
+    }
+
+    // Keyboard navigation over shown options and type-ahead search
+    static void HandleDropDownKeys(DropDownState& state, DropDownPersistentState& persistent, const IODescriptor& io)
+    {
+        persistent.queryIdle += io.deltaTime;
+        if (persistent.querylen > 0 && !(state.sizePolicy & DD_FilterOptions) &&
+            persistent.queryIdle > GLIMMER_DROPDOWN_TYPEAHEAD_TIMEOUT)
+            persistent.querylen = 0;
+
+        if (persistent.shown.empty()) return;
+
+        auto pos = persistent.active != -1 && persistent.active < persistent.rank.size() ?
+            persistent.rank[persistent.active] : -1;
+        auto last = persistent.shown.size() - 1;
+
+        for (auto kidx = 0; io.key[kidx] != Key_Invalid; ++kidx)
+        {
+            auto key = io.key[kidx];
+
+            switch (key)
+            {
+            case Key_UpArrow: pos = std::max(0, pos - 1); break;
+            case Key_DownArrow: pos = std::min(last, pos + 1); break;
+            case Key_PageUp: pos = std::max(0, pos - GLIMMER_DROPDOWN_MAX_VISIBLE_OPTIONS); break;
+            case Key_PageDown: pos = std::min(last, std::max(pos, 0) + GLIMMER_DROPDOWN_MAX_VISIBLE_OPTIONS); break;
+            case Key_Home: pos = 0; break;
+            case Key_End: pos = last; break;
+            case Key_Enter:
+                if (pos != -1) SelectDropDownOption(state, persistent, persistent.shown[pos]);
+                return;
+            case Key_Backspace:
+                if (persistent.querylen > 0)
+                {
+                    persistent.query[--persistent.querylen] = 0;
+                    persistent.queryChanged = true;
+                    persistent.queryIdle = 0.f;
+                }
+                continue;
+            default:
+            {
+                auto ch = key >= 0 && key < (int)KeyMappings.size() ? KeyMappings[key].first : 0;
+                if (ch != 0 && !(io.modifiers & (CtrlKeyMod | AltKeyMod)) &&
+                    persistent.querylen < GLIMMER_DROPDOWN_TYPEAHEAD_SZ - 1)
+                {
+                    persistent.query[persistent.querylen++] = FoldCase(ch);
+                    persistent.queryChanged = true;
+                    persistent.queryIdle = 0.f;
+                }
+                continue;
+            }
+            }
+
+            persistent.active = persistent.shown[pos];
+            ScrollToDropDownOption(persistent, persistent.active);
+        }
+    }
+
+    static void OpenDropDown(DropDownState& state, DropDownPersistentState& persistent)
+    {
+        state.opened = true;
+        persistent.querylen = 0;
+        persistent.query[0] = 0;
+        persistent.queryChanged = true;
+        persistent.active = state.selected;
+        ScrollToDropDownOption(persistent, state.selected);
+    }
+
+    void ShowDropDownOptions(WidgetContextData& parent, DropDownState& state, DropDownPersistentState& persistent, 
+        int32_t id, const ImRect& margin, const ImRect& border, const ImRect& padding, const ImRect& content, 
+        IRenderer& renderer)
+    {
+        if (persistent.context == nullptr) return;
 
         const auto& ddstyle = parent.dropdownStyles[log2((unsigned)state.state)].top();
 
         BEGIN_LOG_ARRAY("dropdown-items-geometry");
-        ImVec2 maxsz = persistent.maxsz;
-        maxsz.x += persistent.extra.x;
         persistent.context->popupOrigin = { margin.Min.x, margin.Max.y };
-        auto maxw = 0.f;
-        auto idx = 0;
+        ImRect bounds{ { FLT_MAX, FLT_MAX }, { -FLT_MAX, -FLT_MAX } };
+        auto to = std::min(persistent.first + GLIMMER_DROPDOWN_MAX_VISIBLE_OPTIONS, persistent.shown.size());
 
-        for (auto& item : persistent.items)
+        // Only the window of shown options has been laid out, the rest have no geometry
+        for (auto pos = persistent.first; pos < to; ++pos)
         {
+            auto idx = persistent.shown[pos];
+            if (idx >= persistent.items.size()) break;
+
+            auto& item = persistent.items[idx];
+            if (item.geometry.Min.x > item.geometry.Max.x) continue;
+
             if (state.selected == idx)
                 DrawItemBackground(persistent.context->deferedRenderer,
                     item.geometry, parent.dropdownStyles[WSI_Selected].top().optionBgColor);
@@ -3916,50 +4948,55 @@ namespace glimmer
                     item.geometry, parent.dropdownStyles[WSI_Hovered].top().optionBgColor);
 
             item.geometry.Translate(persistent.context->popupOrigin);
+            bounds.Add(item.geometry);
             LOG_RECT(item.geometry);
+        }
 
-            if (state.sizePolicy & DD_FitToLongestOption)
-                maxw = std::max(maxw, item.geometry.GetWidth());
-
-            ++idx;
+        // Scroll thumb for options outside the window
+        if (persistent.shown.size() > GLIMMER_DROPDOWN_MAX_VISIBLE_OPTIONS && bounds.Min.y < bounds.Max.y)
+        {
+            auto height = bounds.GetHeight();
+            auto total = (float)persistent.shown.size();
+            auto width = persistent.indicator.x * 0.25f;
+            ImRect thumb{ { bounds.Max.x - width, bounds.Min.y + height * ((float)persistent.first / total) },
+                { bounds.Max.x, bounds.Min.y + height * ((float)to / total) } };
+            DrawItemBackground(persistent.context->deferedRenderer, thumb,
+                parent.dropdownStyles[WSI_Selected].top().optionBgColor);
         }
 
-        if (maxw > maxsz.x)
-            maxsz.x = maxw - persistent.extra.x;
-        else
-            maxsz.x -= persistent.extra.x;
-        persistent.maxsz = maxsz;
         END_LOG_ARRAY();
 
         EndPopUp(*persistent.context, ddstyle.popupBgColor,
             POP_EnsureVisible | (ddstyle.occludeBg ? POP_Occlude : 0));
         PopNestedSource(persistent.context);
 
-        idx = 0;
-        state.hovered = -1;
+        state.hovered = persistent.active;
 		state.maxOptionSz = persistent.maxsz;
         auto io = Config.platform->CurrentIO(persistent.context);
 
-        for (const auto& item : persistent.items)
+        if (bounds.Contains(io.mousepos) && io.mouseWheel != 0.f)
         {
+            persistent.first -= (int32_t)(io.mouseWheel > 0.f ? std::ceil(io.mouseWheel) : std::floor(io.mouseWheel));
+            ClampDropDownWindow(persistent);
+        }
+
+        for (auto pos = persistent.first; pos < to; ++pos)
+        {
+            auto idx = persistent.shown[pos];
+            if (idx >= persistent.items.size()) break;
+
+            const auto& item = persistent.items[idx];
             if (item.geometry.Contains(io.mousepos))
             {
                 Config.platform->SetMouseCursor(MouseCursor::Grab);
-                state.hovered = idx;
+                state.hovered = persistent.active = idx;
 
                 if (io.clicked())
                 {
-                    state.selected = idx;
-                    state.opened = false;
-                    state.selectedText = persistent.items[idx].text;
-                    state.selectedTextType = persistent.items[idx].textType;
-                    if (state.out) *state.out = idx;
-                    WidgetContextData::RemovePopup();
+                    SelectDropDownOption(state, persistent, idx);
                     break;
                 }
             }
-
-            ++idx;
         }
     }
 
@@ -3980,13 +5017,16 @@ namespace glimmer
                 WidgetContextData::CurrentWidgetId = id;
             }
 
-            if (!state.opened && (state.state & WS_Focused) && io.isKeyPressed(Key::Key_Enter))
-                state.opened = true;
+            if (state.opened)
+                HandleDropDownKeys(state, persistent, io);
+            else if ((state.state & WS_Focused) && io.isKeyPressed(Key::Key_Enter))
+                OpenDropDown(state, persistent);
 
             if (ismouseover && io.clicked())
             {
                 result.event = WidgetEvent::Clicked; 
-                state.opened = !state.opened;
+                if (!state.opened) OpenDropDown(state, persistent);
+                else state.opened = false;
             }
             else if (ismouseover && io.isLeftMouseDoubleClicked())
             {
@@ -4080,6 +5120,7 @@ namespace glimmer
     {
 		auto& persistent = context.DropDownState(id);
         persistent.items.clear(true);
+        persistent.signature = 14695981039346656037ull;
         persistent.maxsz = ImVec2{};
         for (auto idx = 0; idx < WT_TotalTypes; ++idx)
             persistent.widgets[idx].clear(true);
@@ -4125,11 +5166,12 @@ namespace glimmer
         config.sizePolicy = spolicy;
         context.currentDropDown.geometry = geometry;
         context.currentDropDown.neighbors = neighbors;
+        context.currentDropDown.longestOption = -1;
         context.currentDropDown.id = id;
 		return BeginDropDownImpl(context, config, id, text, type);
     }
 
-    bool BeginDropDown(std::string_view id, std::string_view text, TextType type, int32_t spolicy, int32_t geometry, const NeighborWidgets& neighbors)
+    bool BeginDropDown(StringId id, std::string_view text, TextType type, int32_t spolicy, int32_t geometry, const NeighborWidgets& neighbors)
     {
         auto& context = GetContext();
         auto iid = GetIdFromString(id, WT_DropDown).first;
@@ -4139,25 +5181,38 @@ namespace glimmer
         config.sizePolicy = spolicy;
         context.currentDropDown.geometry = geometry;
         context.currentDropDown.neighbors = neighbors;
+        context.currentDropDown.longestOption = -1;
         context.currentDropDown.id = iid;
         return BeginDropDownImpl(context, config, iid, text, type);
     }
 
-    void BeginDropDownOption(std::string_view optionText, TextType type, bool isLongestOption)
+    bool BeginDropDownOption(std::string_view optionText, TextType type, bool isLongestOption)
     {
         auto& context = *GetContext().parentContext;
-		auto& items = context.DropDownState(context.currentDropDown.id).items;
+        auto& persistent = context.DropDownState(context.currentDropDown.id);
+		auto& items = persistent.items;
         auto& item = items.emplace_back();
         item.text = optionText;
         item.textType = type;
         if (isLongestOption) 
             context.currentDropDown.longestOption = items.size() - 1;
+
+        // FNV-1a over option texts, prefix index is rebuilt when it changes
+        for (auto ch : optionText)
+            persistent.signature = (persistent.signature ^ (uint8_t)ch) * 1099511628211ull;
+        persistent.signature = (persistent.signature ^ 0xffu) * 1099511628211ull;
+
 		PushStyle(WS_AllStates, "background-color: transparent;");
+        return IsDropDownOptionShown(persistent, items.size() - 1);
     }
 
     void AddDropDownOption(std::string_view optionText, TextType type, bool isLongestOption)
     {
-        BeginDropDownOption(optionText, type, isLongestOption);
+        if (!BeginDropDownOption(optionText, type, isLongestOption))
+        {
+            EndDropDownOption();
+            return;
+        }
 
         static char idstr[255];
 		memset(idstr, 0, 255);
@@ -4206,6 +5261,7 @@ namespace glimmer
                 EndRegion();
                 PopStyle(1, WS_AllStates);
                 PopContext();
+                UpdateDropDownIndex(ddstate, persistent);
             }
         }
         
@@ -4217,10 +5273,26 @@ namespace glimmer
 
             if (ddstate.opened)
             {
-                auto lidx = ddctx->currentDropDown.longestOption != -1 ? ddctx->currentDropDown.longestOption : 0;
-                const auto& item = persistent.items[lidx];
-                persistent.maxsz = GetTextSize(item.textType, item.text, style.font,
-                    -1.f, *Config.renderer);
+                // All options are measured once they or the font change (unless one is marked as longest),
+                // as only the shown window of options is laid out, whose widest option changes on scroll
+                auto hint = ddctx->currentDropDown.longestOption;
+                if (persistent.measured != persistent.signature || persistent.measuredHint != hint ||
+                    persistent.measuredFont.font != style.font.font || persistent.measuredFont.size != style.font.size)
+                {
+                    persistent.longestsz = ImVec2{};
+                    for (auto idx = hint != -1 ? hint : 0; idx < (hint != -1 ? hint + 1 : persistent.items.size()); ++idx)
+                    {
+                        const auto& item = persistent.items[idx];
+                        persistent.longestsz = ImMax(persistent.longestsz, GetTextSize(item.textType, item.text, 
+                            style.font, -1.f, *Config.renderer));
+                    }
+
+                    persistent.measured = persistent.signature;
+                    persistent.measuredHint = hint;
+                    persistent.measuredFont = style.font;
+                }
+
+                persistent.maxsz = persistent.longestsz;
             }
 			else if (longestopt.has_value())
                 persistent.maxsz = GetTextSize(longestopt->second, longestopt->first, style.font,
@@ -4964,7 +6036,7 @@ namespace glimmer
         return true;
     }
 
-    bool BeginTabBar(std::string_view id, int32_t geometry, const NeighborWidgets& neighbors)
+    bool BeginTabBar(StringId id, int32_t geometry, const NeighborWidgets& neighbors)
     {
         auto [iid, __] = GetIdFromString(id, WT_TabBar);
         return BeginTabBar(iid, geometry, neighbors);
@@ -5401,7 +6473,7 @@ namespace glimmer
         return true;
     }
 
-    bool BeginNavDrawer(std::string_view id, bool expandable, Direction dir, int32_t geometry, const NeighborWidgets& neighbors)
+    bool BeginNavDrawer(StringId id, bool expandable, Direction dir, int32_t geometry, const NeighborWidgets& neighbors)
     {
         auto [iid, __] = GetIdFromString(id, WT_NavDrawer);
         return BeginNavDrawer(iid, expandable, dir, geometry, neighbors);
@@ -5475,7 +6547,7 @@ namespace glimmer
         return true;
     }
 
-    bool BeginAccordion(std::string_view id, int32_t geometry, const NeighborWidgets& neighbors)
+    bool BeginAccordion(StringId id, int32_t geometry, const NeighborWidgets& neighbors)
     {
         auto [iid, __] = GetIdFromString(id, WT_Accordion);
         return BeginAccordion(iid, geometry, neighbors);
@@ -5769,6 +6841,212 @@ namespace glimmer
         }
     }
 
+    bool ItemGridSelection::isRowSelected(int32_t row, int16_t depth) const
+    {
+        return depth < depths.size() ? depths[depth].rows.contains(row) : inverted;
+    }
+
+    bool ItemGridSelection::isColumnSelected(int16_t col) const
+    {
+        return cols.contains(col);
+    }
+
+    bool ItemGridSelection::isCellSelected(int32_t row, int16_t col, int16_t depth) const
+    {
+        return (depth < depths.size() && col < depths[depth].cells.size()) ? 
+            depths[depth].cells[col].contains(row) : inverted;
+    }
+
+    void ItemGridSelection::selectRows(int32_t from, int32_t to, int16_t depth, bool select)
+    {
+        auto& rows = at(depth).rows;
+        select ? rows.insert(from, to) : rows.erase(from, to);
+    }
+
+    void ItemGridSelection::selectColumns(int16_t from, int16_t to, bool select)
+    {
+        select ? cols.insert(from, to) : cols.erase(from, to);
+    }
+
+    void ItemGridSelection::selectCell(int32_t row, int16_t col, int16_t depth, bool select)
+    {
+        auto& cells = cellsAt(col, depth);
+        select ? cells.insert(row, row) : cells.erase(row, row);
+    }
+
+    void ItemGridSelection::selectAll()
+    {
+        for (auto& depth : depths)
+        {
+            depth.rows.fill();
+            for (auto& cells : depth.cells) cells.fill();
+        }
+
+        cols.fill();
+        inverted = true;
+    }
+
+    void ItemGridSelection::invert()
+    {
+        for (auto& depth : depths)
+        {
+            depth.rows.invert();
+            for (auto& cells : depth.cells) cells.invert();
+        }
+
+        cols.invert();
+        inverted = !inverted;
+    }
+
+    void ItemGridSelection::clear()
+    {
+        for (auto& depth : depths)
+        {
+            depth.rows.clear();
+            for (auto& cells : depth.cells) cells.clear();
+        }
+
+        cols.clear();
+        inverted = false;
+    }
+
+    void ItemGridSelection::shiftRows(int32_t delta)
+    {
+        for (auto& depth : depths)
+        {
+            depth.rows.shift(delta);
+            for (auto& cells : depth.cells) cells.shift(delta);
+        }
+    }
+
+    bool ItemGridSelection::empty() const
+    {
+        if (inverted || !cols.empty()) return false;
+
+        for (const auto& depth : depths)
+        {
+            if (!depth.rows.empty()) return false;
+            for (const auto& cells : depth.cells)
+                if (!cells.empty()) return false;
+        }
+
+        return true;
+    }
+
+    ItemGridSelection::SetT::ValueRange ItemGridSelection::rows(int16_t depth, int32_t limit) const
+    {
+        return depth < depths.size() ? depths[depth].rows.values(limit) : unset().values(limit);
+    }
+
+    ItemGridSelection::SetT::ValueRange ItemGridSelection::columns(int16_t limit) const
+    {
+        return cols.values(limit);
+    }
+
+    ItemGridSelection::SetT::ValueRange ItemGridSelection::cells(int16_t col, int16_t depth, int32_t limit) const
+    {
+        return (depth < depths.size() && col < depths[depth].cells.size()) ?
+            depths[depth].cells[col].values(limit) : unset().values(limit);
+    }
+
+    int32_t ItemGridSelection::rowCount(int16_t depth, int32_t limit) const
+    {
+        return depth < depths.size() ? depths[depth].rows.count(limit) : inverted ? limit : 0;
+    }
+
+    ItemGridSelection::DepthSelection& ItemGridSelection::at(int16_t depth)
+    {
+        while (depths.size() <= depth)
+        {
+            auto& added = depths.emplace_back();
+            if (inverted) added.rows.fill();
+        }
+
+        return depths[depth];
+    }
+
+    ItemGridSelection::SetT& ItemGridSelection::cellsAt(int16_t col, int16_t depth)
+    {
+        auto& selection = at(depth);
+        while (selection.cells.size() <= col)
+        {
+            auto& added = selection.cells.emplace_back();
+            if (inverted) added.fill();
+        }
+
+        return selection.cells[col];
+    }
+
+    const ItemGridSelection::SetT& ItemGridSelection::unset() const
+    {
+        static SetT none, all;
+        if (!all.inverted()) all.fill();
+        return inverted ? all : none;
+    }
+
+    ItemGridStream::ItemGridStream(int32_t capacity, int32_t pending)
+        : _pending{ pending }
+    {
+        assert(capacity > 0);
+        _rows.resize(capacity, true);
+    }
+
+    bool ItemGridStream::append(std::span<const std::string_view> cells)
+    {
+        auto row = _pending.back();
+        if (row == nullptr) return false;
+
+        int16_t length = 0;
+        row->columns = (int16_t)std::min<size_t>(cells.size(), GLIMMER_ITEMGRID_STREAM_MAX_COLUMNS);
+        for (int16_t col = 0; col < row->columns; ++col)
+        {
+            auto sz = (int16_t)std::min<size_t>(cells[col].size(), GLIMMER_ITEMGRID_STREAM_ROW_SZ - length);
+            std::memcpy(row->text + length, cells[col].data(), sz);
+            length += sz;
+            row->ends[col] = length;
+        }
+
+        _pending.push();
+        return true;
+    }
+
+    std::pair<int32_t, int32_t> ItemGridStream::consume()
+    {
+        auto appended = 0, discarded = 0;
+        const auto capacity = _rows.size();
+
+        // Bounded by queue capacity, so that a fast producer cannot stall the frame
+        for (auto row = _pending.front(); row != nullptr && appended < _pending.capacity(); row = _pending.front())
+        {
+            auto& dest = _rows[(_origin + _count) % capacity];
+            dest.columns = row->columns;
+            std::memcpy(dest.ends, row->ends, sizeof(int16_t) * row->columns);
+            std::memcpy(dest.text, row->text, row->columns > 0 ? row->ends[row->columns - 1] : 0);
+            _pending.pop();
+
+            if (_count == capacity)
+            {
+                _origin = (_origin + 1) % capacity;
+                ++discarded;
+            }
+            else ++_count;
+
+            ++appended;
+            ++_total;
+        }
+
+        return { appended, discarded };
+    }
+
+    std::string_view ItemGridStream::cell(int32_t row, int16_t col) const
+    {
+        const auto& data = _rows[(_origin + row) % _rows.size()];
+        if (col >= data.columns) return std::string_view{};
+
+        auto start = col == 0 ? 0 : data.ends[col - 1];
+        return std::string_view{ data.text + start, (size_t)(data.ends[col] - start) };
+    }
+
     template <typename ContainerT>
     static bool UpdateSubHeadersResize(Span<ContainerT> headers, ItemGridPersistentState& gridstate,
         const ImRect& rect, int parent, int chlevel, bool mouseDown)
@@ -5838,6 +7116,7 @@ namespace glimmer
             {
                 ImRect extendRect{ evprop.lastPos, mousepos };
                 evprop.modified += (mousepos.x - evprop.lastPos.x);
+                if (mousepos.x != evprop.lastPos.x) gridstate.measureGeneration++;
                 evprop.lastPos = mousepos;
                 UpdateSubHeadersResize(headers, gridstate, extendRect, col - 1, level + 1, true);
                 Config.platform->SetMouseCursor(MouseCursor::ResizeHorizontal);
@@ -5851,6 +7130,7 @@ namespace glimmer
             {
                 ImRect extendRect{ evprop.lastPos, mousepos };
                 evprop.modified += (mousepos.x - evprop.lastPos.x);
+                if (mousepos.x != evprop.lastPos.x) gridstate.measureGeneration++;
                 evprop.lastPos = mousepos;
                 UpdateSubHeadersResize(headers, gridstate, extendRect, col - 1, level + 1, false);
             }
@@ -5892,175 +7172,1578 @@ namespace glimmer
                         siblingCount++; movingcol = col;
                     }
 
-                if (siblingCount > 1) break;
-                else if (level > 0) { parent = headers[level - 1][parent].parent; level--; }
-            }
+                if (siblingCount > 1) break;
+                else if (level > 0) { parent = headers[level - 1][parent].parent; level--; }
+            }
+
+            movingcol = siblingCount == 1 ? parent : movingcol;
+            level = siblingCount == 1 ? level - 1 : level;
+
+            auto lcol = col;
+            auto& mcol = headers[level][lcol];
+            gridstate.drag.config = mcol;
+            gridstate.drag.mouseDown = true;
+            gridstate.drag.lastPos = mousepos;
+            gridstate.drag.startPos = mousepos;
+            gridstate.drag.potentialColumn = movingcol;
+            gridstate.drag.level = level;
+            gridstate.state = ItemGridCurrentState::ReorderingColumns;
+            LOGERROR("\nMarking column (v: %d, l: %d) as moving (%f -> %f)\n", vcol, lcol, mcol.content.Min.x, mcol.content.Max.x);
+        }
+        else if (isMouseDown && gridstate.drag.mouseDown && gridstate.drag.potentialColumn == vcol && gridstate.drag.level == level &&
+            mousepos.x != gridstate.drag.startPos.x)
+        {
+            gridstate.drag.column = gridstate.drag.potentialColumn;
+        }
+        else if (isMouseDown && gridstate.drag.mouseDown && gridstate.drag.column == vcol && gridstate.drag.level == level)
+        {
+            // This implying we are dragging the column around
+            auto diff = mousepos.x - gridstate.drag.lastPos.x;
+
+            if (diff > 0.f && (int16_t)headers[level].size() > (vcol + 1))
+            {
+                auto ncol = gridstate.colmap[level].vtol[vcol + 1];
+                auto& next = headers[level][ncol];
+
+                if ((mousepos.x - gridstate.drag.startPos.x) >= next.extent.GetWidth())
+                    gridstate.swapColumns(vcol, vcol + 1, headers, level);
+            }
+            else if (diff < 0.f && (col - 1) >= 0)
+            {
+                auto& prev = headers[level][col - 1];
+
+                if ((gridstate.drag.startPos.x - mousepos.x) >= prev.extent.GetWidth())
+                    gridstate.swapColumns(col - 1, col, headers, level);
+            }
+
+            gridstate.drag.lastPos = mousepos;
+        }
+        else if (!isMouseDown)
+        {
+            gridstate.drag = ItemGridPersistentState::HeaderCellDragState{};
+            gridstate.state = ItemGridCurrentState::Default;
+            gridstate.drag.potentialColumn = -1;
+        }
+    }
+
+    static void AddItemGridScrollBars(ItemGridBuilder& builder, ItemGridPersistentState& state, 
+        const ItemGridConfig& config, IRenderer& renderer, ImRect viewport, const IODescriptor& io)
+    {
+        auto& context = *WidgetContextData::CurrentItemGridContext;
+
+        if (config.frozencols > 0)
+        {
+            const auto& lastFrozenHeader = builder.headers[builder.currlevel][config.frozencols - 1];
+            viewport.Min.x = lastFrozenHeader.extent.Max.x + config.gridwidth;
+            builder.totalsz.x -= (viewport.Min.x - builder.origin.x);
+
+            // Determine if any col content in frozen part exceeds the available space w.r.t column widths
+            // Enable horizontal scrollbar in that case
+            if (builder.maxColWidth > lastFrozenHeader.extent.GetWidth())
+            {
+                state.altscroll.viewport.Min = builder.origin;
+                state.altscroll.viewport.Max = { lastFrozenHeader.extent.Max.x, builder.size.y + builder.origin.y };
+
+                ImVec2 sz;
+                state.altscroll.content.y = state.altscroll.viewport.GetHeight();
+                state.altscroll.content.x = (config.frozencols - 1) > 0 ? builder.headers[builder.currlevel][config.frozencols - 2].extent.Max.x +
+                    builder.maxColWidth : builder.maxColWidth;
+                state.altscroll.type = config.scrollprops;
+                HandleHScroll(state.altscroll, renderer, io, Config.scrollbar.width);
+            }
+            else if (config.scrollprops & ST_Always_H)
+            {
+                auto max = builder.origin + builder.size;
+                renderer.DrawRect(ImVec2{ builder.origin.x, max.y - Config.scrollbar.width }, ImVec2{ lastFrozenHeader.extent.Max.x, max.y },
+                    ToRGBA(255, 255, 255), true);
+            }
+        }
+
+        // builder.totalsz is in absolute coordinates, convert it to size
+        // state.scroll.content is adjusted in y-axis because y-absolute coordinates are
+        // shifted by scroll amount in y-direction, whereas x-coordiantes are not
+        auto sz = builder.totalsz - builder.origin - ImVec2{ 0.f, builder.headerHeight };
+        if (config.scrollprops & ST_Always_H) viewport.Max.y += Config.scrollbar.width;
+        if (config.scrollprops & ST_Always_V) viewport.Max.x += Config.scrollbar.width;
+        state.scroll.viewport = viewport;
+        state.scroll.content = sz + ImVec2{ 0.f,  state.scroll.state.pos.y };
+        state.scroll.type = config.scrollprops;
+
+        auto hasHScroll = HandleHScroll(state.scroll, renderer, io, Config.scrollbar.width);
+        HandleVScroll(state.scroll, renderer, io, Config.scrollbar.width, hasHScroll,
+            std::make_pair(builder.origin.y, builder.origin.y + builder.size.y));
+    }
+
+    bool BeginItemGrid(int32_t id, int32_t geometry, const NeighborWidgets& neighbors)
+    {
+        auto& context = GetContext();
+        auto& builder = context.itemGrids.push();
+        const auto& config = context.GetState(id).state.grid;
+        const auto style = context.GetStyle(WS_Default, id);
+
+        builder.id = id;
+        builder.geometry = geometry;
+        builder.neighbors = neighbors;
+
+        LayoutItemDescriptor item;
+        item.wtype = WT_ItemGrid;
+        item.id = id;
+        AddExtent(item, style, neighbors);
+        if (config.scrollprops & ST_Always_H) item.content.Max.y -= Config.scrollbar.width;
+        if (config.scrollprops & ST_Always_V) item.content.Max.x -= Config.scrollbar.width;
+        builder.size = item.content.GetSize();
+        builder.origin = builder.nextpos = item.content.Min;
+
+        context.CurrentItemGridContext = &context;
+        PushContext(id, NestedContextSourceType::ItemGrid);
+        
+        return true;
+    }
+
+    bool BeginItemGrid(StringId id, int32_t geometry, const NeighborWidgets& neighbors)
+    {
+        auto [iid, __] = GetIdFromString(id, WT_ItemGrid);
+        return BeginItemGrid(iid, geometry, neighbors);
+    }
+
+    void SetItemGridBehavior(int16_t sortedcol, int32_t highlights, int32_t selection, int32_t scrollprops,
+        bool uniformRowHeights, bool isTree)
+    {
+        auto& context = *WidgetContextData::CurrentItemGridContext;
+        auto& builder = context.itemGrids.top();
+        auto& config = context.GetState(builder.id).state.grid;
+        auto& state = context.GridState(builder.id);
+        assert(builder.phase == ItemGridConstructPhase::None);
+
+        config.highlights = highlights;
+        config.selection = selection;
+        config.scrollprops = scrollprops;
+        config.uniformRowHeights = uniformRowHeights;
+        config.isTree = isTree;
+        state.sortedCol = sortedcol;
+    }
+
+    void SetItemGridProviders(ItemGridConfig::CellPropertiesProviderT cellprops,
+        ItemGridConfig::CellWidgetProviderT cellwidget,
+        ItemGridConfig::CellContentProviderT cellcontent,
+        ItemGridConfig::HeaderProviderT header)
+    {
+        auto& context = *WidgetContextData::CurrentItemGridContext;
+        auto& builder = context.itemGrids.top();
+        auto& config = context.GetState(builder.id).state.grid;
+        assert(builder.phase == ItemGridConstructPhase::None);
+        assert(cellprops != nullptr);
+
+        config.cellprops = cellprops;
+        config.cellwidget = cellwidget;
+        config.cellcontent = cellcontent;
+        config.header = header;
+    }
+
+    void SetItemGridSortKeyProvider(ItemGridConfig::SortKeyProviderT sortkey)
+    {
+        auto& context = *WidgetContextData::CurrentItemGridContext;
+        auto& builder = context.itemGrids.top();
+        auto& config = context.GetState(builder.id).state.grid;
+        assert(builder.phase == ItemGridConstructPhase::None);
+        config.sortkey = sortkey;
+    }
+
+    void InvalidateItemGridSort(int32_t id)
+    {
+        GetContext().GridState(id).sorting.dirty = true;
+    }
+
+    void InvalidateItemGridSort(StringId id)
+    {
+        auto [iid, __] = GetIdFromString(id, WT_ItemGrid);
+        InvalidateItemGridSort(iid);
+    }
+
+    void SetItemGridFilterProvider(ItemGridConfig::FilterTextProviderT filtertext)
+    {
+        auto& context = *WidgetContextData::CurrentItemGridContext;
+        auto& builder = context.itemGrids.top();
+        auto& config = context.GetState(builder.id).state.grid;
+        assert(builder.phase == ItemGridConstructPhase::None);
+        config.filtertext = filtertext;
+    }
+
+    void InvalidateItemGridFilter(int32_t id)
+    {
+        GetContext().GridState(id).filtering.dirty = true;
+    }
+
+    void InvalidateItemGridFilter(StringId id)
+    {
+        auto [iid, __] = GetIdFromString(id, WT_ItemGrid);
+        InvalidateItemGridFilter(iid);
+    }
+
+    static bool IsValidColumnFormat(ItemGridColumnType type, std::string_view format);
+
+    void SetItemGridDataSource(const ItemGridDataSource& source)
+    {
+        auto& context = *WidgetContextData::CurrentItemGridContext;
+        auto& builder = context.itemGrids.top();
+        auto& config = context.GetState(builder.id).state.grid;
+        auto& state = context.GridState(builder.id);
+        assert(builder.phase == ItemGridConstructPhase::None);
+
+        // New data or version invalidates formatted cells, sorted order and filtered rows
+        if (source.version != config.source.version || source.columns.data() != config.source.columns.data() ||
+            source.columns.size() != config.source.columns.size())
+        {
+            state.formattedCells.clear();
+            state.sorting.dirty = true;
+            state.filtering.dirty = true;
+
+            // Formats are passed to snprintf, those which do not match the argument fall back to default
+            state.formats.resize(source.columns.size());
+            for (size_t col = 0; col < source.columns.size(); ++col)
+            {
+                const auto& column = source.columns[col];
+                auto valid = IsValidColumnFormat(column.type, column.format);
+                assert(valid && "Column format does not match column type");
+                state.formats[col].assign(valid ? column.format : std::string_view{});
+            }
+        }
+
+        config.source = source;
+    }
+
+    // Children loaded by application, possibly from other threads, consumed by the grid in next frame
+    struct ItemGridTreeChildren
+    {
+        int32_t grid = -1;
+        int32_t node = -1;
+        std::vector<int32_t> children;
+    };
+
+    static std::mutex TreeChildrenLock;
+    static std::vector<ItemGridTreeChildren> LoadedTreeChildren;
+
+    void SetItemGridTreeModel(const ItemGridTreeModel& model)
+    {
+        auto& context = *WidgetContextData::CurrentItemGridContext;
+        auto& builder = context.itemGrids.top();
+        auto& config = context.GetState(builder.id).state.grid;
+        assert(builder.phase == ItemGridConstructPhase::None);
+        assert(model.loadChildren != nullptr);
+        config.tree = model;
+        config.isTree = true;
+    }
+
+    void SetItemGridTreeChildren(int32_t id, int32_t node, std::span<const int32_t> children)
+    {
+        // Grid state is not touched here as this can be invoked from any thread
+        std::unique_lock<std::mutex> guard{ TreeChildrenLock };
+        LoadedTreeChildren.push_back({ id, node, std::vector<int32_t>{ children.begin(), children.end() } });
+    }
+
+    void SetItemGridStream(ItemGridStream* stream)
+    {
+        auto& context = *WidgetContextData::CurrentItemGridContext;
+        auto& builder = context.itemGrids.top();
+        auto& config = context.GetState(builder.id).state.grid;
+        assert(builder.phase == ItemGridConstructPhase::None);
+        config.stream = stream;
+    }
+
+#pragma region ItemGrid columnar data
+
+    static bool HasDataSource(const ItemGridConfig& config)
+    {
+        return !config.source.columns.empty();
+    }
+
+    // Whether format has exactly one conversion, which takes the argument passed for column's type
+    // i.e. long long for integers and double for reals. Timestamp formats go to strftime.
+    static bool IsValidColumnFormat(ItemGridColumnType type, std::string_view format)
+    {
+        if (type == ItemGridColumnType::Text || type == ItemGridColumnType::Timestamp || format.empty()) return true;
+
+        auto conversions = 0;
+        auto isany = [&format](size_t idx, const char* chars) {
+            return idx < format.size() && format[idx] != 0 && std::strchr(chars, format[idx]) != nullptr;
+        };
+
+        for (size_t idx = 0; idx < format.size(); ++idx)
+        {
+            if (format[idx] != '%') continue;
+            if (isany(++idx, "%")) continue;
+
+            while (isany(idx, "-+ #0")) ++idx;
+            while (isany(idx, "0123456789")) ++idx;
+            if (isany(idx, ".")) { ++idx; while (isany(idx, "0123456789")) ++idx; }
+
+            if (type == ItemGridColumnType::Integer)
+            {
+                if (format.substr(idx, 2) != "ll" || !isany(idx + 2, "diouxX")) return false;
+                idx += 2;
+            }
+            else
+            {
+                if (isany(idx, "l")) ++idx;
+                if (!isany(idx, "fFeEgGaA")) return false;
+            }
+
+            ++conversions;
+        }
+
+        return conversions == 1;
+    }
+
+    // Format value of a number/timestamp column into buffer with validated format, empty for default,
+    // text columns are returned as is
+    static std::string_view FormatColumnValue(const ItemGridColumnData& column, const std::string& format, 
+        int32_t row, char* buffer, int32_t size)
+    {
+        using namespace std::chrono;
+
+        auto length = 0;
+
+        switch (column.type)
+        {
+        case ItemGridColumnType::Text:
+            return column.texts[row];
+        case ItemGridColumnType::Integer:
+            length = std::snprintf(buffer, size, !format.empty() ? format.c_str() : "%lld", (long long)column.integers[row]);
+            break;
+        case ItemGridColumnType::Real:
+            length = std::snprintf(buffer, size, !format.empty() ? format.c_str() : "%g", column.reals[row]);
+            break;
+        case ItemGridColumnType::Timestamp:
+        {
+            // std::gmtime is not reentrant, filtering may format from background thread
+            sys_seconds timestamp{ seconds{ column.integers[row] } };
+            auto day = floor<days>(timestamp);
+            year_month_day date{ day };
+            hh_mm_ss time{ timestamp - day };
+            std::tm tm{};
+            tm.tm_year = (int)date.year() - 1900;
+            tm.tm_mon = (int)(unsigned)date.month() - 1;
+            tm.tm_mday = (int)(unsigned)date.day();
+            tm.tm_hour = (int)time.hours().count();
+            tm.tm_min = (int)time.minutes().count();
+            tm.tm_sec = (int)time.seconds().count();
+            tm.tm_wday = (int)weekday{ day }.c_encoding();
+            tm.tm_yday = (int)(day - sys_days{ date.year() / January / 1 }).count();
+            length = (int)std::strftime(buffer, size, !format.empty() ? format.c_str() : "%Y-%m-%d %H:%M:%S", &tm);
+            break;
+        }
+        default: break;
+        }
+
+        return std::string_view{ buffer, (size_t)std::clamp(length, 0, size - 1) };
+    }
+
+    static ItemGridSortKey GetSortKey(const ItemGridConfig& config, int32_t row, int16_t col)
+    {
+        if (config.sortkey != nullptr) return config.sortkey(row, col);
+
+        const auto& column = config.source.columns[col];
+        switch (column.type)
+        {
+        case ItemGridColumnType::Text: return ItemGridSortKey{ column.texts[row] };
+        case ItemGridColumnType::Real: return ItemGridSortKey{ column.reals[row] };
+        default: return ItemGridSortKey{ column.integers[row] };
+        }
+    }
+
+    static std::pair<std::string_view, TextType> GetSourceCellContent(ItemGridPersistentState& state, 
+        const ItemGridConfig& config, int32_t row, int16_t col)
+    {
+        const auto& column = config.source.columns[col];
+        if (column.type == ItemGridColumnType::Text) return { column.texts[row], column.textType };
+
+        auto ncols = (int32_t)config.source.columns.size();
+        if (!state.formattedCells.fits(GLIMMER_ITEMGRID_FORMAT_CACHE_ROWS, ncols))
+            state.formattedCells.reset(GLIMMER_ITEMGRID_FORMAT_CACHE_ROWS, ncols);
+
+        auto text = state.formattedCells.get(row, col, config.source.version, WidgetContextData::CurrentFrame,
+            [&](char* buffer, int32_t size) {
+                return FormatColumnValue(column, state.formats[col], row, buffer, size).size();
+            });
+        return { text, column.textType };
+    }
+
+    // Format number/timestamp cells of visible rows [from, to] a column at a time, ahead of population
+    static void FormatSourceCells(ItemGridPersistentState& state, const ItemGridConfig& config, 
+        const int32_t* order, int32_t from, int32_t to)
+    {
+        for (int16_t col = 0; col < (int16_t)config.source.columns.size(); ++col)
+            if (config.source.columns[col].type != ItemGridColumnType::Text)
+                for (auto row = from; row <= to; ++row)
+                    GetSourceCellContent(state, config, order != nullptr ? order[row] : row, col);
+    }
+
+    // Copy of data source columns for some data rows, read by background jobs in place of
+    // application's memory, which may change while they run. Values are indexed by position
+    // in the copied rows.
+    struct ItemGridSourceSnapshot
+    {
+        struct Column
+        {
+            ItemGridColumnData data; // Views of the values below
+            std::string format;
+            std::vector<int64_t> integers;
+            std::vector<double> reals;
+            std::vector<std::string_view> texts;
+            std::string chars;
+        };
+
+        std::vector<Column> columns; // Columns left out have no values
+    };
+
+    // Copy columns cols for data rows, or data rows [0, count) if rows is empty
+    static void CaptureSourceColumns(ItemGridSourceSnapshot& snapshot, const ItemGridPersistentState& state,
+        const ItemGridConfig& config, std::span<const int32_t> rows, int32_t count, std::span<const int16_t> cols)
+    {
+        snapshot.columns.resize(config.source.columns.size());
+        if (!rows.empty()) count = (int32_t)rows.size();
+
+        for (auto col : cols)
+        {
+            if (col >= (int16_t)snapshot.columns.size()) continue;
+
+            const auto& source = config.source.columns[col];
+            auto& column = snapshot.columns[col];
+            column.format = state.formats[col];
+            column.data.type = source.type;
+            column.data.textType = source.textType;
+
+            switch (source.type)
+            {
+            case ItemGridColumnType::Text:
+            {
+                // Views are made once all characters are copied, as chars may be reallocated
+                size_t total = 0;
+                for (auto pos = 0; pos < count; ++pos)
+                    total += source.texts[rows.empty() ? pos : rows[pos]].size();
+                column.chars.clear();
+                column.chars.reserve(total);
+                for (auto pos = 0; pos < count; ++pos)
+                    column.chars.append(source.texts[rows.empty() ? pos : rows[pos]]);
+
+                column.texts.resize(count);
+                size_t offset = 0;
+                for (auto pos = 0; pos < count; ++pos)
+                {
+                    auto length = source.texts[rows.empty() ? pos : rows[pos]].size();
+                    column.texts[pos] = std::string_view{ column.chars.data() + offset, length };
+                    offset += length;
+                }
+                column.data.texts = column.texts;
+                break;
+            }
+            case ItemGridColumnType::Real:
+                column.reals.resize(count);
+                for (auto pos = 0; pos < count; ++pos) column.reals[pos] = source.reals[rows.empty() ? pos : rows[pos]];
+                column.data.reals = column.reals;
+                break;
+            default:
+                column.integers.resize(count);
+                for (auto pos = 0; pos < count; ++pos) column.integers[pos] = source.integers[rows.empty() ? pos : rows[pos]];
+                column.data.integers = column.integers;
+                break;
+            }
+        }
+    }
+
+#pragma endregion
+
+#pragma region ItemGrid sorting
+
+    struct ItemGridSortContext
+    {
+        const ItemGridSortKey* keys = nullptr; // keys[datarow * ncols + spec]
+        const ItemGridPersistentState::SortState::Column* columns = nullptr;
+        int32_t* src = nullptr;
+        int32_t* dst = nullptr;
+        int32_t count = 0;
+        int32_t chunksz = 0;
+        int16_t ncols = 0;
+    };
+
+    static int CompareSortKeys(const ItemGridSortKey& lhs, const ItemGridSortKey& rhs)
+    {
+        if (lhs.isText && rhs.isText) return lhs.text.compare(rhs.text);
+        if (lhs.isText != rhs.isText) return lhs.isText ? 1 : -1; // Numbers before text
+
+        // NaN is ordered after all other numbers, else ordering is not a strict weak ordering
+        auto lnan = std::isnan(lhs.number), rnan = std::isnan(rhs.number);
+        if (lnan || rnan) return lnan == rnan ? 0 : lnan ? 1 : -1;
+        return lhs.number < rhs.number ? -1 : lhs.number > rhs.number ? 1 : 0;
+    }
+
+    struct ItemGridRowComparator
+    {
+        const ItemGridSortContext* ctx = nullptr;
+
+        bool operator()(int32_t lhs, int32_t rhs) const
+        {
+            const auto* lkeys = ctx->keys + ((int64_t)lhs * ctx->ncols);
+            const auto* rkeys = ctx->keys + ((int64_t)rhs * ctx->ncols);
+
+            for (auto idx = 0; idx < ctx->ncols; ++idx)
+            {
+                auto result = CompareSortKeys(lkeys[idx], rkeys[idx]);
+                if (result != 0) return ctx->columns[idx].ascending ? result < 0 : result > 0;
+            }
+
+            return false;
+        }
+    };
+
+    static void SortItemGridChunk(int32_t index, void* data)
+    {
+        auto& ctx = *(ItemGridSortContext*)data;
+        auto from = std::min(index * ctx.chunksz, ctx.count), to = std::min(from + ctx.chunksz, ctx.count);
+        std::stable_sort(ctx.src + from, ctx.src + to, ItemGridRowComparator{ &ctx });
+    }
+
+    static void MergeItemGridChunks(int32_t index, void* data)
+    {
+        auto& ctx = *(ItemGridSortContext*)data;
+        auto from = index * 2 * ctx.chunksz;
+        auto mid = std::min(from + ctx.chunksz, ctx.count), to = std::min(from + 2 * ctx.chunksz, ctx.count);
+        std::merge(ctx.src + from, ctx.src + mid, ctx.src + mid, ctx.src + to, ctx.dst + from,
+            ItemGridRowComparator{ &ctx });
+    }
+
+    // Stable sort of `count` row indexes, sorted chunks are merged pairwise, both phases
+    // are spread over worker threads for large grids. Result is in ctx.src
+    static void SortItemGridRows(ItemGridSortContext& ctx, int32_t* rows, int32_t* scratch, int32_t count)
+    {
+        ctx.src = rows; ctx.dst = scratch;
+        auto parallel = count >= GLIMMER_PARALLEL_SORT_THRESHOLD;
+        auto chunks = parallel ? GLIMMER_MAX_WORKER_THREADS * 2 : 1;
+        ctx.count = count;
+        ctx.chunksz = (count + chunks - 1) / chunks;
+        ParallelFor(chunks, &SortItemGridChunk, &ctx);
+
+        for (; ctx.chunksz < count; ctx.chunksz *= 2)
+        {
+            auto pairs = (count + (2 * ctx.chunksz) - 1) / (2 * ctx.chunksz);
+            ParallelFor(pairs, &MergeItemGridChunks, &ctx);
+            std::swap(ctx.src, ctx.dst);
+        }
+
+        if (ctx.src != rows) std::memcpy(rows, ctx.src, sizeof(int32_t) * count);
+    }
+
+    static void UpdateSortColumns(ItemGridPersistentState::SortState& sorting, int16_t col, bool ascending, bool append)
+    {
+        if (append)
+        {
+            for (auto& column : sorting.columns)
+                if (column.col == col)
+                {
+                    column.ascending = !column.ascending;
+                    sorting.dirty = true;
+                    return;
+                }
+        }
+        else sorting.columns.clear(true);
+
+        sorting.columns.emplace_back(col, ascending);
+        sorting.dirty = true;
+    }
+
+    // Grow to at least `count` elements, geometrically so that appending rows is amortized O(1)
+    template <typename T>
+    static void GrowToSize(Vector<T, int32_t>& vec, int32_t count)
+    {
+        if (vec.size() < count) vec.resize(std::max(count, vec.size() * 2), false);
+    }
+
+    static float EstimatedRowPitch(const ItemGridConfig& config);
+
+    // Data rows from `from` onwards were inserted among the displayed rows, which kept their 
+    // relative order. Measured pitches move along with their rows instead of being discarded.
+    static void InsertRowPitches(ItemGridPersistentState& state, const ItemGridConfig& config, 
+        const int32_t* rows, int32_t count, int32_t from)
+    {
+        auto& extents = state.rowExtents;
+        if (config.uniformRowHeights || extents.capacity > 0) return;
+
+        auto existing = 0;
+        for (auto idx = 0; idx < count; ++idx)
+            if (rows[idx] < from) ++existing;
+
+        if (existing != extents.pitches.size() || count < existing) extents.pitches.resize(0, 0.f);
+        else
+        {
+            auto estimate = extents.estimate > 0.f ? extents.estimate : EstimatedRowPitch(config);
+            extents.pitches.spread(count, estimate, [rows, from](int32_t idx) { return rows[idx] < from; });
+        }
+    }
+
+    // Keys of rows [from, to), row-major so that a row's keys are adjacent for comparisons.
+    // Text keys of sort key provider are only valid during the call, hence they are copied.
+    static void ExtractSortKeys(ItemGridPersistentState::SortState& sorting, const ItemGridConfig& config,
+        int32_t from, int32_t to)
+    {
+        auto ncols = (int32_t)sorting.columns.size();
+        GrowToSize(sorting.keys, to * ncols);
+
+        for (auto row = from; row < to; ++row)
+            for (auto idx = 0; idx < ncols; ++idx)
+            {
+                auto key = GetSortKey(config, row, sorting.columns[idx].col);
+                if (key.isText && config.sortkey != nullptr) key.text = sorting.texts.store(key.text).first;
+                sorting.keys[(row * ncols) + idx] = key;
+            }
+    }
+
+    // Keep the visual to data row order up to date with sort columns and row count. Keys of
+    // appended rows are extracted, sorted separately and merged into the existing order, any
+    // other change re-sorts all rows. Keys and buffers are kept across frames.
+    static void UpdateItemGridSort(ItemGridBuilder& builder, ItemGridPersistentState& state, const ItemGridConfig& config,
+        int32_t totalRows)
+    {
+        auto& sorting = state.sorting;
+        if (sorting.columns.empty() && state.sortedCol != -1)
+            sorting.columns.emplace_back(state.sortedCol, state.sortedAscending);
+        if (sorting.columns.empty() || totalRows <= 0) return;
+
+        if (sorting.dirty || totalRows < sorting.sortedRows || sorting.order.size() < sorting.sortedRows)
+        {
+            sorting.sortedRows = 0;
+            sorting.texts.clear();
+        }
+
+        if (totalRows != sorting.sortedRows)
+        {
+            auto from = sorting.sortedRows;
+            ExtractSortKeys(sorting, config, from, totalRows);
+            GrowToSize(sorting.order, totalRows);
+            GrowToSize(sorting.scratch, totalRows);
+            for (auto row = from; row < totalRows; ++row) sorting.order[row] = row;
+
+            ItemGridSortContext ctx;
+            ctx.keys = sorting.keys.data(); ctx.columns = sorting.columns.data(); 
+            ctx.ncols = sorting.columns.size();
+            ItemGridRowComparator compare{ &ctx };
+            SortItemGridRows(ctx, sorting.order.data() + from, sorting.scratch.data(), totalRows - from);
+
+            if (from == 0)
+            {
+                // Measured heights belong to visual rows, which have moved
+                if (!config.uniformRowHeights) state.rowExtents.pitches.resize(0, 0.f);
+                state.filtering.reorder = true;
+            }
+            else if (compare(sorting.order[from], sorting.order[from - 1]))
+            {
+                // Appended rows interleave with existing ones, else they already follow them
+                auto* order = sorting.order.data();
+                std::merge(order, order + from, order + from, order + totalRows, sorting.scratch.data(), compare);
+                std::memcpy(order, sorting.scratch.data(), sizeof(int32_t) * totalRows);
+
+                // Filtered rows are displayed in this order once the filter includes appended rows
+                if (!state.filtering.active) InsertRowPitches(state, config, order, totalRows, from);
+            }
+
+            sorting.sortedRows = totalRows;
+            sorting.dirty = false;
+        }
+
+        builder.rowOrder = sorting.order.data();
+    }
+
+#pragma endregion
+
+#pragma region ItemGrid filtering
+
+    enum ItemGridFilterJobStatus : int32_t
+    {
+        FJ_Running, FJ_Done, FJ_Abandoned, FJ_Discarded
+    };
+
+    // Self-contained filtering work, shared between the UI thread and the background thread.
+    // Whichever side sees the other one finish (or abandon the job) last deletes it.
+    struct ItemGridFilterJob
+    {
+        std::vector<std::string> filters; // Lower-cased filter per column
+        std::vector<int32_t> source; // Data rows to filter
+        std::vector<int32_t> result; // Matching data rows, in order of source
+        ItemGridConfig::FilterTextProviderT provider = nullptr;
+        ItemGridSourceSnapshot data; // Filtered columns of source rows, if there is no provider
+        int32_t totalRows = 0;
+        int32_t appendedFrom = -1; // First appended data row, if only appended rows are filtered
+        bool narrowing = false; // Source is the published rows
+        std::atomic_int32_t status = FJ_Running;
+    };
+
+    static std::string ToLowerCase(std::string_view text)
+    {
+        std::string result{ text };
+        for (auto& ch : result) ch = (char)std::tolower((unsigned char)ch);
+        return result;
+    }
+
+    static bool EqualsIgnoreCase(std::string_view text, std::string_view lowered)
+    {
+        if (text.size() != lowered.size()) return false;
+        for (size_t idx = 0; idx < text.size(); ++idx)
+            if (std::tolower((unsigned char)text[idx]) != lowered[idx]) return false;
+        return true;
+    }
+
+    static bool ContainsIgnoreCase(std::string_view text, std::string_view lowered)
+    {
+        if (lowered.empty()) return true;
+
+        for (size_t start = 0; start + lowered.size() <= text.size(); ++start)
+        {
+            size_t idx = 0;
+            while (idx < lowered.size() && std::tolower((unsigned char)text[start + idx]) == lowered[idx]) ++idx;
+            if (idx == lowered.size()) return true;
+        }
+
+        return false;
+    }
+
+    static void RunItemGridFilter(void* data)
+    {
+        auto& job = *(ItemGridFilterJob*)data;
+        char buffer[GLIMMER_ITEMGRID_FORMATTED_CELL_SZ];
+        job.result.reserve(job.source.size());
+
+        for (size_t idx = 0; idx < job.source.size(); ++idx)
+        {
+            if ((idx & 1023) == 0 && job.status.load(std::memory_order_relaxed) == FJ_Abandoned)
+                break;
+
+            auto row = job.source[idx];
+            auto matched = true;
+
+            for (int16_t col = 0; col < (int16_t)job.filters.size() && matched; ++col)
+                if (!job.filters[col].empty())
+                {
+                    const auto* column = col < (int16_t)job.data.columns.size() ? &job.data.columns[col] : nullptr;
+                    auto text = job.provider != nullptr ? job.provider(row, col) : column != nullptr ?
+                        FormatColumnValue(column->data, column->format, (int32_t)idx, buffer, GLIMMER_ITEMGRID_FORMATTED_CELL_SZ) : 
+                        std::string_view{};
+                    matched = ContainsIgnoreCase(text, job.filters[col]);
+                }
+
+            if (matched) job.result.push_back(row);
+        }
+
+        if (job.status.exchange(FJ_Done) == FJ_Abandoned) delete &job;
+    }
+
+    // Job was not run as background tasks were stopped, grid filters again if it is still alive
+    static void DiscardItemGridFilter(void* data)
+    {
+        auto& job = *(ItemGridFilterJob*)data;
+        if (job.status.exchange(FJ_Discarded) == FJ_Abandoned) delete &job;
+    }
+
+    static void AbandonItemGridFilter(ItemGridPersistentState::FilterState& filtering)
+    {
+        if (filtering.job != nullptr && filtering.job->status.exchange(FJ_Abandoned) != FJ_Running)
+            delete filtering.job;
+        filtering.job = nullptr;
+    }
+
+    // Destroying grid state (widget released, nested context recycled, cleanup) abandons the
+    // filtering in progress, which the background thread then deletes
+    ItemGridPersistentState::FilterState::~FilterState()
+    {
+        AbandonItemGridFilter(*this);
+    }
+
+    // Rows which match the filter, in display order. Appended data rows not filtered yet are left out.
+    static void CollectFilteredRows(const ItemGridBuilder& builder, ItemGridPersistentState::FilterState& filtering,
+        int32_t totalRows)
+    {
+        filtering.rows.clear();
+        for (auto pos = 0; pos < totalRows; ++pos)
+        {
+            auto row = builder.rowOrder != nullptr ? builder.rowOrder[pos] : pos;
+            if (row < filtering.totalRows && filtering.matched[row]) filtering.rows.push_back(row);
+        }
+    }
+
+    static void PublishItemGridFilter(const ItemGridBuilder& builder, ItemGridPersistentState& state, 
+        const ItemGridConfig& config, ItemGridFilterJob& job, int32_t totalRows)
+    {
+        auto& filtering = state.filtering;
+        auto& matched = filtering.matched;
+        auto wasActive = filtering.active;
+
+        if (job.appendedFrom >= 0) matched.resize(job.totalRows, 0);
+        else
+        {
+            if (job.narrowing) for (auto row : filtering.rows) matched[row] = 0;
+            else matched.assign(job.totalRows, 0);
+            filtering.applied.swap(job.filters);
+        }
+
+        for (auto row : job.result) matched[row] = 1;
+        filtering.totalRows = job.totalRows;
+        filtering.reorder = false;
+        filtering.active = false;
+        for (const auto& filter : filtering.applied)
+            filtering.active = filtering.active || !filter.empty();
+        if (filtering.active || wasActive)
+        {
+            auto& refiltered = state.aggregation.refiltered;
+            auto from = std::max(job.appendedFrom, 0);
+            refiltered = refiltered == -1 ? from : std::min(refiltered, from);
+        }
+
+        if (job.appendedFrom >= 0 && builder.rowOrder == nullptr)
+            filtering.rows.insert(filtering.rows.end(), job.result.begin(), job.result.end());
+        else CollectFilteredRows(builder, filtering, totalRows);
+
+        // Measured heights belong to visual rows, appended rows are inserted among them, 
+        // any other change replaces the visual rows
+        if (job.appendedFrom < 0)
+        {
+            if (!config.uniformRowHeights) state.rowExtents.pitches.resize(0, 0.f);
+        }
+        else if (builder.rowOrder != nullptr)
+            InsertRowPitches(state, config, filtering.rows.data(), (int32_t)filtering.rows.size(), job.appendedFrom);
+    }
+
+    static void StartItemGridFilter(const ItemGridBuilder& builder, ItemGridPersistentState& state, 
+        const ItemGridConfig& config, ItemGridFilterJob* job, int32_t totalRows)
+    {
+        auto& filtering = state.filtering;
+        job->provider = config.filtertext;
+
+        if (job->provider == nullptr && HasDataSource(config))
+        {
+            std::vector<int16_t> cols;
+            for (int16_t col = 0; col < (int16_t)job->filters.size(); ++col)
+                if (!job->filters[col].empty()) cols.push_back(col);
+            CaptureSourceColumns(job->data, state, config, job->source, 0, cols);
+        }
+
+        if (job->source.size() < GLIMMER_BACKGROUND_FILTER_THRESHOLD)
+        {
+            RunItemGridFilter(job);
+            PublishItemGridFilter(builder, state, config, *job, totalRows);
+            delete job;
+        }
+        else
+        {
+            filtering.job = job;
+            RunInBackground(&RunItemGridFilter, job, &DiscardItemGridFilter);
+        }
+    }
+
+    // Keep the visible row index up to date with the filter row. When every column's filter text
+    // contains the applied one, only the current matches are rescanned, appended rows are filtered
+    // on their own, otherwise all rows are rescanned. Large scans run in background while the last 
+    // published result stays visible, rows appended meanwhile are filtered once it is published.
+    static int32_t UpdateItemGridFilter(WidgetContextData& context, ItemGridBuilder& builder, ItemGridPersistentState& state, 
+        const ItemGridConfig& config, int32_t totalRows)
+    {
+        static Vector<std::string_view, int16_t, 32> current{ false };
+        auto& filtering = state.filtering;
+        const auto& headers = builder.headers[builder.levels - 1];
+        current.clear(false);
+
+        for (int16_t col = 0; col < headers.size(); ++col)
+        {
+            std::string_view filter;
+            if (headers[col].genid != -1)
+                filter = context.GetState(headers[col].genid).state.input.text.view();
+            current.emplace_back(filter);
+        }
+
+        if (filtering.job != nullptr && filtering.job->status.load() != FJ_Running)
+        {
+            if (filtering.job->status.load() == FJ_Done)
+                PublishItemGridFilter(builder, state, config, *filtering.job, totalRows);
+            else filtering.dirty = true;
+
+            delete filtering.job;
+            filtering.job = nullptr;
+        }
+
+        // Only filter texts are compared, rows being appended do not restart a pending job
+        const auto& target = filtering.job != nullptr ? filtering.job->filters : filtering.applied;
+        auto targetRows = filtering.job != nullptr ? filtering.job->totalRows : filtering.totalRows;
+        auto changed = filtering.dirty || (totalRows < targetRows) || (target.size() != (size_t)current.size());
+        auto narrowing = !changed && filtering.active && totalRows == filtering.totalRows;
+        auto nonempty = false;
+
+        for (int16_t col = 0; col < current.size(); ++col)
+        {
+            nonempty = nonempty || !current[col].empty();
+            if (!changed && !EqualsIgnoreCase(current[col], target[col])) changed = true;
+            if (narrowing && (col >= (int16_t)filtering.applied.size() || 
+                !ContainsIgnoreCase(current[col], filtering.applied[col])))
+                narrowing = false;
+        }
+
+        if (changed)
+        {
+            auto job = new ItemGridFilterJob{};
+            job->totalRows = totalRows;
+            job->narrowing = narrowing;
+            for (int16_t col = 0; col < current.size(); ++col)
+                job->filters.emplace_back(ToLowerCase(current[col]));
+
+            if (narrowing) job->source = filtering.rows;
+            else if (nonempty)
+            {
+                job->source.resize(totalRows);
+                for (auto row = 0; row < totalRows; ++row) job->source[row] = row;
+            }
+
+            AbandonItemGridFilter(filtering);
+            filtering.dirty = false;
+            StartItemGridFilter(builder, state, config, job, totalRows);
+        }
+        else if (filtering.job == nullptr && totalRows > filtering.totalRows)
+        {
+            if (filtering.active)
+            {
+                auto job = new ItemGridFilterJob{};
+                job->totalRows = totalRows;
+                job->appendedFrom = filtering.totalRows;
+                job->filters = filtering.applied;
+                job->source.resize(totalRows - filtering.totalRows);
+                for (auto row = filtering.totalRows; row < totalRows; ++row)
+                    job->source[row - filtering.totalRows] = row;
+                StartItemGridFilter(builder, state, config, job, totalRows);
+            }
+            else filtering.totalRows = totalRows;
+        }
+        else if (filtering.reorder && filtering.job == nullptr)
+        {
+            // Display order has changed, matches are the same
+            filtering.reorder = false;
+            if (filtering.active) CollectFilteredRows(builder, filtering, totalRows);
+            if (!config.uniformRowHeights) state.rowExtents.pitches.resize(0, 0.f);
+        }
+
+        if (!filtering.active) return totalRows;
+        builder.rowOrder = filtering.rows.data();
+        return (int32_t)filtering.rows.size();
+    }
+
+#pragma endregion
+
+#pragma region ItemGrid aggregates
+
+    using ItemGridAggregateState = ItemGridPersistentState::AggregateState;
+
+    struct ItemGridAggregateContext
+    {
+        const ItemGridConfig* config = nullptr;
+        ItemGridAggregateState* aggregation = nullptr;
+        int32_t count = 0;
+        int32_t chunksz = 0;
+    };
+
+    static double GetAggregateIdentity(ItemGridAggregate type)
+    {
+        return type == ItemGridAggregate::Min ? std::numeric_limits<double>::infinity() :
+            type == ItemGridAggregate::Max ? -std::numeric_limits<double>::infinity() : 0.0;
+    }
+
+    static double CombineAggregates(ItemGridAggregate type, double lhs, double rhs)
+    {
+        return type == ItemGridAggregate::Min ? std::min(lhs, rhs) : type == ItemGridAggregate::Max ?
+            std::max(lhs, rhs) : lhs + rhs;
+    }
+
+    static double GetAggregateValue(const ItemGridConfig& config, int32_t row, int16_t col)
+    {
+        if (config.aggregates.value != nullptr) return config.aggregates.value(row, col);
+        if (col >= (int16_t)config.source.columns.size()) return 0.0;
+
+        const auto& column = config.source.columns[col];
+        switch (column.type)
+        {
+        case ItemGridColumnType::Real: return column.reals[row];
+        case ItemGridColumnType::Text: return 0.0;
+        default: return (double)column.integers[row];
+        }
+    }
+
+    static bool IsAggregateRowShown(const ItemGridAggregateState& aggregation, int32_t row)
+    {
+        return aggregation.shown.empty() || aggregation.shown[row] != 0;
+    }
+
+    // Rows not covered by filter yet are not displayed
+    static bool IsAggregateRowFiltered(const ItemGridPersistentState::FilterState& filtering, int32_t row)
+    {
+        return !filtering.active || (row < filtering.totalRows && filtering.matched[row] != 0);
+    }
+
+    // Update leaf of a row in segment tree of column and its ancestors, O(log n)
+    static void SetAggregateLeaf(ItemGridAggregateState& aggregation, int16_t col, int32_t row, double value)
+    {
+        auto& column = aggregation.columns[col];
+        auto pos = aggregation.leaves + row;
+        column.tree[pos] = value;
+
+        for (pos >>= 1; pos > 0; pos >>= 1)
+            column.tree[pos] = CombineAggregates(column.type, column.tree[2 * pos], column.tree[(2 * pos) + 1]);
+    }
+
+    // Fold a row's values into the aggregates, or replace them by identity once it is not shown
+    static void SetAggregateRow(ItemGridAggregateState& aggregation, const ItemGridConfig& config, int32_t row, bool shown)
+    {
+        for (int16_t col = 0; col < (int16_t)aggregation.columns.size(); ++col)
+            if (!aggregation.columns[col].tree.empty())
+                SetAggregateLeaf(aggregation, col, row, shown ? GetAggregateValue(config, row, col) :
+                    GetAggregateIdentity(aggregation.columns[col].type));
+    }
+
+    static void FillAggregateLeaves(int32_t index, void* data)
+    {
+        auto& ctx = *(ItemGridAggregateContext*)data;
+        auto& aggregation = *ctx.aggregation;
+        auto from = std::min(index * ctx.chunksz, ctx.count), to = std::min(from + ctx.chunksz, ctx.count);
+
+        for (int16_t col = 0; col < (int16_t)aggregation.columns.size(); ++col)
+        {
+            auto& column = aggregation.columns[col];
+            if (column.tree.empty()) continue;
+
+            auto identity = GetAggregateIdentity(column.type);
+            for (auto row = from; row < to; ++row)
+                column.tree[aggregation.leaves + row] = IsAggregateRowShown(aggregation, row) ? 
+                    GetAggregateValue(*ctx.config, row, col) : identity;
+        }
+    }
+
+    // Rebuild segment trees of all columns over shown rows, leaves are filled in parallel
+    static void RebuildItemGridAggregates(ItemGridPersistentState& state, const ItemGridConfig& config, int32_t totalRows)
+    {
+        auto& aggregation = state.aggregation;
+        const auto& types = config.aggregates.columns;
+        aggregation.leaves = 1;
+        while (aggregation.leaves < totalRows) aggregation.leaves <<= 1;
+
+        aggregation.shown.clear();
+        aggregation.count = totalRows;
+        if (state.filtering.active)
+        {
+            aggregation.shown.resize(totalRows, 0);
+            aggregation.count = 0;
+            for (auto row = 0; row < totalRows; ++row)
+                if (IsAggregateRowFiltered(state.filtering, row))
+                {
+                    aggregation.shown[row] = 1;
+                    aggregation.count++;
+                }
+        }
+
+        aggregation.columns.resize(types.size());
+        for (auto col = 0; col < (int32_t)types.size(); ++col)
+        {
+            auto& column = aggregation.columns[col];
+            column.type = types[col];
+            column.tree.clear();
+            if (types[col] != ItemGridAggregate::None && types[col] != ItemGridAggregate::Count)
+                column.tree.resize(2 * aggregation.leaves, GetAggregateIdentity(types[col]));
+        }
+
+        ItemGridAggregateContext ctx;
+        ctx.config = &config; ctx.aggregation = &aggregation; ctx.count = totalRows;
+        auto chunks = totalRows >= GLIMMER_PARALLEL_AGGREGATE_THRESHOLD ? GLIMMER_MAX_WORKER_THREADS : 1;
+        ctx.chunksz = (totalRows + chunks - 1) / chunks;
+        ParallelFor(chunks, &FillAggregateLeaves, &ctx);
+
+        for (auto& column : aggregation.columns)
+            if (!column.tree.empty())
+                for (auto pos = aggregation.leaves - 1; pos > 0; --pos)
+                    column.tree[pos] = CombineAggregates(column.type, column.tree[2 * pos], column.tree[(2 * pos) + 1]);
+
+        aggregation.rows = totalRows;
+        aggregation.updated.clear();
+        aggregation.refiltered = -1;
+        aggregation.dirty = false;
+    }
+
+    // Double the leaves until rows fit, aggregated leaves are moved and inner nodes recombined
+    // without reading values again
+    static void GrowAggregateTrees(ItemGridAggregateState& aggregation, int32_t totalRows)
+    {
+        auto leaves = aggregation.leaves;
+        while (leaves < totalRows) leaves <<= 1;
+
+        for (auto& column : aggregation.columns)
+        {
+            if (column.tree.empty()) continue;
+
+            std::vector<double> tree(2 * leaves, GetAggregateIdentity(column.type));
+            std::copy(column.tree.begin() + aggregation.leaves, column.tree.begin() + aggregation.leaves + aggregation.rows,
+                tree.begin() + leaves);
+            for (auto pos = leaves - 1; pos > 0; --pos)
+                tree[pos] = CombineAggregates(column.type, tree[2 * pos], tree[(2 * pos) + 1]);
+            column.tree.swap(tree);
+        }
+
+        aggregation.leaves = leaves;
+    }
+
+    // Fold rows which were appended, updated, removed, or have entered/left the filtered rows into
+    // the aggregates, a leaf at a time. Changes to aggregate types, explicit invalidation, or too
+    // many rows changing their filter match rebuild them instead.
+    static void UpdateItemGridAggregates(ItemGridPersistentState& state, const ItemGridConfig& config, int32_t totalRows)
+    {
+        auto& aggregation = state.aggregation;
+        const auto& filtering = state.filtering;
+        const auto& types = config.aggregates.columns;
+        auto changed = aggregation.dirty || aggregation.columns.size() != types.size();
+        for (auto col = 0; col < (int32_t)types.size() && !changed; ++col)
+            changed = aggregation.columns[col].type != types[col];
+
+        // Each changed row costs O(log n) per column, against O(1) for each row when rebuilt
+        if (!changed && aggregation.refiltered >= 0)
+        {
+            auto refiltered = 0;
+            for (auto row = aggregation.refiltered; row < std::min(aggregation.rows, totalRows); ++row)
+                if (IsAggregateRowFiltered(filtering, row) != IsAggregateRowShown(aggregation, row)) ++refiltered;
+            changed = (int64_t)refiltered * std::bit_width((uint32_t)aggregation.leaves) > (int64_t)totalRows;
+        }
+
+        if (changed) RebuildItemGridAggregates(state, config, totalRows);
+        else
+        {
+            if (totalRows > aggregation.leaves) GrowAggregateTrees(aggregation, totalRows);
+
+            // Removed rows hold the identity, leaves are not shrunk
+            for (auto row = totalRows; row < aggregation.rows; ++row)
+                if (IsAggregateRowShown(aggregation, row))
+                {
+                    SetAggregateRow(aggregation, config, row, false);
+                    aggregation.count--;
+                }
+
+            aggregation.rows = std::min(aggregation.rows, totalRows);
+            if (!aggregation.shown.empty()) aggregation.shown.resize(aggregation.rows);
+            else if (filtering.active) aggregation.shown.assign(aggregation.rows, 1);
+
+            if (aggregation.refiltered >= 0)
+            {
+                for (auto row = aggregation.refiltered; row < aggregation.rows; ++row)
+                {
+                    auto shown = IsAggregateRowFiltered(filtering, row);
+                    if (shown == IsAggregateRowShown(aggregation, row)) continue;
+
+                    aggregation.shown[row] = shown ? 1 : 0;
+                    aggregation.count += shown ? 1 : -1;
+                    SetAggregateRow(aggregation, config, row, shown);
+                }
+
+                if (!filtering.active) aggregation.shown.clear();
+            }
+
+            for (auto row = aggregation.rows; row < totalRows; ++row)
+            {
+                auto shown = IsAggregateRowFiltered(filtering, row);
+                if (!aggregation.shown.empty()) aggregation.shown.push_back(shown ? 1 : 0);
+                if (shown)
+                {
+                    SetAggregateRow(aggregation, config, row, true);
+                    aggregation.count++;
+                }
+            }
+
+            aggregation.rows = totalRows;
+            aggregation.refiltered = -1;
+
+            for (auto row : aggregation.updated)
+                if (row < totalRows && IsAggregateRowShown(aggregation, row))
+                    SetAggregateRow(aggregation, config, row, true);
+            aggregation.updated.clear();
+        }
+
+        aggregation.texts.resize(types.size());
+        for (auto col = 0; col < (int32_t)types.size(); ++col)
+        {
+            const auto& column = aggregation.columns[col];
+            auto value = column.type == ItemGridAggregate::Count ? (double)aggregation.count :
+                column.tree.empty() ? 0.0 : column.tree[1];
+            if (column.type == ItemGridAggregate::Average) value = aggregation.count > 0 ? value / (double)aggregation.count : 0.0;
+
+            auto& text = aggregation.texts[col];
+            text.resize(32);
+            auto length = column.type == ItemGridAggregate::None || std::isinf(value) ? 0 :
+                std::snprintf(text.data(), text.size(), aggregation.format.c_str(), value);
+            text.resize((size_t)std::clamp(length, 0, (int)text.size() - 1));
+        }
+    }
+
+    static std::pair<std::string_view, TextType> GetAggregateCellContent(const ItemGridPersistentState& state, int16_t col)
+    {
+        return { col < (int16_t)state.aggregation.texts.size() ? std::string_view{ state.aggregation.texts[col] } :
+            std::string_view{}, TextType::PlainText };
+    }
+
+#pragma endregion
+
+#pragma region ItemGrid export
 
-            movingcol = siblingCount == 1 ? parent : movingcol;
-            level = siblingCount == 1 ? level - 1 : level;
+    enum ItemGridExportJobStatus : int32_t
+    {
+        EJ_Writing, EJ_Waiting, EJ_Finished, EJ_Abandoned
+    };
 
-            auto lcol = col;
-            auto& mcol = headers[level][lcol];
-            gridstate.drag.config = mcol;
-            gridstate.drag.mouseDown = true;
-            gridstate.drag.lastPos = mousepos;
-            gridstate.drag.startPos = mousepos;
-            gridstate.drag.potentialColumn = movingcol;
-            gridstate.drag.level = level;
-            gridstate.state = ItemGridCurrentState::ReorderingColumns;
-            LOGERROR("\nMarking column (v: %d, l: %d) as moving (%f -> %f)\n", vcol, lcol, mcol.content.Min.x, mcol.content.Max.x);
+    // Snapshot of grid's view and remaining rows to write, processed a batch at a time
+    // on the background thread. Without a text provider, the UI thread copies values of
+    // each batch while the grid is populated (EJ_Waiting), and deletes finished jobs.
+    // A job abandoned while writing is deleted by the background thread.
+    struct ItemGridExportJob
+    {
+        ItemGridExportOptions options;
+        ItemGridConfig::FilterTextProviderT text = nullptr;
+        ItemGridSourceSnapshot source; // Exported columns of rows [first, first + batch), if there is no text provider
+        std::vector<std::string> names;
+        std::vector<int16_t> columns; // Logical columns in visual order
+        std::vector<int32_t> rows; // Data rows in display order, empty if all rows are in data order
+        std::vector<int32_t> batch; // Data rows of current batch
+        std::string buffer;
+        int64_t total = 0;
+        int64_t next = 0;
+        int64_t first = 0; // Position of the first row of current batch
+        int32_t grid = -1;
+        std::atomic_int32_t status = EJ_Writing;
+    };
+
+    static bool WriteToDescriptor(int fd, const char* data, size_t size)
+    {
+        while (size > 0)
+        {
+#ifdef _WIN32
+            auto written = _write(fd, data, (unsigned int)std::min<size_t>(size, INT32_MAX));
+#else
+            auto written = ::write(fd, data, size);
+            if (written < 0 && errno == EINTR) continue;
+#endif
+            if (written <= 0) return false;
+            data += written;
+            size -= (size_t)written;
         }
-        else if (isMouseDown && gridstate.drag.mouseDown && gridstate.drag.potentialColumn == vcol && gridstate.drag.level == level &&
-            mousepos.x != gridstate.drag.startPos.x)
+
+        return true;
+    }
+
+    static void AppendExportField(std::string& out, std::string_view text, ItemGridExportFormat format)
+    {
+        if (format == ItemGridExportFormat::TSV)
         {
-            gridstate.drag.column = gridstate.drag.potentialColumn;
+            // TSV has no escaping, separators inside fields are replaced
+            for (auto ch : text) out.push_back(ch == '\t' || ch == '\n' || ch == '\r' ? ' ' : ch);
         }
-        else if (isMouseDown && gridstate.drag.mouseDown && gridstate.drag.column == vcol && gridstate.drag.level == level)
+        else if (text.find_first_of(",\"\r\n") == std::string_view::npos)
+            out.append(text);
+        else
         {
-            // This implying we are dragging the column around
-            auto diff = mousepos.x - gridstate.drag.lastPos.x;
-
-            if (diff > 0.f && (int16_t)headers[level].size() > (vcol + 1))
+            out.push_back('"');
+            for (auto ch : text)
             {
-                auto ncol = gridstate.colmap[level].vtol[vcol + 1];
-                auto& next = headers[level][ncol];
+                if (ch == '"') out.push_back('"');
+                out.push_back(ch);
+            }
+            out.push_back('"');
+        }
+    }
 
-                if ((mousepos.x - gridstate.drag.startPos.x) >= next.extent.GetWidth())
-                    gridstate.swapColumns(vcol, vcol + 1, headers, level);
+    static void DiscardItemGridExport(void* data);
+
+    static void RunItemGridExport(void* data)
+    {
+        auto job = (ItemGridExportJob*)data;
+        char cell[GLIMMER_ITEMGRID_FORMATTED_CELL_SZ];
+        auto delimiter = job->options.format == ItemGridExportFormat::TSV ? '\t' : ',';
+        auto newline = job->options.format == ItemGridExportFormat::TSV ? std::string_view{ "\n" } : std::string_view{ "\r\n" };
+        auto ok = true;
+
+        if (job->next == 0 && job->options.header && !job->names.empty())
+        {
+            for (auto idx = 0; idx < (int32_t)job->columns.size(); ++idx)
+            {
+                if (idx > 0) job->buffer.push_back(delimiter);
+                if (job->columns[idx] < (int16_t)job->names.size())
+                    AppendExportField(job->buffer, job->names[job->columns[idx]], job->options.format);
             }
-            else if (diff < 0.f && (col - 1) >= 0)
+            job->buffer.append(newline);
+        }
+
+        auto end = std::min<int64_t>(job->next + GLIMMER_ITEMGRID_EXPORT_BATCH_ROWS, job->total);
+        for (; job->next < end && ok; ++job->next)
+        {
+            auto row = job->rows.empty() ? (int32_t)job->next : job->rows[job->next];
+            for (auto idx = 0; idx < (int32_t)job->columns.size(); ++idx)
             {
-                auto& prev = headers[level][col - 1];
+                auto col = job->columns[idx];
+                const auto* column = col < (int16_t)job->source.columns.size() ? &job->source.columns[col] : nullptr;
+                auto text = job->text != nullptr ? job->text(row, col) : column != nullptr ?
+                    FormatColumnValue(column->data, column->format, (int32_t)(job->next - job->first), cell, 
+                        GLIMMER_ITEMGRID_FORMATTED_CELL_SZ) : std::string_view{};
+                if (idx > 0) job->buffer.push_back(delimiter);
+                AppendExportField(job->buffer, text, job->options.format);
+            }
 
-                if ((gridstate.drag.startPos.x - mousepos.x) >= prev.extent.GetWidth())
-                    gridstate.swapColumns(col - 1, col, headers, level);
+            job->buffer.append(newline);
+            if (job->buffer.size() >= GLIMMER_ITEMGRID_EXPORT_BUFFER_SZ)
+            {
+                ok = WriteToDescriptor(job->options.fd, job->buffer.data(), job->buffer.size());
+                job->buffer.clear();
             }
+        }
 
-            gridstate.drag.lastPos = mousepos;
+        if (ok && job->next == job->total)
+            ok = WriteToDescriptor(job->options.fd, job->buffer.data(), job->buffer.size());
+
+        // Grid went away while the batch was written, rest of the rows cannot be copied
+        if (job->text == nullptr && job->status.load() == EJ_Abandoned) ok = false;
+
+        // Remaining rows are queued behind other background tasks, so filtering is not starved
+        auto proceed = job->options.progress == nullptr || job->options.progress(job->grid, ok ? job->next : -1, 
+            job->total, job->options.data);
+        auto more = ok && proceed && job->next < job->total;
+
+        if (job->text != nullptr)
+        {
+            if (more) RunInBackground(&RunItemGridExport, job, &DiscardItemGridExport);
+            else delete job;
         }
-        else if (!isMouseDown)
+        else if (job->status.exchange(more ? EJ_Waiting : EJ_Finished) == EJ_Abandoned)
         {
-            gridstate.drag = ItemGridPersistentState::HeaderCellDragState{};
-            gridstate.state = ItemGridCurrentState::Default;
-            gridstate.drag.potentialColumn = -1;
+            if (more && job->options.progress != nullptr) job->options.progress(job->grid, -1, job->total, job->options.data);
+            delete job;
         }
     }
 
-    static void AddItemGridScrollBars(ItemGridBuilder& builder, ItemGridPersistentState& state, 
-        const ItemGridConfig& config, IRenderer& renderer, ImRect viewport, const IODescriptor& io)
+    // Export is cut short by cleanup, which is reported as a failure
+    static void DiscardItemGridExport(void* data)
     {
-        auto& context = *WidgetContextData::CurrentItemGridContext;
+        auto job = (ItemGridExportJob*)data;
+        if (job->options.progress != nullptr) job->options.progress(job->grid, -1, job->total, job->options.data);
+        if (job->text != nullptr || job->status.exchange(EJ_Finished) == EJ_Abandoned) delete job;
+    }
 
-        if (config.frozencols > 0)
+    // Copy values of the next batch of rows and queue it for writing, false if rows are gone
+    static bool CaptureItemGridExportBatch(ItemGridExportJob& job, const ItemGridPersistentState& state,
+        const ItemGridConfig& config, int32_t totalRows)
+    {
+        auto end = std::min<int64_t>(job.next + GLIMMER_ITEMGRID_EXPORT_BATCH_ROWS, job.total);
+        job.batch.clear();
+        for (auto pos = job.next; pos < end; ++pos)
         {
-            const auto& lastFrozenHeader = builder.headers[builder.currlevel][config.frozencols - 1];
-            viewport.Min.x = lastFrozenHeader.extent.Max.x + config.gridwidth;
-            builder.totalsz.x -= (viewport.Min.x - builder.origin.x);
+            auto row = job.rows.empty() ? (int32_t)pos : job.rows[pos];
+            if (row >= totalRows) return false;
+            job.batch.push_back(row);
+        }
 
-            // Determine if any col content in frozen part exceeds the available space w.r.t column widths
-            // Enable horizontal scrollbar in that case
-            if (builder.maxColWidth > lastFrozenHeader.extent.GetWidth())
-            {
-                state.altscroll.viewport.Min = builder.origin;
-                state.altscroll.viewport.Max = { lastFrozenHeader.extent.Max.x, builder.size.y + builder.origin.y };
+        job.first = job.next;
+        CaptureSourceColumns(job.source, state, config, job.batch, 0, job.columns);
+        job.status.store(EJ_Writing);
+        RunInBackground(&RunItemGridExport, &job, &DiscardItemGridExport);
+        return true;
+    }
 
-                ImVec2 sz;
-                state.altscroll.content.y = state.altscroll.viewport.GetHeight();
-                state.altscroll.content.x = (config.frozencols - 1) > 0 ? builder.headers[builder.currlevel][config.frozencols - 2].extent.Max.x +
-                    builder.maxColWidth : builder.maxColWidth;
-                state.altscroll.type = config.scrollprops;
-                HandleHScroll(state.altscroll, renderer, io, Config.scrollbar.width);
+    // Exports waiting for rows get their next batch, data source is valid while the grid is populated
+    static void UpdateItemGridExports(ItemGridPersistentState& state, const ItemGridConfig& config, int32_t totalRows)
+    {
+        auto& jobs = state.exporting.jobs;
+        for (size_t idx = 0; idx < jobs.size();)
+        {
+            auto job = jobs[idx];
+            auto status = job->status.load();
+
+            if (status == EJ_Waiting && !CaptureItemGridExportBatch(*job, state, config, totalRows))
+            {
+                // Rows were removed since the export started
+                if (job->options.progress != nullptr) job->options.progress(job->grid, -1, job->total, job->options.data);
+                status = EJ_Finished;
             }
-            else if (config.scrollprops & ST_Always_H)
+
+            if (status == EJ_Finished)
             {
-                auto max = builder.origin + builder.size;
-                renderer.DrawRect(ImVec2{ builder.origin.x, max.y - Config.scrollbar.width }, ImVec2{ lastFrozenHeader.extent.Max.x, max.y },
-                    ToRGBA(255, 255, 255), true);
+                delete job;
+                jobs[idx] = jobs.back();
+                jobs.pop_back();
             }
+            else ++idx;
         }
+    }
 
-        // builder.totalsz is in absolute coordinates, convert it to size
-        // state.scroll.content is adjusted in y-axis because y-absolute coordinates are
-        // shifted by scroll amount in y-direction, whereas x-coordiantes are not
-        auto sz = builder.totalsz - builder.origin - ImVec2{ 0.f, builder.headerHeight };
-        if (config.scrollprops & ST_Always_H) viewport.Max.y += Config.scrollbar.width;
-        if (config.scrollprops & ST_Always_V) viewport.Max.x += Config.scrollbar.width;
-        state.scroll.viewport = viewport;
-        state.scroll.content = sz + ImVec2{ 0.f,  state.scroll.state.pos.y };
-        state.scroll.type = config.scrollprops;
+    // Destroying grid state abandons its exports, which are reported as failed
+    ItemGridPersistentState::ExportState::~ExportState()
+    {
+        for (auto job : jobs)
+        {
+            auto status = job->status.exchange(EJ_Abandoned);
+            if (status == EJ_Writing) continue;
 
-        auto hasHScroll = HandleHScroll(state.scroll, renderer, io, Config.scrollbar.width);
-        HandleVScroll(state.scroll, renderer, io, Config.scrollbar.width, hasHScroll,
-            std::make_pair(builder.origin.y, builder.origin.y + builder.size.y));
+            if (status == EJ_Waiting && job->options.progress != nullptr)
+                job->options.progress(job->grid, -1, job->total, job->options.data);
+            delete job;
+        }
     }
 
-    bool BeginItemGrid(int32_t id, int32_t geometry, const NeighborWidgets& neighbors)
+#pragma endregion
+
+#pragma region ItemGrid lazy tree
+
+    using ItemGridTreeState = ItemGridPersistentState::TreeState;
+
+    static bool HasTreeModel(const ItemGridConfig& config)
     {
-        auto& context = GetContext();
-        auto& builder = context.itemGrids.push();
-        const auto& config = context.GetState(id).state.grid;
-        const auto style = context.GetStyle(WS_Default, id);
+        return config.tree.loadChildren != nullptr;
+    }
 
-        builder.id = id;
-        builder.geometry = geometry;
-        builder.neighbors = neighbors;
+    // Index past the visible descendents of visible row at index
+    static int32_t VisibleSubtreeEnd(const ItemGridTreeState& tree, int32_t index)
+    {
+        auto depth = tree.rows[index].depth;
+        auto end = index + 1;
+        while (end < (int32_t)tree.rows.size() && tree.rows[end].depth > depth) ++end;
+        return end;
+    }
 
-        LayoutItemDescriptor item;
-        item.wtype = WT_ItemGrid;
-        item.id = id;
-        AddExtent(item, style, neighbors);
-        if (config.scrollprops & ST_Always_H) item.content.Max.y -= Config.scrollbar.width;
-        if (config.scrollprops & ST_Always_V) item.content.Max.x -= Config.scrollbar.width;
-        builder.size = item.content.GetSize();
-        builder.origin = builder.nextpos = item.content.Min;
+    // Append visible rows below node i.e. its children and their expanded descendents
+    static void CollectVisibleRows(const ItemGridTreeState& tree, int32_t node, int16_t depth, 
+        std::vector<ItemGridTreeState::VisibleRow>& rows)
+    {
+        auto it = tree.nodes.find(node);
+        if (it == tree.nodes.end() || !it->second.expanded) return;
 
-        context.CurrentItemGridContext = &context;
-        PushContext(id, NestedContextSourceType::ItemGrid);
-        
-        return true;
+        if (!it->second.loaded)
+            rows.push_back({ -1, node, depth });
+        else
+            for (auto child : it->second.children)
+            {
+                rows.push_back({ child, node, depth });
+                CollectVisibleRows(tree, child, (int16_t)(depth + 1), rows);
+            }
     }
 
-    bool BeginItemGrid(std::string_view id, int32_t geometry, const NeighborWidgets& neighbors)
+    // Replace visible rows below visible row at index (-1 for root) with current descendents
+    static void SpliceVisibleRows(ItemGridTreeState& tree, int32_t index)
     {
-        auto [iid, __] = GetIdFromString(id, WT_ItemGrid);
-        return BeginItemGrid(iid, geometry, neighbors);
+        auto node = index == -1 ? -1 : tree.rows[index].node;
+        auto depth = index == -1 ? (int16_t)0 : (int16_t)(tree.rows[index].depth + 1);
+        auto end = index == -1 ? (int32_t)tree.rows.size() : VisibleSubtreeEnd(tree, index);
+        std::vector<ItemGridTreeState::VisibleRow> rows;
+        CollectVisibleRows(tree, node, depth, rows);
+        tree.rows.erase(tree.rows.begin() + index + 1, tree.rows.begin() + end);
+        tree.rows.insert(tree.rows.begin() + index + 1, rows.begin(), rows.end());
     }
 
-    void SetItemGridBehavior(int16_t sortedcol, int32_t highlights, int32_t selection, int32_t scrollprops,
-        bool uniformRowHeights, bool isTree)
+    static void ToggleTreeNode(int32_t id, ItemGridTreeState& tree, const ItemGridConfig& config, int32_t index)
     {
-        auto& context = *WidgetContextData::CurrentItemGridContext;
-        auto& builder = context.itemGrids.top();
-        auto& config = context.GetState(builder.id).state.grid;
-        auto& state = context.GridState(builder.id);
-        assert(builder.phase == ItemGridConstructPhase::None);
+        auto node = index == -1 ? -1 : tree.rows[index].node;
+        auto& data = tree.nodes[node];
+        data.expanded = index == -1 || !data.expanded;
 
-        config.highlights = highlights;
-        config.selection = selection;
-        config.scrollprops = scrollprops;
-        config.uniformRowHeights = uniformRowHeights;
-        config.isTree = isTree;
-        state.sortedCol = sortedcol;
+        if (data.expanded && !data.loaded && !data.loading)
+        {
+            data.loading = true;
+            config.tree.loadChildren(id, node);
+        }
+
+        SpliceVisibleRows(tree, index);
     }
 
-    void SetItemGridProviders(ItemGridConfig::CellPropertiesProviderT cellprops,
-        ItemGridConfig::CellWidgetProviderT cellwidget,
-        ItemGridConfig::CellContentProviderT cellcontent,
-        ItemGridConfig::HeaderProviderT header)
+    static void ApplyTreeChildren(ItemGridTreeState& tree, int32_t node, std::vector<int32_t>&& children)
+    {
+        auto& data = tree.nodes[node];
+        data.children = std::move(children);
+        data.loaded = true;
+        data.loading = false;
+        if (!data.expanded) return;
+
+        // Node is not visible if an ancestor is collapsed, rows are collected upon its expansion
+        if (node == -1) SpliceVisibleRows(tree, -1);
+        else
+        {
+            auto it = std::find_if(tree.rows.begin(), tree.rows.end(), [node](const auto& row) { return row.node == node; });
+            if (it != tree.rows.end()) SpliceVisibleRows(tree, (int32_t)(it - tree.rows.begin()));
+        }
+    }
+
+    // Children loaded for a grid which is destroyed (widget released, nested context recycled,
+    // cleanup) are never consumed, and would be applied to the next grid reusing its id
+    ItemGridPersistentState::TreeState::~TreeState()
+    {
+        if (grid == -1) return;
+
+        std::unique_lock<std::mutex> guard{ TreeChildrenLock };
+        std::erase_if(LoadedTreeChildren, [this](const ItemGridTreeChildren& loaded) { return loaded.grid == grid; });
+    }
+
+    static ItemDescendentVisualState GetTreeNodeVisualState(const ItemGridTreeState& tree, const ItemGridConfig& config, int32_t node)
+    {
+        if (node == -1) return ItemDescendentVisualState::NoDescendent;
+
+        auto it = tree.nodes.find(node);
+        auto hasChildren = it != tree.nodes.end() && it->second.loaded ? !it->second.children.empty() :
+            config.tree.hasChildren != nullptr ? config.tree.hasChildren(node) : true;
+        return !hasChildren ? ItemDescendentVisualState::NoDescendent : it != tree.nodes.end() && it->second.expanded ?
+            ItemDescendentVisualState::Expanded : ItemDescendentVisualState::Collapsed;
+    }
+
+    static std::pair<std::string_view, TextType> GetTreeLoadingContent(const ItemGridConfig::CellGeometry& cell)
     {
         auto& context = *WidgetContextData::CurrentItemGridContext;
-        auto& builder = context.itemGrids.top();
-        auto& config = context.GetState(builder.id).state.grid;
-        assert(builder.phase == ItemGridConstructPhase::None);
-        assert(cellprops != nullptr);
-        assert(cellwidget != nullptr || cellcontent != nullptr);
+        const auto& config = context.GetState(context.itemGrids.top().id).state.grid;
+        return { cell.col == 0 ? config.tree.loadingText : std::string_view{}, TextType::PlainText };
+    }
 
-        config.cellprops = cellprops;
-        config.cellwidget = cellwidget;
-        config.cellcontent = cellcontent;
-        config.header = header;
+    // Apply clicked expander and loaded children to the flattened rows, returns number of visible rows
+    static int32_t UpdateItemGridTree(ItemGridBuilder& builder, ItemGridPersistentState& state, const ItemGridConfig& config)
+    {
+        auto& tree = state.tree;
+        auto modified = false;
+
+        if (!tree.initialized)
+        {
+            tree.initialized = true;
+            tree.grid = builder.id;
+            ToggleTreeNode(builder.id, tree, config, -1);
+            modified = true;
+        }
+
+        if (tree.toggled >= 0 && tree.toggled < (int32_t)tree.rows.size() && tree.rows[tree.toggled].node != -1)
+        {
+            ToggleTreeNode(builder.id, tree, config, tree.toggled);
+            modified = true;
+        }
+        tree.toggled = -1;
+
+        std::vector<ItemGridTreeChildren> loaded;
+        {
+            std::unique_lock<std::mutex> guard{ TreeChildrenLock };
+            for (auto idx = 0; idx < (int32_t)LoadedTreeChildren.size();)
+            {
+                if (LoadedTreeChildren[idx].grid == builder.id)
+                {
+                    loaded.emplace_back(std::move(LoadedTreeChildren[idx]));
+                    LoadedTreeChildren.erase(LoadedTreeChildren.begin() + idx);
+                }
+                else ++idx;
+            }
+        }
+
+        for (auto& result : loaded)
+            ApplyTreeChildren(tree, result.node, std::move(result.children));
+
+        // Visible row indexes have shifted, measured heights no longer apply
+        if (modified || !loaded.empty()) state.rowExtents.pitches.resize(0, 0.f);
+        builder.treeRows = tree.rows.data();
+        return (int32_t)tree.rows.size();
     }
 
+#pragma endregion
+
     bool BeginItemGridHeader(int levels)
     {
         assert(levels > 0 && levels <= GLIMMER_MAX_ITEMGRID_COLUMN_CATEGORY_LEVEL);
@@ -6483,6 +9166,8 @@ namespace glimmer
                                     state.sortedAscending = !state.sortedAscending;
                                 state.sortedCol = col;
                                 state.sortedLevel = level;
+                                if (level == builder.levels - 1)
+                                    UpdateSortColumns(state.sorting, col, state.sortedAscending, (io.modifiers & ShiftKeyMod) != 0);
                                 result.event = WidgetEvent::Clicked;
                                 result.col = col; result.row = -1;
                                 result.order = state.sortedAscending;
@@ -6668,6 +9353,110 @@ namespace glimmer
         config.epilogue = providers;
     }
 
+    void SetItemGridAggregates(std::span<const ItemGridAggregate> columns, ItemGridConfig::AggregateValueProviderT value,
+        std::string_view format)
+    {
+        auto& context = *WidgetContextData::CurrentItemGridContext;
+        auto& builder = context.itemGrids.top();
+        auto& config = context.GetState(builder.id).state.grid;
+        auto& aggregation = context.GridState(builder.id).aggregation;
+        assert(value != nullptr || HasDataSource(config));
+        config.aggregates.columns = columns;
+        config.aggregates.value = value;
+        config.aggregates.format = format;
+
+        // Results are passed to snprintf as double, other formats fall back to default
+        if (format != aggregation.format)
+        {
+            auto valid = !format.empty() && IsValidColumnFormat(ItemGridColumnType::Real, format);
+            assert(valid && "Aggregate format does not take a double");
+            aggregation.format.assign(valid ? format : std::string_view{ "%g" });
+        }
+        if (builder.epilogueRowCount == 0) builder.epilogueRowCount = 1;
+    }
+
+    void InvalidateItemGridAggregates(int32_t id)
+    {
+        GetContext().GridState(id).aggregation.dirty = true;
+    }
+
+    void InvalidateItemGridAggregates(int32_t id, int32_t row)
+    {
+        GetContext().GridState(id).aggregation.updated.push_back(row);
+    }
+
+    void ExportItemGrid(int32_t id, const ItemGridExportOptions& options)
+    {
+        auto& context = GetContext();
+        const auto& config = context.GetState(id).state.grid;
+        auto& state = context.GridState(id);
+        assert(options.fd >= 0);
+        assert(options.text != nullptr || config.filtertext != nullptr || HasDataSource(config));
+        assert(!config.isTree && config.stream == nullptr);
+
+        // View is captured here as it changes while rows are written from background thread
+        auto job = new ItemGridExportJob{};
+        job->options = options;
+        job->text = options.text != nullptr ? options.text : config.filtertext;
+        job->grid = id;
+
+        if (!options.names.empty())
+            for (auto name : options.names) job->names.emplace_back(name);
+        else if (!config.config.headers.empty())
+            for (const auto& column : config.config.headers.back()) job->names.emplace_back(column.name);
+
+        const auto& colmap = state.colmap[state.leafLevel];
+        auto selectColumns = options.selectedOnly && (config.selection & IG_SelectColumn);
+        for (int16_t vcol = 0; vcol < state.populatedCols; ++vcol)
+        {
+            auto col = vcol < colmap.vtol.size() && colmap.vtol[vcol] != -1 ? colmap.vtol[vcol] : vcol;
+            if (!selectColumns || state.selection.isColumnSelected(col)) job->columns.push_back(col);
+        }
+
+        auto totalRows = state.populatedRows;
+        const int32_t* order = state.filtering.active ? state.filtering.rows.data() :
+            !state.sorting.columns.empty() && state.sorting.sortedRows == totalRows ? state.sorting.order.data() : nullptr;
+        auto count = state.filtering.active ? (int32_t)state.filtering.rows.size() : totalRows;
+
+        if (options.selectedOnly && !(config.selection & IG_SelectColumn))
+        {
+            // Cell selections export the rows which have a selected cell
+            for (auto idx = 0; idx < count; ++idx)
+            {
+                auto row = order != nullptr ? order[idx] : idx;
+                auto selected = state.selection.isRowSelected(row, 0);
+                for (auto col = 0; col < (int32_t)job->columns.size() && !selected; ++col)
+                    selected = state.selection.isCellSelected(row, job->columns[col], 0);
+                if (selected) job->rows.push_back(row);
+            }
+
+            job->total = (int64_t)job->rows.size();
+        }
+        else
+        {
+            if (order != nullptr) job->rows.assign(order, order + count);
+            job->total = count;
+        }
+
+        job->buffer.reserve(GLIMMER_ITEMGRID_EXPORT_BUFFER_SZ + 1024);
+        if (job->text != nullptr)
+        {
+            RunInBackground(&RunItemGridExport, job, &DiscardItemGridExport);
+            return;
+        }
+
+        // Values are copied a batch at a time as application may change them while rows are written
+        state.exporting.jobs.push_back(job);
+        job->status.store(EJ_Waiting);
+        UpdateItemGridExports(state, config, totalRows);
+    }
+
+    void ExportItemGrid(StringId id, const ItemGridExportOptions& options)
+    {
+        auto [iid, __] = GetIdFromString(id, WT_ItemGrid);
+        ExportItemGrid(iid, options);
+    }
+
     static float HAlignCellContent(ItemGridBuilder& builder, const ItemGridConfig& config, int16_t col,
         float required, float available)
     {
@@ -6733,6 +9522,148 @@ namespace glimmer
 
     static WidgetDrawResult PopulateData(int totalRows);
 
+#pragma region ItemGrid row virtualization
+
+    static float EstimatedRowPitch(const ItemGridConfig& config)
+    {
+        return Config.defaultFontSz + (2.f * config.cellpadding.y) + config.gridwidth;
+    }
+
+    // Sum of pitches of first `row` rows, pitches of streamed rows wrap around the ring buffer
+    static float GetPitchesPrefix(const ItemGridPersistentState& state, int32_t row)
+    {
+        const auto& extents = state.rowExtents;
+        const auto& pitches = extents.pitches;
+        if (extents.origin == 0) return pitches.prefix(row);
+
+        auto end = extents.origin + row;
+        return end <= pitches.size() ? pitches.prefix(end) - pitches.prefix(extents.origin) :
+            pitches.total() - pitches.prefix(extents.origin) + pitches.prefix(end - pitches.size());
+    }
+
+    static int32_t FindRowAtOffset(const ItemGridPersistentState& state, const ItemGridConfig& config,
+        float offset, int32_t totalRows)
+    {
+        const auto& extents = state.rowExtents;
+        offset = std::max(offset, 0.f);
+        if (config.uniformRowHeights)
+            return std::min((int32_t)(offset / extents.uniform), totalRows - 1);
+        if (extents.origin == 0)
+            return std::min(extents.pitches.find(offset), totalRows - 1);
+
+        // Ring buffer is full when origin is non-zero, rows past the last pitch start from index 0
+        auto skipped = extents.pitches.prefix(extents.origin), total = extents.pitches.total();
+        auto row = offset + skipped < total ? extents.pitches.find(offset + skipped) - extents.origin :
+            extents.pitches.find(offset + skipped - total) + extents.pitches.size() - extents.origin;
+        return std::min(row, totalRows - 1);
+    }
+
+    static float GetRowOffset(const ItemGridPersistentState& state, const ItemGridConfig& config, int32_t row)
+    {
+        return config.uniformRowHeights ? (float)row * state.rowExtents.uniform : GetPitchesPrefix(state, row);
+    }
+
+    static float GetTotalRowsHeight(const ItemGridPersistentState& state, const ItemGridConfig& config, int32_t totalRows)
+    {
+        return config.uniformRowHeights ? (float)totalRows * state.rowExtents.uniform :
+            GetPitchesPrefix(state, totalRows);
+    }
+
+    // Rows [first, last] which intersect the viewport, builder.nextpos is at the start of first row
+    // (scrolled), unmeasured rows are assumed to be of the last measured height
+    static std::pair<int32_t, int32_t> GetVisibleRowRange(const ItemGridBuilder& builder, ItemGridPersistentState& state,
+        const ItemGridConfig& config, int32_t totalRows)
+    {
+        auto& extents = state.rowExtents;
+        auto estimate = extents.estimate > 0.f ? extents.estimate : EstimatedRowPitch(config);
+
+        if (config.uniformRowHeights)
+        {
+            if (extents.uniform <= 0.f) extents.uniform = estimate;
+        }
+        else if (auto slots = extents.capacity > 0 ? extents.capacity : totalRows; extents.pitches.size() != slots)
+            extents.pitches.resize(slots, estimate);
+
+        auto top = state.scroll.state.pos.y;
+        auto bottom = top + std::max(0.f, builder.origin.y + builder.size.y - (builder.nextpos.y + top));
+        return { FindRowAtOffset(state, config, top, totalRows), FindRowAtOffset(state, config, bottom, totalRows) };
+    }
+
+    static void RecordRowPitch(ItemGridPersistentState& state, const ItemGridConfig& config, int32_t row, float pitch)
+    {
+        auto& extents = state.rowExtents;
+        extents.estimate = pitch;
+
+        if (config.uniformRowHeights) extents.uniform = pitch;
+        else
+        {
+            auto slot = extents.capacity > 0 ? (extents.origin + row) % extents.capacity : row;
+            if (extents.pitches[slot] != pitch) extents.pitches.update(slot, pitch);
+        }
+    }
+
+#pragma endregion
+
+#pragma region ItemGrid streaming
+
+    // Move rows appended to stream into view, the viewport follows the last row unless the user
+    // has scrolled up, in which case viewed rows are kept in place as oldest rows are discarded
+    static int32_t UpdateItemGridStream(ItemGridBuilder& builder, ItemGridPersistentState& state, const ItemGridConfig& config)
+    {
+        auto& stream = *config.stream;
+        auto& extents = state.rowExtents;
+        auto& streaming = state.streaming;
+        auto estimate = extents.estimate > 0.f ? extents.estimate : EstimatedRowPitch(config);
+
+        if (extents.capacity != stream.capacity())
+        {
+            extents.capacity = stream.capacity();
+            extents.pitches.resize(0, 0.f);
+            if (!config.uniformRowHeights) extents.pitches.resize(extents.capacity, estimate);
+        }
+
+        auto [appended, discarded] = stream.consume();
+        auto discardedHeight = config.uniformRowHeights ? (float)discarded * extents.uniform :
+            GetPitchesPrefix(state, std::min(discarded, extents.capacity));
+        extents.origin = stream.origin();
+
+        // Row ids are sequence numbers relative to base, which moves to the oldest row (discarding
+        // selection of older rows) before ids of retained rows would not fit in 32 bits
+        if (stream.first() - streaming.base > (uint64_t)(INT32_MAX - stream.capacity()))
+        {
+            auto delta = (int32_t)(stream.first() - streaming.base);
+            state.selection.shiftRows(delta);
+            state.anchor.row = state.anchor.row >= delta ? state.anchor.row - delta : -1;
+            state.cellstate.row = state.cellstate.row >= delta ? state.cellstate.row - delta : -1;
+            streaming.base = stream.first();
+        }
+
+        builder.streamRowId = (int32_t)(stream.first() - streaming.base);
+
+        // Appended rows are measured when visible, only their pitches (in reused slots) are reset
+        if (!config.uniformRowHeights)
+            for (auto row = std::max(0, stream.size() - appended); row < stream.size(); ++row)
+                extents.pitches.update((extents.origin + row) % extents.capacity, estimate);
+
+        auto& pos = state.scroll.state.pos.y;
+        auto viewh = std::max(0.f, builder.origin.y + builder.size.y - (builder.nextpos.y + pos));
+        auto maxpos = std::max(0.f, GetTotalRowsHeight(state, config, stream.size()) - viewh);
+
+        if (streaming.following && streaming.scroll >= 0.f && pos < streaming.scroll - 1.f)
+            streaming.following = false;
+        else if (!streaming.following && pos >= maxpos - 1.f)
+            streaming.following = true;
+
+        auto target = streaming.following ? maxpos : std::max(0.f, pos - discardedHeight);
+        builder.nextpos.y -= target - pos;
+        builder.startY -= target - pos;
+        pos = target;
+        streaming.scroll = streaming.following ? target : -1.f;
+        return stream.size();
+    }
+
+#pragma endregion
+
     static bool IsItemHighlighted(const ItemGridPersistentState& state, const ItemGridConfig& config, int32_t row, int16_t col, int16_t depth)
     {
         auto highlightRow = (config.highlights & IG_HighlightRows) != 0,
@@ -6749,31 +9680,12 @@ namespace glimmer
 
     static bool IsItemSelected(const ItemGridPersistentState& state, const ItemGridConfig& config, int32_t row, int16_t col, int16_t depth)
     {
-        auto selectRow = (config.selection & IG_SelectRow) != 0;
-        auto selectCol = (config.selection & IG_SelectColumn) != 0;
-        auto selectCell = (config.selection & IG_SelectCell) != 0;
-
-        for (auto idx = 0; idx < state.selections.size(); ++idx)
-        {
-            if (selectCell)
-            {
-                if (state.selections[idx].row == row && state.selections[idx].col == col &&
-                    state.selections[idx].depth == depth)
-                    return true;
-            }
-            else if (selectRow)
-            {
-                if (state.selections[idx].row == row && state.selections[idx].depth == depth)
-                    return true;
-            }
-            else
-            {
-                if (state.selections[idx].col == col && state.selections[idx].depth == depth)
-                    return true;
-            }
-        }
-
-        return false;
+        if (config.selection & IG_SelectCell)
+            return state.selection.isCellSelected(row, col, depth);
+        else if (config.selection & IG_SelectRow)
+            return state.selection.isRowSelected(row, depth);
+        else
+            return state.selection.isColumnSelected(col);
     }
 
     static void ExtractColumnProps(ColumnProps& colprops, const ItemGridPersistentState& state, ItemGridBuilder& builder,
@@ -6812,24 +9724,61 @@ namespace glimmer
         }
     }
 
+    // Text extent of a data row's cell, reused while row's version, cell's font and column widths are unchanged
+    static ImVec2 MeasureItemGridCell(ItemGridPersistentState& state, const ItemGridBuilder& builder, 
+        const ItemGridConfig& config, int32_t row, int16_t col, TextType type, std::string_view text,
+        const FontStyle& font, float wrapWidth)
+    {
+        if (config.rowversion == nullptr || row < 0 || builder.phase == ItemGridConstructPhase::EpilogRows)
+            return GetTextSize(type, text, font, wrapWidth, *Config.renderer);
+
+        auto ncols = (int32_t)builder.headers[builder.levels - 1].size();
+        if (state.measuredCells.size() != ncols * GLIMMER_ITEMGRID_MEASURE_CACHE_ROWS)
+        {
+            state.measuredCells.clear(false);
+            state.measuredCells.resize(ncols * GLIMMER_ITEMGRID_MEASURE_CACHE_ROWS, true);
+        }
+
+        auto version = config.rowversion(row);
+        auto& cell = state.measuredCells[(row % GLIMMER_ITEMGRID_MEASURE_CACHE_ROWS) * ncols + col];
+        if (cell.row != row || cell.version != version || cell.generation != state.measureGeneration ||
+            cell.font != font.font || cell.fontsz != font.size || cell.wrapWidth != wrapWidth)
+        {
+            cell.size = GetTextSize(type, text, font, wrapWidth, *Config.renderer);
+            cell.row = row;
+            cell.version = version;
+            cell.generation = state.measureGeneration;
+            cell.font = font.font;
+            cell.fontsz = font.size;
+            cell.wrapWidth = wrapWidth;
+        }
+
+        return cell.size;
+    }
+
     static std::string_view InvokeItemGridCellContent(WidgetContextData& context, ItemGridBuilder& builder,
-        const ItemGridPersistentState& state, const ItemGridConfig& config, const ItemGridItemProps& props,
+        ItemGridPersistentState& state, const ItemGridConfig& config, const ItemGridItemProps& props,
         ColumnProps& colprops, const std::pair<float, float>& bounds, int16_t col, int32_t row, int32_t rowid,
         int32_t itemprops, ItemGridConfig::CellWidgetProviderT cellwidget, ItemGridConfig::CellContentProviderT cellcontent)
     {
-        assert(cellwidget || cellcontent);
-        assert(cellwidget || (!props.isContentWidget && cellcontent));
+        assert(cellwidget || cellcontent || HasDataSource(config) || config.stream != nullptr || 
+            builder.phase == ItemGridConstructPhase::EpilogRows);
+        assert(cellwidget || !props.isContentWidget);
         std::string_view result;
 
         if (props.isContentWidget || (!cellcontent && cellwidget))
             cellwidget({ builder.parentId, rowid, itemprops, row, col, builder.depth, bounds });
         else
         {
-            auto [text, txtype] = cellcontent({ builder.parentId, rowid, itemprops, row, col, builder.depth, bounds });
+            // Without a content provider, cell text comes from the columnar data source
+            auto [text, txtype] = cellcontent ? cellcontent({ builder.parentId, rowid, itemprops, row, col, builder.depth, bounds }) :
+                builder.phase == ItemGridConstructPhase::EpilogRows ? GetAggregateCellContent(state, col) :
+                config.stream != nullptr ? std::make_pair(config.stream->cell(row, col), TextType::PlainText) :
+                GetSourceCellContent(state, config, row, col);
             auto style = context.GetStyle(props.disabled ? WS_Disabled :
                 colprops.selected ? WS_Selected : colprops.highlighted ? WS_Hovered : WS_Default);
-            auto textsz = GetTextSize(txtype, text, style.font, props.wrapText ? 
-                (bounds.second - builder.nextpos.x - config.cellpadding.x) : -1.f, *Config.renderer);
+            auto textsz = MeasureItemGridCell(state, builder, config, row, col, txtype, text, style.font, props.wrapText ? 
+                (bounds.second - builder.nextpos.x - config.cellpadding.x) : -1.f);
             builder.maxCellExtent = builder.nextpos + textsz;
             ImRect textrect{ builder.nextpos, builder.nextpos + textsz };
             ImVec2 textend{ bounds.second, builder.nextpos.y + textsz.y };
@@ -6848,32 +9797,24 @@ namespace glimmer
     static void UpdateSingleSelection(ItemGridPersistentState& state, const ItemGridConfig& config, int32_t col, int32_t row, int32_t depth)
     {
         if (config.selection & IG_SelectRow)
-            state.selections.emplace_back(row, -1, depth);
+            state.selection.selectRows(row, row, (int16_t)depth);
         else if (config.selection & IG_SelectColumn)
-            state.selections.emplace_back(-1, col, depth);
+            state.selection.selectColumns((int16_t)col, (int16_t)col);
         else
-            state.selections.emplace_back(row, col, depth);
+            state.selection.selectCell(row, (int16_t)col, (int16_t)depth);
+
+        state.anchor.row = row;
+        state.anchor.col = col;
+        state.anchor.depth = depth;
     }
 
     static void UpdateContiguosSelection(ItemGridPersistentState& state, ItemGridBuilder& builder, const ItemGridConfig& config, int32_t index, int32_t depth)
     {
-        static Vector<ItemGridPersistentState::ItemId, int16_t> temp;
-        auto selectRow = (config.selection & IG_SelectRow) != 0;
-
-        const auto last = state.selections.back();
-        auto start = std::min(selectRow ? last.row : last.col, index);
-        auto end = std::max(selectRow ? last.row : last.col, index);
-        auto idx = 0;
-
-        for (; idx < state.selections.size(); ++idx)
-            if (state.selections[idx].col < start)
-                temp.emplace_back(state.selections[idx]);
-            else break;
-
-        if (!selectRow)
+        if (!(config.selection & IG_SelectRow))
         {
-            for (; start <= end; ++start)
-                temp.emplace_back(-1, start, depth);
+            auto start = std::min(state.anchor.col, index);
+            auto end = std::max(state.anchor.col, index);
+            state.selection.selectColumns((int16_t)start, (int16_t)end);
         }
         else
         {
@@ -6881,36 +9822,41 @@ namespace glimmer
             auto from = firstPoint ? state.currentSelection : std::min(state.lastSelection, state.currentSelection);
             auto to = firstPoint ? state.currentSelection : std::max(state.lastSelection, state.currentSelection);
 
-            for (const auto& range : builder.rowYs)
+            if (builder.virtualRows)
             {
-                if ((range.from <= from && range.to >= from) || (range.to >= to && range.from <= to) ||
-                    (range.from > from && range.to < to))
+                // Rows outside the viewport are not recorded in rowYs, map from persisted row extents
+                auto first = FindRowAtOffset(state, config, from - builder.rowOffset, builder.shownRows);
+                auto last = FindRowAtOffset(state, config, to - builder.rowOffset, builder.shownRows);
+                if (builder.treeRows != nullptr)
                 {
-                    auto exists = false;
-                    for (const auto& select : state.selections)
-                        if (select.depth == range.depth && select.row == range.row)
-                        {
-                            exists = true; break;
-                        }
-
-                    if (!exists)
-                        temp.emplace_back(range.row, -1, range.depth);
+                    for (auto row = first; row <= last; ++row)
+                        if (builder.treeRows[row].node != -1)
+                            state.selection.selectRows(builder.treeRows[row].node, builder.treeRows[row].node, 
+                                builder.treeRows[row].depth);
+                }
+                else if (config.stream != nullptr)
+                    state.selection.selectRows(builder.streamRowId + first, builder.streamRowId + last, (int16_t)depth);
+                else if (builder.rowOrder == nullptr) state.selection.selectRows(first, last, (int16_t)depth);
+                else
+                    for (auto row = first; row <= last; ++row)
+                        state.selection.selectRows(builder.rowOrder[row], builder.rowOrder[row], (int16_t)depth);
+            }
+            else
+            {
+                for (const auto& range : builder.rowYs)
+                {
+                    if ((range.from <= from && range.to >= from) || (range.to >= to && range.from <= to) ||
+                        (range.from > from && range.to < to))
+                        state.selection.selectRows(range.row, range.row, (int16_t)range.depth);
                 }
             }
         }
-
-        for (; idx < state.selections.size(); ++idx)
-            if (state.selections[idx].col > end)
-                temp.emplace_back(state.selections[idx]);
-
-        state.selections.clear(true);
-        state.selections.resize(temp.size(), false);
-        for (idx = 0; idx < temp.size(); ++idx)
-            state.selections.emplace_back(temp[idx]);
     }
 
     static void UpdateItemSelection(ItemGridPersistentState& state, ItemGridBuilder& builder, const ItemGridConfig& config, const IODescriptor& io, int32_t col, int32_t row, int32_t depth)
     {
+        auto hasAnchor = (config.selection & IG_SelectColumn) ? state.anchor.col != -1 : state.anchor.row != -1;
+
         if (config.selection & IG_SelectMultiItem)
         {
             if (io.modifiers & CtrlKeyMod)
@@ -6918,19 +9864,19 @@ namespace glimmer
             else if (io.modifiers & ShiftKeyMod)
                 if (config.selection & IG_SelectRow)
                 {
-                    if (state.selections.empty()) state.selections.emplace_back(row, -1);
+                    if (!hasAnchor) UpdateSingleSelection(state, config, col, row, depth);
                     else UpdateContiguosSelection(state, builder, config, row, depth);
                 }
                 else if (config.selection & IG_SelectColumn)
                 {
-                    if (state.selections.empty()) state.selections.emplace_back(col, -1);
+                    if (!hasAnchor) UpdateSingleSelection(state, config, col, row, depth);
                     else UpdateContiguosSelection(state, builder, config, col, -1);
                 }
                 else // TODO: Ambiguous here, need to decide
-                    state.selections.emplace_back(row, col, depth);
+                    state.selection.selectCell(row, (int16_t)col, (int16_t)depth);
             else
             {
-                state.selections.clear(true);
+                state.selection.clear();
                 UpdateSingleSelection(state, config, col, row, depth);
             }
         }
@@ -6939,25 +9885,25 @@ namespace glimmer
             if (io.modifiers & ShiftKeyMod)
                 if (config.selection & IG_SelectRow)
                 {
-                    if (state.selections.empty()) state.selections.emplace_back(row, -1);
+                    if (!hasAnchor) UpdateSingleSelection(state, config, col, row, depth);
                     else UpdateContiguosSelection(state, builder, config, row, depth);
                 }
                 else if (config.selection & IG_SelectColumn)
                 {
-                    if (state.selections.empty()) state.selections.emplace_back(col, -1);
+                    if (!hasAnchor) UpdateSingleSelection(state, config, col, row, depth);
                     else UpdateContiguosSelection(state, builder, config, col, -1);
                 }
                 else
-                    state.selections.emplace_back(row, col);
+                    state.selection.selectCell(row, (int16_t)col, (int16_t)depth);
             else
             {
-                state.selections.clear(true);
+                state.selection.clear();
                 UpdateSingleSelection(state, config, col, row, depth);
             }
         }
         else
         {
-            state.selections.clear(true);
+            state.selection.clear();
             UpdateSingleSelection(state, config, col, row, depth);
         }
 
@@ -6966,12 +9912,14 @@ namespace glimmer
             state.lastSelection = -1.f;
         }
 
-        LOG_NUM2("selected-row-count", state.selections.size());
+        LOG_NUM2("selected-row-count", state.selection.rowCount((int16_t)depth, builder.rowcount));
     }
 
     static int32_t GetRowId(const ItemGridBuilder& builder, const ItemGridConfig& config, int32_t row, bool epilogue)
     {
-        return epilogue ? builder.rowcount + row - 1 : config.isTree ? builder.perDepthRowCount[builder.depth] : row;
+        return epilogue ? builder.rowcount + row - 1 : builder.treeRows != nullptr ? builder.treeRows[row].node :
+            config.stream != nullptr ? builder.streamRowId + row :
+            config.isTree ? builder.perDepthRowCount[builder.depth] : builder.rowOrder != nullptr ? builder.rowOrder[row] : row;
     }
 
     static ImVec2 RenderItemGridCell(WidgetContextData& context, ItemGridBuilder& builder,
@@ -7033,6 +9981,7 @@ namespace glimmer
                             result.event = WidgetEvent::Clicked;
                             result.row = row; result.col = -1;
                             itemToggled = true;
+                            if (builder.treeRows != nullptr) state.tree.toggled = row;
                         }
                     }
                 }
@@ -7122,7 +10071,7 @@ namespace glimmer
 
         BEGIN_LOG_OBJECT("itemgrid-filter-cell");
         LOG_NUM(col);
-        const auto& filtertext = context.GetState(header.genid).state.input.text;
+        auto filtertext = context.GetState(header.genid).state.input.text.view();
         LOG_TEXT(filtertext);
         LOG_RECT(cellGeometry.extent); LOG_RECT(cellGeometry.content);
         LOG_COLOR(cellGeometry.bgcolor); LOG_COLOR(cellGeometry.fgcolor);
@@ -7159,9 +10108,27 @@ namespace glimmer
         ItemGridPersistentState& state, const ItemGridConfig& config, WidgetDrawResult& result,
         int totalRows)
     {
-        auto row = 0;
+        auto row = 0, lastRow = totalRows - 1;
         auto startx = builder.headers[builder.levels - 1][0].content.Min.x;
+        auto starty = builder.nextpos.y;
         builder.phase = ItemGridConstructPhase::Rows;
+
+        // Child rows of a tree are laid out inline, hence only flat grids (or lazy trees, which are
+        // flattened) can skip rows which are outside the viewport
+        auto virtualized = (!config.isTree || builder.treeRows != nullptr) && builder.depth == 0 && totalRows > 0;
+        auto cellIndent = builder.cellIndent;
+        if (virtualized)
+        {
+            std::tie(row, lastRow) = GetVisibleRowRange(builder, state, config, totalRows);
+            builder.nextpos.y += GetRowOffset(state, config, row);
+            builder.rowOffset = starty - builder.startY;
+            builder.virtualRows = true;
+        }
+
+        const auto rowsToAdd = lastRow - row + 1;
+        if (HasDataSource(config) && config.cellcontent == nullptr && rowsToAdd <= GLIMMER_ITEMGRID_FORMAT_CACHE_ROWS)
+            FormatSourceCells(state, config, builder.rowOrder, row, lastRow);
+
         if (builder.headers[GLIMMER_MAX_ITEMGRID_COLUMN_CATEGORY_LEVEL].empty())
             builder.headers[GLIMMER_MAX_ITEMGRID_COLUMN_CATEGORY_LEVEL].resize(builder.headers[builder.levels - 1].size());
         
@@ -7174,12 +10141,26 @@ namespace glimmer
         builder.cellvals.resize(builder.headers[builder.levels - 1].size(), true);
         BEGIN_LOG_ARRAY("itemgrid-rows");
 
-        while (totalRows > 0)
+        for (; row <= lastRow; ++row)
         {
             auto coloffset = 1;
             auto maxh = 0.f;
             auto rowid = GetRowId(builder, config, row, false);
+            auto datarow = builder.rowOrder != nullptr ? builder.rowOrder[row] : row;
+            auto loading = false;
+            auto treeVState = ItemDescendentVisualState::NoDescendent;
             builder.currentY = builder.nextpos.y;
+
+            if (builder.treeRows != nullptr)
+            {
+                const auto& visible = builder.treeRows[row];
+                datarow = visible.node;
+                loading = visible.node == -1;
+                treeVState = GetTreeNodeVisualState(state.tree, config, visible.node);
+                builder.depth = visible.depth;
+                builder.parentId = visible.parent;
+                builder.cellIndent = cellIndent + (config.config.indent * (float)visible.depth);
+            }
             builder.nextpos.y += config.cellpadding.y;
 
             // Determine cell geometry for current row
@@ -7193,10 +10174,17 @@ namespace glimmer
                     auto highlighted = IsItemHighlighted(state, config, row, col, builder.depth);
                     auto itemprops = selected ? IG_Selected : 0;
                     itemprops |= highlighted ? IG_Highlighted : 0;
-                    auto props = config.cellprops ? config.cellprops({ builder.parentId, rowid, itemprops, row, col, builder.depth })
+                    auto props = config.cellprops && !loading ? config.cellprops({ builder.parentId, rowid, itemprops, datarow, col, builder.depth })
                         : ItemGridItemProps{};
                     auto& colprops = builder.headers[GLIMMER_MAX_ITEMGRID_COLUMN_CATEGORY_LEVEL][col];
 
+                    // Expansion of lazy tree is tracked by the grid, child rows are already flattened
+                    if (builder.treeRows != nullptr)
+                    {
+                        props.vstate = treeVState;
+                        props.children = 0;
+                    }
+
                     builder.currCol = col;
                     builder.currRow = row;
                     context.ToggleDeferedRendering(true, false);
@@ -7218,8 +10206,8 @@ namespace glimmer
                         builder.nextpos.x += config.cellpadding.x;
                     }
 
-                    auto text = InvokeItemGridCellContent(context, builder, state, config, props, 
-                        colprops, bounds, col, row, rowid, itemprops, config.cellwidget, config.cellcontent);
+                    auto text = InvokeItemGridCellContent(context, builder, state, config, props, colprops, bounds, col, 
+                        datarow, rowid, itemprops, loading ? nullptr : config.cellwidget, loading ? &GetTreeLoadingContent : config.cellcontent);
                     builder.cellvals.emplace_back(text, props.vstate);
                     context.RecordDeferRange(header.range, false);
 
@@ -7268,7 +10256,9 @@ namespace glimmer
             builder.nextpos.x = startx;
             context.adhocLayout.top().nextpos = builder.nextpos;
 
-            RecordRowYRange(builder, config, maxh, totalRows, row, false);
+            RecordRowYRange(builder, config, maxh, rowsToAdd, row, false);
+            if (virtualized)
+                RecordRowPitch(state, config, row, maxh + (2.f * config.cellpadding.y) + config.gridwidth);
 
             // Draw child rows
             if (builder.childState.first == ItemDescendentVisualState::Expanded &&
@@ -7284,11 +10274,17 @@ namespace glimmer
             }
 
             context.ClearDeferredData();
-            --totalRows;
-            ++row;
         }
 
         END_LOG_ARRAY();
+        if (builder.treeRows != nullptr)
+        {
+            builder.depth = 0;
+            builder.parentId = -1;
+            builder.cellIndent = cellIndent;
+        }
+
+        if (virtualized) builder.nextpos.y = starty + GetTotalRowsHeight(state, config, totalRows);
         builder.totalsz.y = builder.nextpos.y;
         builder.totalsz.x = builder.headers[builder.currlevel].back().extent.Max.x + config.gridwidth;
     }
@@ -7421,11 +10417,12 @@ namespace glimmer
         for (auto row = 0; row < totalRows; ++row)
         {
             auto rowid = GetRowId(builder, config, row, false);
+            auto datarow = builder.rowOrder != nullptr ? builder.rowOrder[row] : row;
             auto selected = IsItemSelected(state, config, rowid, col, builder.depth);
             auto highlighted = IsItemHighlighted(state, config, row, col, builder.depth);
             auto itemprops = selected ? IG_Selected : 0;
             itemprops |= highlighted ? IG_Highlighted : 0;
-            auto props = config.cellprops ? config.cellprops({ builder.parentId, rowid, itemprops, row, (int16_t)col, builder.depth }) 
+            auto props = config.cellprops ? config.cellprops({ builder.parentId, rowid, itemprops, datarow, (int16_t)col, builder.depth }) 
                 : ItemGridItemProps{};
 
             builder.currCol = col;
@@ -7440,7 +10437,7 @@ namespace glimmer
             context.deferEvents = true;
 
             context.RecordDeferRange(header.range, true);
-            InvokeItemGridCellContent(context, builder, state, config, props, colprops, bounds, col, row, 
+            InvokeItemGridCellContent(context, builder, state, config, props, colprops, bounds, col, datarow, 
                 rowid, itemprops, config.cellwidget, config.cellcontent);
             context.RecordDeferRange(header.range, false);
 
@@ -7469,9 +10466,34 @@ namespace glimmer
         auto& renderer = context.GetRenderer();
         auto io = Config.platform->CurrentIO();
         auto& ctx = GetContext();
-        assert(config.cellwidget != nullptr || config.cellcontent != nullptr);
+        assert(config.cellwidget != nullptr || config.cellcontent != nullptr || HasDataSource(config) || config.stream != nullptr);
         builder.rowcount = totalRows;
 
+        if (HasTreeModel(config) && builder.depth == 0)
+            totalRows = builder.rowcount = UpdateItemGridTree(builder, state, config);
+        if (config.stream != nullptr && builder.depth == 0)
+            totalRows = builder.rowcount = UpdateItemGridStream(builder, state, config);
+
+        // Streamed rows are only shown in the order of arrival
+        auto reorderable = !config.isTree && config.stream == nullptr && builder.depth == 0;
+        auto dataRows = totalRows;
+        if ((config.sortkey != nullptr || HasDataSource(config)) && reorderable)
+            UpdateItemGridSort(builder, state, config, totalRows);
+        if ((config.filtertext != nullptr || HasDataSource(config)) && reorderable)
+            totalRows = UpdateItemGridFilter(ctx, builder, state, config, totalRows);
+        if (!config.aggregates.columns.empty() && reorderable)
+            UpdateItemGridAggregates(state, config, dataRows);
+        if (!state.exporting.jobs.empty() && builder.depth == 0)
+            UpdateItemGridExports(state, config, dataRows);
+        builder.shownRows = totalRows;
+
+        if (builder.depth == 0)
+        {
+            state.populatedRows = dataRows;
+            state.leafLevel = (int16_t)(builder.levels - 1);
+            state.populatedCols = (int16_t)builder.headers[builder.levels - 1].size();
+        }
+
         if (builder.method == ItemGridPopulateMethod::ByRows) 
             AddRowData(ctx, builder, state, config, result, totalRows);
         else
@@ -7662,6 +10684,17 @@ namespace glimmer
         return result;
     }
 
+    ItemGridSelection& GetItemGridSelection(int32_t id)
+    {
+        return GetContext().GridState(id).selection;
+    }
+
+    ItemGridSelection& GetItemGridSelection(StringId id)
+    {
+        auto [iid, __] = GetIdFromString(id, WT_ItemGrid);
+        return GetItemGridSelection(iid);
+    }
+
     WidgetDrawResult ItemGridImpl(int32_t id, const StyleDescriptor& style, const ImRect& margin, const ImRect& border, const ImRect& padding,
         const ImRect& content, const ImRect& text, IRenderer& renderer, const IODescriptor& io)
     {
@@ -7724,7 +10757,7 @@ namespace glimmer
         return Widget(id, WT_ItemGrid, geometry, neighbors);
     }
 
-    WidgetDrawResult StaticItemGrid(std::string_view id, const std::initializer_list<std::string_view>& headers,
+    WidgetDrawResult StaticItemGrid(StringId id, const std::initializer_list<std::string_view>& headers,
         std::pair<std::string_view, TextType>(*cell)(int32_t, int16_t), int32_t totalRows, int32_t geometry, const NeighborWidgets& neighbors)
     {
         static auto fptr = cell;
@@ -7822,7 +10855,7 @@ namespace glimmer
         BEGIN_LOG_ARRAY("split-panes");
     }
 
-    void BeginSplitRegion(std::string_view id, Direction dir, const std::initializer_list<SplitRegion>& splits, int32_t geometry, const NeighborWidgets& neighbors)
+    void BeginSplitRegion(StringId id, Direction dir, const std::initializer_list<SplitRegion>& splits, int32_t geometry, const NeighborWidgets& neighbors)
     {
         auto [iid, __] = GetIdFromString(id, WT_Splitter);
         BeginSplitRegion(iid, dir, splits, geometry, neighbors);
@@ -8190,6 +11223,352 @@ namespace glimmer
         return res;
     }
 
+    static std::vector<double> ChartPointsX, ChartPointsY; // Decimated points, reused across series
+
+    void ChartSeries::assign(std::span<const double> x, std::span<const double> y)
+    {
+        assert(x.size() == y.size());
+        xs.assign(x.begin(), x.end());
+        ys.assign(y.begin(), y.end());
+        pyramid.build(ys.data(), size());
+    }
+
+    void ChartSeries::assign(std::span<const double> y, double xstart, double xstep)
+    {
+        xs.clear();
+        ys.assign(y.begin(), y.end());
+        start = xstart;
+        step = xstep;
+        pyramid.build(ys.data(), size());
+    }
+
+    void ChartSeries::append(double x, double y)
+    {
+        assert(xs.size() == ys.size() && (xs.empty() || xs.back() <= x));
+        xs.push_back(x);
+        ys.push_back(y);
+        pyramid.update(ys.data(), size() - 1, size());
+    }
+
+    void ChartSeries::append(double y)
+    {
+        assert(xs.empty());
+        ys.push_back(y);
+        pyramid.update(ys.data(), size() - 1, size());
+    }
+
+    void ChartSeries::update(int32_t from)
+    {
+        pyramid.update(ys.data(), from, size());
+    }
+
+    void ChartSeries::clear()
+    {
+        xs.clear();
+        ys.clear();
+        pyramid.clear();
+    }
+
+    int32_t ChartSeries::lowerBound(double value) const
+    {
+        if (!xs.empty()) return (int32_t)(std::lower_bound(xs.begin(), xs.end(), value) - xs.begin());
+        auto idx = std::ceil((value - start) / step);
+        return (int32_t)std::clamp(idx, 0.0, (double)size());
+    }
+
+    int64_t ChartSeries::memory() const
+    {
+        return (int64_t)(xs.capacity() + ys.capacity()) * (int64_t)sizeof(double) + pyramid.memory();
+    }
+
+    // Both extremes of a pixel column are plotted at the same x, ordered to continue from the
+    // previous point so that lines of adjacent columns do not cross
+    static void AddColumnExtremes(double colx, double lo, double hi, std::vector<double>& outx, std::vector<double>& outy)
+    {
+        auto prev = outy.empty() ? lo : outy.back();
+        auto lofirst = std::abs(prev - lo) <= std::abs(prev - hi);
+        outx.push_back(colx);
+        outy.push_back(lofirst ? lo : hi);
+
+        if (lo != hi)
+        {
+            outx.push_back(colx);
+            outy.push_back(lofirst ? hi : lo);
+        }
+    }
+
+    // Reduce buckets of a pyramid level (raw points for level -1) in [first, last) to the
+    // minimum and maximum of each pixel column, placed at the x of first bucket in column
+    static void ReduceToColumns(const ChartSeries& series, int32_t level, int32_t first, int32_t last,
+        double from, double to, int32_t columns, std::vector<double>& outx, std::vector<double>& outy)
+    {
+        auto bucket = level < 0 ? 1 : series.pyramid.bucket(level);
+        auto scale = (double)columns / (to - from);
+        auto column = INT32_MIN;
+        double colx = 0.0, lo = 0.0, hi = 0.0;
+
+        auto flush = [&] {
+            if (column != INT32_MIN) AddColumnExtremes(colx, lo, hi, outx, outy);
+        };
+
+        for (auto bidx = first / bucket; bidx * bucket < last; ++bidx)
+        {
+            auto x = series.x(bidx * bucket);
+            auto current = (int32_t)std::floor((x - from) * scale);
+            auto bmin = level < 0 ? series.ys[bidx] : series.pyramid.min(level, bidx);
+            auto bmax = level < 0 ? series.ys[bidx] : series.pyramid.max(level, bidx);
+
+            if (current != column)
+            {
+                flush();
+                column = current;
+                colx = x;
+                lo = bmin;
+                hi = bmax;
+            }
+            else
+            {
+                lo = std::min(lo, bmin);
+                hi = std::max(hi, bmax);
+            }
+        }
+
+        flush();
+    }
+
+    // Largest-Triangle-Three-Buckets, done in place as a selected point is written at or
+    // before the first point of its bucket, which is never read again
+    static void LargestTriangleThreeBuckets(std::vector<double>& xs, std::vector<double>& ys, int32_t threshold)
+    {
+        auto count = (int32_t)xs.size();
+        if (threshold >= count || threshold < 3) return;
+
+        auto every = (double)(count - 2) / (double)(threshold - 2);
+        auto ax = xs[0], ay = ys[0];
+
+        for (auto bidx = 0; bidx < threshold - 2; ++bidx)
+        {
+            // Third vertex of the triangle is the average of next bucket
+            auto avgstart = (int32_t)((bidx + 1) * every) + 1;
+            auto avgend = std::max(std::min((int32_t)((bidx + 2) * every) + 1, count), std::min(avgstart + 1, count));
+            auto avgx = 0.0, avgy = 0.0;
+            for (auto idx = avgstart; idx < avgend; ++idx)
+            {
+                avgx += xs[idx];
+                avgy += ys[idx];
+            }
+            avgx /= (double)(avgend - avgstart);
+            avgy /= (double)(avgend - avgstart);
+
+            auto from = (int32_t)(bidx * every) + 1, to = (int32_t)((bidx + 1) * every) + 1;
+            auto selected = from;
+            auto maxarea = -1.0;
+
+            for (auto idx = from; idx < to; ++idx)
+            {
+                auto area = std::abs((ax - avgx) * (ys[idx] - ay) - (ax - xs[idx]) * (avgy - ay));
+                if (area > maxarea)
+                {
+                    maxarea = area;
+                    selected = idx;
+                }
+            }
+
+            ax = xs[selected];
+            ay = ys[selected];
+            xs[bidx + 1] = ax;
+            ys[bidx + 1] = ay;
+        }
+
+        xs[threshold - 1] = xs[count - 1];
+        ys[threshold - 1] = ys[count - 1];
+        xs.resize(threshold);
+        ys.resize(threshold);
+    }
+
+    void ChartSeries::decimate(double from, double to, int32_t pixels, std::vector<double>& outx, std::vector<double>& outy) const
+    {
+        assert(pyramid.size() == size());
+        outx.clear();
+        outy.clear();
+
+        auto count = size();
+        if (count == 0 || pixels <= 0 || to <= from) return;
+
+        // One point beyond either edge of view, so that the line reaches the edges
+        auto first = std::max(lowerBound(from) - 1, 0);
+        auto last = std::min(lowerBound(to) + 1, count);
+        auto visible = last - first;
+        auto columns = decimation == ChartDecimation::LTTB ? pixels * 2 : pixels;
+
+        if (decimation == ChartDecimation::None || visible <= columns * 2)
+        {
+            for (auto idx = first; idx < last; ++idx)
+            {
+                outx.push_back(x(idx));
+                outy.push_back(ys[idx]);
+            }
+            return;
+        }
+
+        // Coarsest level with at least one bucket per column, raw points if there is none
+        auto level = -1;
+        while (level + 1 < pyramid.levels() && visible / pyramid.bucket(level + 1) >= columns) ++level;
+        ReduceToColumns(*this, level, first, last, from, to, columns, outx, outy);
+        if (decimation == ChartDecimation::LTTB) LargestTriangleThreeBuckets(outx, outy, pixels);
+    }
+
+    ChartStream::ChartStream(int32_t capacity, int32_t pending)
+        : _pending{ pending }
+    {
+        assert(capacity > 0);
+        _xs.resize(capacity);
+        _ys.resize(capacity);
+    }
+
+    bool ChartStream::push(double x, double y)
+    {
+        auto sample = _pending.back();
+        if (sample == nullptr) return false;
+
+        sample->x = x;
+        sample->y = y;
+        _pending.push();
+        return true;
+    }
+
+    std::pair<int32_t, int32_t> ChartStream::consume()
+    {
+        auto appended = 0, discarded = 0;
+        const auto capacity = (int32_t)_ys.size();
+        const auto start = (_origin + _count) % capacity;
+
+        // Bounded by ring capacity as well, so that written slots form at most two runs
+        for (auto sample = _pending.front(); sample != nullptr && appended < _pending.capacity() &&
+            appended < capacity; sample = _pending.front())
+        {
+            auto slot = (_origin + _count) % capacity;
+            _xs[slot] = sample->x;
+            _ys[slot] = sample->y;
+            _pending.pop();
+
+            if (_count == capacity)
+            {
+                _origin = (_origin + 1) % capacity;
+                ++discarded;
+            }
+            else ++_count;
+
+            ++appended;
+        }
+
+        // Until the ring is full, slots [0, count) are in use
+        if (appended > 0)
+        {
+            auto end = start + appended;
+            _pyramid.update(_ys.data(), start, std::min(end, capacity), _count);
+            if (end > capacity) _pyramid.update(_ys.data(), 0, end - capacity, _count);
+        }
+
+        return { appended, discarded };
+    }
+
+    int32_t ChartStream::lowerBound(double value) const
+    {
+        int32_t lo = 0, hi = _count;
+
+        while (lo < hi)
+        {
+            auto mid = lo + (hi - lo) / 2;
+            if (x(mid) < value) lo = mid + 1;
+            else hi = mid;
+        }
+
+        return lo;
+    }
+
+    int64_t ChartStream::memory() const
+    {
+        return (int64_t)(_xs.capacity() + _ys.capacity() + 2 * _pending.capacity()) * (int64_t)sizeof(double) +
+            _pyramid.memory();
+    }
+
+    std::pair<double, double> ChartStream::_extent(int32_t from, int32_t to) const
+    {
+        const auto capacity = (int32_t)_ys.size();
+        auto start = (_origin + from) % capacity, end = start + (to - from);
+        if (end <= capacity) return _pyramid.range(_ys.data(), start, end);
+
+        auto head = _pyramid.range(_ys.data(), start, capacity);
+        auto tail = _pyramid.range(_ys.data(), 0, end - capacity);
+        return { std::min(head.first, tail.first), std::max(head.second, tail.second) };
+    }
+
+    void ChartStream::decimate(double from, double to, int32_t pixels, std::vector<double>& outx, std::vector<double>& outy) const
+    {
+        outx.clear();
+        outy.clear();
+        if (_count == 0 || pixels <= 0 || to <= from) return;
+
+        // One sample beyond either edge of view, so that the line reaches the edges
+        auto first = std::max(lowerBound(from) - 1, 0);
+        auto last = std::min(lowerBound(to) + 1, _count);
+        auto columns = decimation == ChartDecimation::LTTB ? pixels * 2 : pixels;
+
+        if (decimation == ChartDecimation::None || last - first <= columns * 2)
+        {
+            for (auto idx = first; idx < last; ++idx)
+            {
+                outx.push_back(x(idx));
+                outy.push_back(y(idx));
+            }
+            return;
+        }
+
+        // Samples of each column are found by binary search and reduced through the pyramid
+        auto width = (to - from) / (double)columns;
+        for (auto start = first; start < last;)
+        {
+            auto colx = x(start);
+            auto column = std::floor((colx - from) / width);
+            auto end = std::clamp(lowerBound(from + (column + 1.0) * width), start + 1, last);
+            auto [lo, hi] = _extent(start, end);
+            AddColumnExtremes(colx, lo, hi, outx, outy);
+            start = end;
+        }
+
+        if (decimation == ChartDecimation::LTTB) LargestTriangleThreeBuckets(outx, outy, pixels);
+    }
+
+    void PlotSeries(std::string_view label, const ChartSeries& series, int32_t flags)
+    {
+        auto limits = ImPlot::GetPlotLimits();
+        auto pixels = (int32_t)ImPlot::GetPlotSize().x;
+        series.decimate(limits.X.Min, limits.X.Max, pixels, ChartPointsX, ChartPointsY);
+        ImPlot::PlotLine(label.data(), ChartPointsX.data(), ChartPointsY.data(), (int)ChartPointsX.size(), flags);
+    }
+
+    // Axes are set up before ImPlot locks them on the first item or query of plot limits
+    void SetupPlotStream(ChartStream& stream, double window)
+    {
+        stream.consume();
+
+        if (window > 0.0 && stream.size() > 0)
+        {
+            auto latest = stream.x(stream.size() - 1);
+            ImPlot::SetupAxisLimits(ImAxis_X1, latest - window, latest, ImPlotCond_Always);
+        }
+    }
+
+    void PlotStream(std::string_view label, ChartStream& stream, int32_t flags)
+    {
+        stream.consume();
+        auto limits = ImPlot::GetPlotLimits();
+        auto pixels = (int32_t)ImPlot::GetPlotSize().x;
+        stream.decimate(limits.X.Min, limits.X.Max, pixels, ChartPointsX, ChartPointsY);
+        ImPlot::PlotLine(label.data(), ChartPointsX.data(), ChartPointsY.data(), (int)ChartPointsX.size(), flags);
+    }
+
 #pragma endregion
 #endif
 
@@ -8302,7 +11681,7 @@ namespace glimmer
         return Widget(id, WT_MediaResource, geometry, neighbors);
     }
 
-    WidgetDrawResult Icon(std::string_view id, int32_t rtype, IconSizingType sztype, std::string_view resource, int32_t geometry, const NeighborWidgets& neighbors)
+    WidgetDrawResult Icon(StringId id, int32_t rtype, IconSizingType sztype, std::string_view resource, int32_t geometry, const NeighborWidgets& neighbors)
     {
         assert((rtype & RT_PATH) != 0);
         auto wid = GetIdFromString(id, WT_MediaResource).first;
@@ -8344,7 +11723,7 @@ namespace glimmer
         return Widget(id, WT_MediaResource, geometry, neighbors);
     }
 
-    WidgetDrawResult Icon(std::string_view id, SymbolIcon icon, IconSizingType sztype, int32_t geometry, const NeighborWidgets& neighbors)
+    WidgetDrawResult Icon(StringId id, SymbolIcon icon, IconSizingType sztype, int32_t geometry, const NeighborWidgets& neighbors)
     {
         auto wid = GetIdFromString(id, WT_MediaResource).first;
         auto& context = GetContext();
@@ -8834,6 +12213,7 @@ namespace glimmer
                 auto& state = context.GetState(wid).state.input;
                 auto style = context.GetStyle(state.state, wid);
                 UpdateTooltip(state.tooltip);
+                auto height = state.isMultiline ? style.font.size * GLIMMER_MULTILINE_INPUT_ROWS : style.font.size;
 
                 if (nestedCtx.source == NestedContextSourceType::Layout && !context.layoutStack.empty())
                 {
@@ -8841,14 +12221,14 @@ namespace glimmer
                     auto pos = layout.nextpos;
                     if (geometry & ExpandH) layoutItem.sizing |= ExpandH;
                     if (geometry & ExpandV) layoutItem.sizing |= ExpandV;
-                    DetermineBounds({ style.dimension.x, style.font.size }, state.prefix, state.suffix, pos, layoutItem, style, renderer, geometry, neighbors);
+                    DetermineBounds({ style.dimension.x, height }, state.prefix, state.suffix, pos, layoutItem, style, renderer, geometry, neighbors);
                     if (onlyComputeGeometry) break;
                     AddItemToLayout(layout, layoutItem, style);
                 }
                 else
                 {
                     auto pos = context.NextAdHocPos();
-                    DetermineBounds({ style.dimension.x, style.font.size }, state.prefix, state.suffix, pos, layoutItem, style, renderer, geometry, neighbors);
+                    DetermineBounds({ style.dimension.x, height }, state.prefix, state.suffix, pos, layoutItem, style, renderer, geometry, neighbors);
                     if (onlyComputeGeometry) break;
                     renderer.SetClipRect(layoutItem.margin.Min, layoutItem.margin.Max);
                     result = TextInputImpl(wid, state, style, layoutItem.border, layoutItem.content, layoutItem.prefix, layoutItem.suffix, renderer, io);
@@ -11,6 +11,16 @@ namespace glimmer
     int32_t GetNextId(WidgetType type);
     int16_t GetNextCount(WidgetType type);
 
+    // Widget state is kept in slots which are reused once released, either explicitly or
+    // after GLIMMER_ID_RECLAIM_FRAMES frames of disuse for ids looked up by name or pointer
+    WidgetHandle GetWidgetHandle(int32_t id);
+    bool IsWidgetAlive(WidgetHandle handle);
+    bool ReleaseWidget(int32_t id);
+
+    // Memory held by states of a widget type, text input and item grid states are allocated
+    // when the widget is first drawn
+    WidgetMemoryUsage GetWidgetMemoryUsage(WidgetType type);
+
     WidgetConfigData& CreateWidgetConfig(WidgetType type, int16_t id);
     WidgetConfigData& CreateWidgetConfig(int32_t id);
     void SetTooltip(int32_t id, std::string_view tooltip);
@@ -20,96 +30,108 @@ namespace glimmer
 #if !defined(GLIMMER_DISABLE_SVG) || !defined(GLIMMER_DISABLE_IMAGES)
     WidgetDrawResult Icon(int32_t rtype, IconSizingType sztype, std::string_view resource, int32_t geometry = ToBottomRight, const NeighborWidgets& neighbors = NeighborWidgets{});
     WidgetDrawResult Icon(int32_t id, int32_t rtype, IconSizingType sztype, std::string_view resource, int32_t geometry = ToBottomRight, const NeighborWidgets& neighbors = NeighborWidgets{});
-    WidgetDrawResult Icon(std::string_view id, int32_t rtype, IconSizingType sztype, std::string_view resource, int32_t geometry = ToBottomRight, const NeighborWidgets& neighbors = NeighborWidgets{});
+    WidgetDrawResult Icon(StringId id, int32_t rtype, IconSizingType sztype, std::string_view resource, int32_t geometry = ToBottomRight, const NeighborWidgets& neighbors = NeighborWidgets{});
 #endif
 #ifdef GLIMMER_ENABLE_ICON_FONT
     WidgetDrawResult Icon(std::string_view resource, int32_t geometry = ToBottomRight, const NeighborWidgets& neighbors = NeighborWidgets{});
 #endif
     WidgetDrawResult Icon(int32_t id, SymbolIcon icon, IconSizingType sztype, int32_t geometry = ToBottomRight, const NeighborWidgets& neighbors = NeighborWidgets{});
-    WidgetDrawResult Icon(std::string_view id, SymbolIcon icon, IconSizingType sztype, int32_t geometry = ToBottomRight, const NeighborWidgets& neighbors = NeighborWidgets{});
+    WidgetDrawResult Icon(StringId id, SymbolIcon icon, IconSizingType sztype, int32_t geometry = ToBottomRight, const NeighborWidgets& neighbors = NeighborWidgets{});
 
     void BeginFlexRegion(int32_t id, Direction dir, ImVec2 spacing = { 0.f, 0.f }, bool wrap = true, int32_t events = 0, ImVec2 size = { -1.f, -1.f }, int32_t geometry = ToBottomRight, const NeighborWidgets & neighbors = NeighborWidgets{});
-    void BeginFlexRegion(std::string_view id, Direction dir, ImVec2 spacing = { 0.f, 0.f }, bool wrap = true, int32_t events = 0, ImVec2 size = { -1.f, -1.f }, int32_t geometry = ToBottomRight, const NeighborWidgets& neighbors = NeighborWidgets{});
+    void BeginFlexRegion(StringId id, Direction dir, ImVec2 spacing = { 0.f, 0.f }, bool wrap = true, int32_t events = 0, ImVec2 size = { -1.f, -1.f }, int32_t geometry = ToBottomRight, const NeighborWidgets& neighbors = NeighborWidgets{});
     void BeginGridRegion(int32_t id, int rows, int cols, ImVec2 spacing = { 0.f, 0.f }, int32_t events = 0, ImVec2 size = { -1.f, -1.f }, int32_t geometry = ToBottomRight, const NeighborWidgets& neighbors = NeighborWidgets{});
-    void BeginGridRegion(std::string_view id, int rows, int cols, ImVec2 spacing = { 0.f, 0.f }, int32_t events = 0, ImVec2 size = { -1.f, -1.f }, int32_t geometry = ToBottomRight, const NeighborWidgets& neighbors = NeighborWidgets{});
+    void BeginGridRegion(StringId id, int rows, int cols, ImVec2 spacing = { 0.f, 0.f }, int32_t events = 0, ImVec2 size = { -1.f, -1.f }, int32_t geometry = ToBottomRight, const NeighborWidgets& neighbors = NeighborWidgets{});
     WidgetDrawResult EndRegion();
 
     WidgetDrawResult Label(int32_t id, int32_t geometry = ToBottomRight, const NeighborWidgets& neighbors = NeighborWidgets{});
-    WidgetDrawResult Label(std::string_view id, std::string_view content, int32_t geometry = ToBottomRight, const NeighborWidgets& neighbors = NeighborWidgets{});
-    WidgetDrawResult Label(std::string_view id, std::string_view content, TextType type, int32_t geometry = ToBottomRight, const NeighborWidgets& neighbors = NeighborWidgets{});
-    WidgetDrawResult Label(std::string_view id, std::string_view content, std::string_view tooltip, int32_t geometry = ToBottomRight, const NeighborWidgets& neighbors = NeighborWidgets{});
+    WidgetDrawResult Label(StringId id, std::string_view content, int32_t geometry = ToBottomRight, const NeighborWidgets& neighbors = NeighborWidgets{});
+    WidgetDrawResult Label(StringId id, std::string_view content, TextType type, int32_t geometry = ToBottomRight, const NeighborWidgets& neighbors = NeighborWidgets{});
+    WidgetDrawResult Label(StringId id, std::string_view content, std::string_view tooltip, int32_t geometry = ToBottomRight, const NeighborWidgets& neighbors = NeighborWidgets{});
     
     WidgetDrawResult Button(int32_t id, int32_t geometry = ToBottomRight, const NeighborWidgets& neighbors = NeighborWidgets{});
-    WidgetDrawResult Button(std::string_view id, std::string_view content, int32_t geometry = ToBottomRight, const NeighborWidgets& neighbors = NeighborWidgets{});
-    void BeginButton(std::string_view id, int32_t geometry = ToBottomRight, const NeighborWidgets& neighbors = NeighborWidgets{});
+    WidgetDrawResult Button(StringId id, std::string_view content, int32_t geometry = ToBottomRight, const NeighborWidgets& neighbors = NeighborWidgets{});
+    void BeginButton(StringId id, int32_t geometry = ToBottomRight, const NeighborWidgets& neighbors = NeighborWidgets{});
     WidgetDrawResult EndButton();
     
     WidgetDrawResult ToggleButton(int32_t id, int32_t geometry = ToBottomRight, const NeighborWidgets& neighbors = NeighborWidgets{});
     WidgetDrawResult ToggleButton(bool* state, int32_t geometry = ToBottomRight, const NeighborWidgets& neighbors = NeighborWidgets{});
-    WidgetDrawResult ToggleButton(std::string_view id, bool* state, int32_t geometry = ToBottomRight, const NeighborWidgets& neighbors = NeighborWidgets{});
+    WidgetDrawResult ToggleButton(StringId id, bool* state, int32_t geometry = ToBottomRight, const NeighborWidgets& neighbors = NeighborWidgets{});
 
     WidgetDrawResult RadioButton(int32_t id, int32_t geometry = ToBottomRight, const NeighborWidgets& neighbors = NeighborWidgets{});
     WidgetDrawResult RadioButton(bool* state, int32_t geometry = ToBottomRight, const NeighborWidgets& neighbors = NeighborWidgets{});
-    WidgetDrawResult RadioButton(std::string_view id, bool* state, int32_t geometry = ToBottomRight, const NeighborWidgets& neighbors = NeighborWidgets{});
+    WidgetDrawResult RadioButton(StringId id, bool* state, int32_t geometry = ToBottomRight, const NeighborWidgets& neighbors = NeighborWidgets{});
 
     WidgetDrawResult Checkbox(int32_t id, int32_t geometry = ToBottomRight, const NeighborWidgets& neighbors = NeighborWidgets{});
     WidgetDrawResult Checkbox(CheckState* state, int32_t geometry = ToBottomRight, const NeighborWidgets& neighbors = NeighborWidgets{});
-    WidgetDrawResult Checkbox(std::string_view id, CheckState* state, int32_t geometry = ToBottomRight, const NeighborWidgets& neighbors = NeighborWidgets{});
+    WidgetDrawResult Checkbox(StringId id, CheckState* state, int32_t geometry = ToBottomRight, const NeighborWidgets& neighbors = NeighborWidgets{});
 
     WidgetDrawResult Spinner(int32_t id, int32_t geometry = ToBottomRight, const NeighborWidgets& neighbors = NeighborWidgets{});
     WidgetDrawResult Spinner(int32_t* value, int32_t step, std::pair<int32_t, int32_t> range, int32_t geometry = ToBottomRight, const NeighborWidgets& neighbors = NeighborWidgets{});
-    WidgetDrawResult Spinner(std::string_view id, int32_t* value, int32_t step, std::pair<int32_t, int32_t> range, int32_t geometry = ToBottomRight, const NeighborWidgets& neighbors = NeighborWidgets{});
+    WidgetDrawResult Spinner(StringId id, int32_t* value, int32_t step, std::pair<int32_t, int32_t> range, int32_t geometry = ToBottomRight, const NeighborWidgets& neighbors = NeighborWidgets{});
     WidgetDrawResult Spinner(float* value, float step, std::pair<float, float> range, int32_t geometry = ToBottomRight, const NeighborWidgets& neighbors = NeighborWidgets{});
-    WidgetDrawResult Spinner(std::string_view id, float* value, float step, std::pair<float, float> range, int32_t geometry = ToBottomRight, const NeighborWidgets& neighbors = NeighborWidgets{});
+    WidgetDrawResult Spinner(StringId id, float* value, float step, std::pair<float, float> range, int32_t geometry = ToBottomRight, const NeighborWidgets& neighbors = NeighborWidgets{});
     WidgetDrawResult Spinner(double* value, float step, std::pair<float, float> range, int32_t geometry = ToBottomRight, const NeighborWidgets& neighbors = NeighborWidgets{});
-    WidgetDrawResult Spinner(std::string_view id, double* value, float step, std::pair<float, float> range, int32_t geometry = ToBottomRight, const NeighborWidgets& neighbors = NeighborWidgets{});
+    WidgetDrawResult Spinner(StringId id, double* value, float step, std::pair<float, float> range, int32_t geometry = ToBottomRight, const NeighborWidgets& neighbors = NeighborWidgets{});
 
     WidgetDrawResult Slider(int32_t id, int32_t geometry = ToBottomRight, const NeighborWidgets& neighbors = NeighborWidgets{});
     WidgetDrawResult Slider(int32_t* value, std::pair<int32_t, int32_t> range, int32_t geometry = ToBottomRight, const NeighborWidgets& neighbors = NeighborWidgets{});
-    WidgetDrawResult Slider(std::string_view id, int32_t* value, std::pair<int32_t, int32_t> range, int32_t geometry = ToBottomRight, const NeighborWidgets& neighbors = NeighborWidgets{});
+    WidgetDrawResult Slider(StringId id, int32_t* value, std::pair<int32_t, int32_t> range, int32_t geometry = ToBottomRight, const NeighborWidgets& neighbors = NeighborWidgets{});
     WidgetDrawResult Slider(float* value, std::pair<float, float> range, int32_t geometry = ToBottomRight, const NeighborWidgets& neighbors = NeighborWidgets{});
-    WidgetDrawResult Slider(std::string_view id, float* value, std::pair<float, float> range, int32_t geometry = ToBottomRight, const NeighborWidgets& neighbors = NeighborWidgets{});
+    WidgetDrawResult Slider(StringId id, float* value, std::pair<float, float> range, int32_t geometry = ToBottomRight, const NeighborWidgets& neighbors = NeighborWidgets{});
     WidgetDrawResult Slider(double* value, std::pair<float, float> range, int32_t geometry = ToBottomRight, const NeighborWidgets& neighbors = NeighborWidgets{});
-    WidgetDrawResult Slider(std::string_view id, double* value, std::pair<float, float> range, int32_t geometry = ToBottomRight, const NeighborWidgets& neighbors = NeighborWidgets{});
+    WidgetDrawResult Slider(StringId id, double* value, std::pair<float, float> range, int32_t geometry = ToBottomRight, const NeighborWidgets& neighbors = NeighborWidgets{});
 
     WidgetDrawResult RangeSlider(int32_t id, int32_t geometry = ToBottomRight, const NeighborWidgets& neighbors = NeighborWidgets{});
     WidgetDrawResult RangeSlider(int32_t* min_val, int32_t* max_val, std::pair<int32_t, int32_t> range, int32_t geometry = ToBottomRight, const NeighborWidgets& neighbors = NeighborWidgets{});
-    WidgetDrawResult RangeSlider(std::string_view id, int32_t* min_val, int32_t* max_val, std::pair<int32_t, int32_t> range, int32_t geometry = ToBottomRight, const NeighborWidgets& neighbors = NeighborWidgets{});
+    WidgetDrawResult RangeSlider(StringId id, int32_t* min_val, int32_t* max_val, std::pair<int32_t, int32_t> range, int32_t geometry = ToBottomRight, const NeighborWidgets& neighbors = NeighborWidgets{});
     WidgetDrawResult RangeSlider(float* min_val, float* max_val, std::pair<float, float> range, int32_t geometry = ToBottomRight, const NeighborWidgets& neighbors = NeighborWidgets{});
-    WidgetDrawResult RangeSlider(std::string_view id, float* min_val, float* max_val, std::pair<float, float> range, int32_t geometry = ToBottomRight, const NeighborWidgets& neighbors = NeighborWidgets{});
+    WidgetDrawResult RangeSlider(StringId id, float* min_val, float* max_val, std::pair<float, float> range, int32_t geometry = ToBottomRight, const NeighborWidgets& neighbors = NeighborWidgets{});
     WidgetDrawResult RangeSlider(double* min_val, double* max_val, std::pair<float, float> range, int32_t geometry = ToBottomRight, const NeighborWidgets& neighbors = NeighborWidgets{});
-    WidgetDrawResult RangeSlider(std::string_view id, double* min_val, double* max_val, std::pair<float, float> range, int32_t geometry = ToBottomRight, const NeighborWidgets& neighbors = NeighborWidgets{});
+    WidgetDrawResult RangeSlider(StringId id, double* min_val, double* max_val, std::pair<float, float> range, int32_t geometry = ToBottomRight, const NeighborWidgets& neighbors = NeighborWidgets{});
 
+    // Text is owned by the widget, out is read when the input is created and written back NUL terminated
+    // (limited to size - 1 characters) after it loses focus. Use Get/SetTextInputText to access the text
+    // while it is being edited or to change it afterwards.
     WidgetDrawResult TextInput(int32_t id, int32_t geometry = ToBottomRight, const NeighborWidgets& neighbors = NeighborWidgets{});
     WidgetDrawResult TextInput(char* out, int size, std::string_view placeholder, int32_t geometry = ToBottomRight, const NeighborWidgets& neighbors = NeighborWidgets{});
-    WidgetDrawResult TextInput(std::string_view id, char* out, int size, std::string_view placeholder, int32_t geometry = ToBottomRight, const NeighborWidgets& neighbors = NeighborWidgets{});
+    WidgetDrawResult TextInput(StringId id, char* out, int size, std::string_view placeholder, int32_t geometry = ToBottomRight, const NeighborWidgets& neighbors = NeighborWidgets{});
     WidgetDrawResult TextInput(char* out, int size, int strlen, std::string_view placeholder, int32_t geometry = ToBottomRight, const NeighborWidgets& neighbors = NeighborWidgets{});
-    WidgetDrawResult TextInput(std::string_view id, char* out, int size, int strlen, std::string_view placeholder, int32_t geometry = ToBottomRight, const NeighborWidgets& neighbors = NeighborWidgets{});
+    WidgetDrawResult TextInput(StringId id, char* out, int size, int strlen, std::string_view placeholder, int32_t geometry = ToBottomRight, const NeighborWidgets& neighbors = NeighborWidgets{});
     template <size_t sz>
     WidgetDrawResult TextInput(char (&out)[sz], std::string_view placeholder, int32_t geometry = ToBottomRight, const NeighborWidgets& neighbors = NeighborWidgets{})
     {
         return TextInput(out, sz, placeholder, geometry, neighbors);
     }
     template <size_t sz>
-    WidgetDrawResult TextInput(std::string_view id, char(&out)[sz], std::string_view placeholder, int32_t geometry = ToBottomRight, const NeighborWidgets& neighbors = NeighborWidgets{})
+    WidgetDrawResult TextInput(StringId id, char(&out)[sz], std::string_view placeholder, int32_t geometry = ToBottomRight, const NeighborWidgets& neighbors = NeighborWidgets{})
     {
-        return TextInput(id, out, placeholder, geometry, neighbors);
+        return TextInput(id, out, sz, placeholder, geometry, neighbors);
     }
 
+    // Multi-line text input, edits and drawing cost depend on visible lines and not on text size.
+    // out is handled as for TextInput
+    WidgetDrawResult TextEditor(char* out, int size, bool wrapLines = false, int32_t geometry = ToBottomRight, const NeighborWidgets& neighbors = NeighborWidgets{});
+    WidgetDrawResult TextEditor(StringId id, char* out, int size, bool wrapLines = false, int32_t geometry = ToBottomRight, const NeighborWidgets& neighbors = NeighborWidgets{});
+    std::string_view GetTextInputText(int32_t id);
+    std::string_view GetTextInputText(StringId id);
+    void SetTextInputText(int32_t id, std::string_view text);
+    void SetTextInputText(StringId id, std::string_view text);
+
     bool BeginDropDown(int32_t id, std::string_view text, TextType type = TextType::PlainText, int32_t spolicy = DD_FitToLongestOption, int32_t geometry = ToBottomRight, const NeighborWidgets& neighbors = NeighborWidgets{});
-    bool BeginDropDown(std::string_view id, std::string_view text, TextType type = TextType::PlainText, int32_t spolicy = DD_FitToLongestOption, int32_t geometry = ToBottomRight, const NeighborWidgets& neighbors = NeighborWidgets{});
-    void BeginDropDownOption(std::string_view optionText, TextType type = TextType::PlainText, bool isLongestOption = false);
+    bool BeginDropDown(StringId id, std::string_view text, TextType type = TextType::PlainText, int32_t spolicy = DD_FitToLongestOption, int32_t geometry = ToBottomRight, const NeighborWidgets& neighbors = NeighborWidgets{});
+    bool BeginDropDownOption(std::string_view optionText, TextType type = TextType::PlainText, bool isLongestOption = false);
     void AddDropDownOption(std::string_view optionText, TextType type = TextType::PlainText, bool isLongestOption = false);
 	void EndDropDownOption();
     WidgetDrawResult EndDropDown(int32_t* selection, std::optional<std::pair<std::string_view, TextType>> longestopt = std::nullopt);
 
     WidgetDrawResult StaticItemGrid(int32_t id, int32_t geometry = ToBottomRight, const NeighborWidgets& neighbors = NeighborWidgets{});
-    WidgetDrawResult StaticItemGrid(std::string_view id, const std::initializer_list<std::string_view>& headers, std::pair<std::string_view, TextType>(*cell)(int32_t, int16_t), 
+    WidgetDrawResult StaticItemGrid(StringId id, const std::initializer_list<std::string_view>& headers, std::pair<std::string_view, TextType>(*cell)(int32_t, int16_t), 
         int32_t totalRows, int32_t geometry = ToBottomRight, const NeighborWidgets& neighbors = NeighborWidgets{});
 
     void BeginSplitRegion(int32_t id, Direction dir, const std::initializer_list<SplitRegion>& splits,
         int32_t geometry = ToBottomRight, const NeighborWidgets& neighbors = NeighborWidgets{});
-    void BeginSplitRegion(std::string_view id, Direction dir, const std::initializer_list<SplitRegion>& splits,
+    void BeginSplitRegion(StringId id, Direction dir, const std::initializer_list<SplitRegion>& splits,
         int32_t geometry = ToBottomRight, const NeighborWidgets& neighbors = NeighborWidgets{});
     void NextSplitRegion();
     void EndSplitRegion();
@@ -121,7 +143,7 @@ namespace glimmer
 
     void BeginScrollableRegion(int32_t id, int32_t flags, int32_t geometry = ToBottomRight, 
         const NeighborWidgets& neighbors = NeighborWidgets{}, ImVec2 maxsz = { FLT_MAX, FLT_MAX });
-    void BeginScrollableRegion(std::string_view id, int32_t flags, int32_t geometry = ToBottomRight,
+    void BeginScrollableRegion(StringId id, int32_t flags, int32_t geometry = ToBottomRight,
         const NeighborWidgets& neighbors = NeighborWidgets{}, ImVec2 maxsz = { FLT_MAX, FLT_MAX });
     ImRect EndScrollableRegion();
 
@@ -134,20 +156,20 @@ namespace glimmer
     WidgetDrawResult EndContextMenu();
 
     bool BeginTabBar(int32_t id, int32_t geometry = ToBottomRight, const NeighborWidgets& neighbors = NeighborWidgets{});
-    bool BeginTabBar(std::string_view id, int32_t geometry = ToBottomRight, const NeighborWidgets& neighbors = NeighborWidgets{});
+    bool BeginTabBar(StringId id, int32_t geometry = ToBottomRight, const NeighborWidgets& neighbors = NeighborWidgets{});
     void AddTab(std::string_view name, std::string_view tooltip = "", int32_t flags = 0);
     void AddTab(int32_t resflags, std::string_view icon, TextType extype, std::string_view text, int32_t flags = 0, ImVec2 iconsz = {});
     void AddTab(int32_t resflags, std::string_view icon, int32_t flags = 0, ImVec2 iconsz = {});
     WidgetDrawResult EndTabBar(int32_t* tabidx, std::optional<bool> canAddTab = std::nullopt);
 
     bool BeginNavDrawer(int32_t id, bool expandable, Direction dir = DIR_Vertical, int32_t geometry = ToBottomRight, const NeighborWidgets& neighbors = NeighborWidgets{});
-    bool BeginNavDrawer(std::string_view id, bool expandable, Direction dir = DIR_Vertical, int32_t geometry = ToBottomRight, const NeighborWidgets& neighbors = NeighborWidgets{});
+    bool BeginNavDrawer(StringId id, bool expandable, Direction dir = DIR_Vertical, int32_t geometry = ToBottomRight, const NeighborWidgets& neighbors = NeighborWidgets{});
     void AddNavDrawerEntry(int32_t resflags, std::string_view icon, TextType textype, std::string_view text, bool atStart = true, float iconFontSzRatio = 1.f);
     void AddNavDrawerEntry(int32_t resflags, std::string_view icon, std::string_view text, bool atStart = true, float iconFontSzRatio = 1.f);
     WidgetDrawResult EndNavDrawer(int32_t* index);
 
     bool BeginAccordion(int32_t id, int32_t geometry = ToBottomRight, const NeighborWidgets& neighbors = NeighborWidgets{});
-    bool BeginAccordion(std::string_view id, int32_t geometry = ToBottomRight, const NeighborWidgets& neighbors = NeighborWidgets{});
+    bool BeginAccordion(StringId id, int32_t geometry = ToBottomRight, const NeighborWidgets& neighbors = NeighborWidgets{});
     bool BeginAccordionHeader();
     void AddAccordionHeaderExpandedIcon(int32_t resflags, std::string_view res);
     void AddAccordionHeaderCollapsedIcon(int32_t resflags, std::string_view res);
@@ -158,11 +180,21 @@ namespace glimmer
     WidgetDrawResult EndAccordion();
 
     bool BeginItemGrid(int32_t id, int32_t geometry = ToBottomRight, const NeighborWidgets& neighbors = NeighborWidgets{});
-    bool BeginItemGrid(std::string_view id, int32_t geometry = ToBottomRight, const NeighborWidgets& neighbors = NeighborWidgets{});
+    bool BeginItemGrid(StringId id, int32_t geometry = ToBottomRight, const NeighborWidgets& neighbors = NeighborWidgets{});
     void SetItemGridBehavior(int16_t sortedcol, int32_t highlights, int32_t selection, int32_t scrollprops,
         bool uniformRowHeights = true, bool isTree = false);
     void SetItemGridProviders(ItemGridConfig::CellPropertiesProviderT cellprops, ItemGridConfig::CellWidgetProviderT cellwidget,
         ItemGridConfig::CellContentProviderT cellcontent, ItemGridConfig::HeaderProviderT header);
+    void SetItemGridSortKeyProvider(ItemGridConfig::SortKeyProviderT sortkey);
+    void InvalidateItemGridSort(int32_t id);
+    void InvalidateItemGridSort(StringId id);
+    void SetItemGridFilterProvider(ItemGridConfig::FilterTextProviderT filtertext);
+    void InvalidateItemGridFilter(int32_t id);
+    void InvalidateItemGridFilter(StringId id);
+    void SetItemGridDataSource(const ItemGridDataSource& source);
+    void SetItemGridTreeModel(const ItemGridTreeModel& model);
+    void SetItemGridTreeChildren(int32_t id, int32_t node, std::span<const int32_t> children);
+    void SetItemGridStream(ItemGridStream* stream);
     bool BeginItemGridHeader(int levels = 1);
     void AddHeaderColumn(const ItemGridConfig::ColumnConfig& config);
     void CategorizeColumns();
@@ -171,11 +203,31 @@ namespace glimmer
     WidgetDrawResult AddFilterRow();
     void PopulateItemGrid(int totalRows, ItemGridPopulateMethod method = ItemGridPopulateMethod::ByRows);
     void AddEpilogueRows(int count, const ItemGridConfig::EpilogueRowProviders& providers);
+    // value is invoked from worker threads while aggregates of large grids are rebuilt, hence it has to be
+    // thread-safe. format takes a single double conversion (e.g. "%.2f"), else "%g" is used.
+    void SetItemGridAggregates(std::span<const ItemGridAggregate> columns, ItemGridConfig::AggregateValueProviderT value = nullptr,
+        std::string_view format = "%g");
+    void InvalidateItemGridAggregates(int32_t id);
+    void InvalidateItemGridAggregates(int32_t id, int32_t row);
+    void ExportItemGrid(int32_t id, const ItemGridExportOptions& options);
+    void ExportItemGrid(StringId id, const ItemGridExportOptions& options);
     WidgetDrawResult EndItemGrid();
+    ItemGridSelection& GetItemGridSelection(int32_t id);
+    ItemGridSelection& GetItemGridSelection(StringId id);
 
 #ifndef GLIMMER_DISABLE_PLOTS
     bool BeginPlot(std::string_view id, ImVec2 size = { FLT_MAX, FLT_MAX }, int32_t flags = 0);
     WidgetDrawResult EndPlot();
+
+    // Plot a line of series between BeginPlot/EndPlot, decimated to the plot's pixel width
+    void PlotSeries(std::string_view label, const ChartSeries& series, int32_t flags = 0);
+
+    // Follow the latest samples of stream, showing a window span of x values. It sets up the x axis,
+    // hence it has to be called right after BeginPlot, before any item of the plot.
+    void SetupPlotStream(ChartStream& stream, double window);
+
+    // Plot a line of streamed samples between BeginPlot/EndPlot, decimated to the plot's pixel width
+    void PlotStream(std::string_view label, ChartStream& stream, int32_t flags = 0);
 #endif
 
     struct ICustomWidget
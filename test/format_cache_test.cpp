@@ -0,0 +1,91 @@
+#include "../src/utils.h"
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Self-checking test for formatted cell text of ItemGrid's data source: text handed out during a
+// frame is drawn at the end of it, so it must stay intact while the rest of the window is
+// formatted, even when sorting brings rows which share a cache slot into the same window.
+
+using namespace glimmer;
+
+constexpr int32_t CacheRows = 256;
+constexpr int32_t TotalRows = 4 * CacheRows;
+constexpr int32_t WindowRows = 48;
+
+static int32_t Formatted = 0;
+
+static std::string Expected(int32_t row)
+{
+    return "row-" + std::to_string(row);
+}
+
+// Format all rows of the visible window [first, first + WindowRows) in display order, then
+// check the text of every one of them, as the deferred renderer reads it after population
+static bool RunFrame(FormattedTextCache<16>& cache, const std::vector<int32_t>& order, int32_t first, int32_t frame)
+{
+    std::vector<std::string_view> texts;
+    for (auto pos = first; pos < first + WindowRows; ++pos)
+    {
+        auto row = order[pos];
+        texts.push_back(cache.get(row, 0, 1u, frame, [row](char* buffer, int32_t size) {
+            ++Formatted;
+            return (size_t)std::snprintf(buffer, size, "row-%d", row);
+        }));
+    }
+
+    for (auto pos = first; pos < first + WindowRows; ++pos)
+    {
+        if (texts[pos - first] != Expected(order[pos]))
+        {
+            std::fprintf(stderr, "FAILED: frame %d shows '%.*s' for data row %d\n", frame,
+                (int)texts[pos - first].size(), texts[pos - first].data(), order[pos]);
+            return false;
+        }
+    }
+
+    FrameMemory.reset();
+    return true;
+}
+
+int main()
+{
+    FormattedTextCache<16> cache;
+    cache.reset(CacheRows, 1);
+
+    // Sorted order interleaves rows which are congruent modulo the cache size i.e. 0, 256, 512,
+    // 768, 1, 257, ... so that every visible row shares its slot with three others
+    std::vector<int32_t> sorted(TotalRows);
+    for (auto pos = 0; pos < TotalRows; ++pos)
+        sorted[pos] = (pos % 4) * CacheRows + pos / 4;
+
+    // Filtered rows keep data order, the window shows rows 0-23 followed by rows 256-279
+    std::vector<int32_t> filtered;
+    for (auto row = 0; row < TotalRows; ++row)
+        if (row % CacheRows < WindowRows / 2) filtered.push_back(row);
+
+    auto frame = 0;
+    for (auto first = 0; first + WindowRows <= TotalRows; first += 7, ++frame)
+        if (!RunFrame(cache, sorted, first, frame)) return 1;
+
+    for (auto repeat = 0; repeat < 4; ++repeat, ++frame)
+        if (!RunFrame(cache, filtered, 0, frame)) return 1;
+
+    // Without reordering, a window which was shown already is served from the cache
+    std::vector<int32_t> natural(TotalRows);
+    for (auto row = 0; row < TotalRows; ++row) natural[row] = row;
+
+    if (!RunFrame(cache, natural, 100, frame++)) return 1;
+    Formatted = 0;
+    if (!RunFrame(cache, natural, 100, frame++)) return 1;
+
+    if (Formatted != 0)
+    {
+        std::fprintf(stderr, "FAILED: %d cells formatted again for an unchanged window\n", (int)Formatted);
+        return 1;
+    }
+
+    std::printf("PASSED: formatted text stays intact for sorted and filtered windows\n");
+    return 0;
+}
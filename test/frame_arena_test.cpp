@@ -0,0 +1,83 @@
+#include "../src/context.h"
+
+#include <cstdio>
+
+// Self-checking test for frame allocated containers: once the frame arena has grown to the
+// largest frame seen, building and replaying a frame must not allocate from the heap.
+
+using namespace glimmer;
+
+using LayoutItems = decltype(WidgetContextData::layoutItems);
+using ReplayContent = decltype(WidgetContextData::replayContent);
+
+static int32_t HeapAllocations = 0;
+static void* (*DefaultAllocate)(size_t amount) = nullptr;
+static void* (*DefaultReallocate)(void* ptr, size_t amount) = nullptr;
+
+static void* CountingAllocate(size_t amount)
+{
+    ++HeapAllocations;
+    return DefaultAllocate(amount);
+}
+
+static void* CountingReallocate(void* ptr, size_t amount)
+{
+    ++HeapAllocations;
+    return DefaultReallocate(ptr, amount);
+}
+
+// Same sequence as a frame: items are added while widgets are laid out, replay content is
+// recorded alongside, and ResetFrameData releases both before resetting the arena
+static void RunFrame(LayoutItems& layoutItems, ReplayContent& replayContent, int16_t count)
+{
+    for (int16_t idx = 0; idx < count; ++idx)
+    {
+        LayoutItemDescriptor item;
+        item.wtype = WT_Label;
+        item.id = idx;
+        layoutItems.emplace_back(item);
+        replayContent.emplace_back((int64_t)idx, idx % 2 == 0 ? LayoutOps::PushStyle : LayoutOps::PopStyle);
+    }
+
+    layoutItems.release();
+    replayContent.release();
+    FrameMemory.reset();
+}
+
+int main()
+{
+    DefaultAllocate = AllocateFunc;
+    DefaultReallocate = ReallocateFunc;
+    AllocateFunc = &CountingAllocate;
+    ReallocateFunc = &CountingReallocate;
+
+    LayoutItems layoutItems{ false };
+    ReplayContent replayContent{ false };
+    constexpr int16_t MaxItems = 8192;
+
+    // Growing frames make the arena allocate blocks, which are coalesced on reset
+    for (int16_t count = 16; count <= MaxItems; count *= 2)
+        RunFrame(layoutItems, replayContent, count);
+
+    auto warmup = HeapAllocations;
+    HeapAllocations = 0;
+
+    for (auto frame = 0; frame < 1000; ++frame)
+    {
+        auto count = (int16_t)(MaxItems - ((frame * 397) % MaxItems));
+        RunFrame(layoutItems, replayContent, count);
+
+        if (HeapAllocations != 0)
+        {
+            std::fprintf(stderr, "FAILED: frame %d with %d items made %d heap allocation(s)\n",
+                frame, (int)count, (int)HeapAllocations);
+            return 1;
+        }
+    }
+
+    AllocateFunc = DefaultAllocate;
+    ReallocateFunc = DefaultReallocate;
+    std::printf("PASSED: %d heap allocation(s) during warm-up, none in 1000 steady-state frames "
+        "(arena peak: %zu bytes)\n", (int)warmup, FrameMemory.peakBytes);
+    return 0;
+}
@@ -0,0 +1,120 @@
+#include "../src/context.h"
+#include "../src/renderer.h"
+#include "../src/layout.h"
+#include "../src/widgets.h"
+
+#include <cstdio>
+
+// Self-checking test for whole frames: once the first frames have sized the frame arena and
+// widget states, a frame built with nested layouts and replayed by EndLayout must not allocate
+// from the heap. Frames go through IPlatform::EnterFrame/ExitFrame, which run BeginFrame
+// (InitFrameData) and ResetFrameData, and are drawn with the SVG renderer so that no window
+// or GPU is needed.
+
+using namespace glimmer;
+
+static int32_t HeapAllocations = 0;
+static void* (*DefaultAllocate)(size_t amount) = nullptr;
+static void* (*DefaultReallocate)(void* ptr, size_t amount) = nullptr;
+
+static void* CountingAllocate(size_t amount)
+{
+    ++HeapAllocations;
+    return DefaultAllocate(amount);
+}
+
+static void* CountingReallocate(void* ptr, size_t amount)
+{
+    ++HeapAllocations;
+    return DefaultReallocate(ptr, amount);
+}
+
+// Monospace text extents, fonts are not loaded
+static ImVec2 MeasureText(std::string_view text, void*, float sz, float)
+{
+    return ImVec2{ (float)text.size() * sz * 0.5f, sz };
+}
+
+// Platform without a window, frames are run one at a time by the test
+struct HeadlessPlatform final : public IPlatform
+{
+    void PopulateIODescriptor(const CustomEventData& custom) override
+    {
+        desc.deltaTime = 1.f / 60.f;
+        desc.mousepos = ImVec2{ -1.f, -1.f };
+        desc.custom = custom;
+        totalTime += desc.deltaTime;
+    }
+
+    void SetClipboardText(std::string_view) override {}
+    std::string_view GetClipboardText() override { return {}; }
+    bool CreateWindow(const WindowParams&) override { return true; }
+    bool PollEvents(bool (*)(ImVec2, IPlatform&, void*), void*) override { return true; }
+    ImTextureID UploadTexturesToGPU(ImVec2, unsigned char*) override { return ImTextureID{}; }
+
+    template <typename BuildT>
+    void RunFrame(BuildT build)
+    {
+        if (EnterFrame(Size.x, Size.y, CustomEventData{})) build();
+        ExitFrame();
+    }
+
+    static constexpr ImVec2 Size{ 1280.f, 800.f };
+};
+
+// Rows of labels and buttons in nested flex layouts, the row count changes between frames so
+// that layout builders and replay buffers are filled to different sizes
+static void BuildFrame(int32_t rows)
+{
+    static char text[64];
+
+    BeginFlexLayout(DIR_Vertical, ExpandAll);
+    for (auto row = 0; row < rows; ++row)
+    {
+        BeginFlexLayout(DIR_Horizontal, ExpandH);
+        auto sz = std::snprintf(text, sizeof(text), "label-%d", row);
+        Label(std::string_view{ text, (size_t)sz }, "Label");
+        sz = std::snprintf(text, sizeof(text), "button-%d", row);
+        Button(std::string_view{ text, (size_t)sz }, "Button");
+        EndLayout();
+    }
+    EndLayout();
+}
+
+int main()
+{
+    HeadlessPlatform platform;
+    Config.platform = &platform;
+    Config.renderer = CreateSVGRenderer(&MeasureText, HeadlessPlatform::Size);
+    PushContext(-1);
+
+    constexpr int32_t MaxRows = 128;
+
+    // Largest frame first, so that every widget has its state and every container its capacity
+    for (auto frame = 0; frame < 4; ++frame)
+        platform.RunFrame([] { BuildFrame(MaxRows); });
+
+    DefaultAllocate = AllocateFunc;
+    DefaultReallocate = ReallocateFunc;
+    AllocateFunc = &CountingAllocate;
+    ReallocateFunc = &CountingReallocate;
+
+    for (auto frame = 0; frame < 1000; ++frame)
+    {
+        auto rows = MaxRows - ((frame * 37) % MaxRows);
+        platform.RunFrame([rows] { BuildFrame(rows); });
+
+        if (HeapAllocations != 0)
+        {
+            std::fprintf(stderr, "FAILED: frame %d with %d rows made %d heap allocation(s)\n",
+                frame, (int)rows, (int)HeapAllocations);
+            return 1;
+        }
+    }
+
+    AllocateFunc = DefaultAllocate;
+    ReallocateFunc = DefaultReallocate;
+    std::printf("PASSED: no heap allocations in 1000 frames after warm-up (arena peak: %zu bytes)\n",
+        FrameMemory.peakBytes);
+    return 0;
+}